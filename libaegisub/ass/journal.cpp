@@ -0,0 +1,156 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <libaegisub/ass/journal.h>
+
+#include <libaegisub/line_iterator.h>
+#include <libaegisub/log.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <sstream>
+
+namespace {
+const char journal_header[] = "Aegisub Autosave Journal";
+}
+
+namespace agi { namespace ass {
+
+std::string JournalHeader(std::vector<int> const& ids) {
+	std::string header = journal_header;
+	header += "\nI";
+	for (int id : ids) {
+		header += ' ';
+		header += std::to_string(id);
+	}
+	header += '\n';
+	return header;
+}
+
+void JournalAddLine(std::string& out, int id, int after, std::string const& data) {
+	out += "L ";
+	out += std::to_string(id);
+	out += ' ';
+	out += std::to_string(after);
+	out += ' ';
+	out += data;
+	out += '\n';
+}
+
+void JournalRemoveLine(std::string& out, int id) {
+	out += "D ";
+	out += std::to_string(id);
+	out += '\n';
+}
+
+void JournalSection(std::string& out, std::string const& name, std::vector<std::string> const& lines) {
+	out += "S ";
+	out += name;
+	out += '\n';
+	for (auto const& line : lines) {
+		out += "R ";
+		out += line;
+		out += '\n';
+	}
+}
+
+void JournalEndCommit(std::string& out) {
+	out += "E\n";
+}
+
+bool ReadJournal(std::istream& stream, std::vector<int>& ids, std::vector<JournalCommit>& commits) {
+	agi::line_iterator<std::string> it(stream, "utf-8"), end;
+	if (it == end || *it != journal_header)
+		return false;
+
+	if (++it == end || !boost::starts_with(*it, "I"))
+		return false;
+	{
+		std::istringstream fields((*it).substr(1));
+		int id;
+		while (fields >> id)
+			ids.push_back(id);
+		if (!fields.eof())
+			return false;
+	}
+
+	JournalCommit pending;
+	for (++it; it != end; ++it) {
+		auto const& record = *it;
+		if (record == "E") {
+			commits.push_back(std::move(pending));
+			pending.clear();
+			continue;
+		}
+
+		JournalRecord r{JournalRecord::Type::Line, 0, 0, ""};
+		bool in_section = !pending.empty() && pending.back().type != JournalRecord::Type::Line
+			&& pending.back().type != JournalRecord::Type::Remove;
+		bool valid = false;
+		if (boost::starts_with(record, "S ")) {
+			r.type = JournalRecord::Type::Section;
+			r.data = record.substr(2);
+			valid = !r.data.empty();
+		}
+		else if (boost::starts_with(record, "R ")) {
+			r.type = JournalRecord::Type::SectionLine;
+			r.data = record.substr(2);
+			valid = in_section;
+		}
+		else {
+			std::istringstream fields(record);
+			char type = 0;
+			fields >> type >> r.id;
+			if (type == 'L' && fields >> r.after && fields.get() == ' ') {
+				std::getline(fields, r.data);
+				valid = true;
+			}
+			else if (type == 'D' && fields) {
+				r.type = JournalRecord::Type::Remove;
+				valid = true;
+			}
+		}
+
+		if (!valid) {
+			LOG_E("agi/ass/journal") << "Stopped reading at malformed record: " << record;
+			break;
+		}
+		pending.push_back(std::move(r));
+	}
+
+	if (!pending.empty())
+		LOG_E("agi/ass/journal") << "Discarded an incomplete commit of " << pending.size() << " records";
+	return true;
+}
+
+bool CheckJournalCommit(std::unordered_set<int>& ids, JournalCommit const& commit) {
+	auto after = ids;
+	for (auto const& r : commit) {
+		if (r.type == JournalRecord::Type::Section || r.type == JournalRecord::Type::SectionLine)
+			continue;
+
+		// Changed lines are removed and then inserted again, so a line can't
+		// be placed after itself
+		after.erase(r.id);
+		if (r.type == JournalRecord::Type::Remove) continue;
+		if (r.after != 0 && !after.count(r.after))
+			return false;
+		after.insert(r.id);
+	}
+	ids.swap(after);
+	return true;
+}
+
+} }
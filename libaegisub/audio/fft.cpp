@@ -0,0 +1,470 @@
+// Copyright (c) 2005, Rodrigo Braz Monteiro
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//   * Neither the name of the Aegisub Group nor the names of its contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file fft.cpp
+/// @brief Fast Fourier-transform implementation
+/// @ingroup utility
+///
+/// Most of this code was taken from http://www.codeproject.com/audio/waveInFFT.asp
+/// And rewriten by Rodrigo Braz Monteiro
+
+#include "libaegisub/audio/fft.h"
+
+#include "libaegisub/cpu.h"
+#include "libaegisub/exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef AGI_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+const float sqrt2 = 1.41421356f;
+const float ln2 = 0.693147181f;
+const float log10_e = 0.434294482f;
+
+/// @brief log10(x) for x >= 1
+///
+/// Splits x into 2^e * m with m in [sqrt(1/2), sqrt(2)) and evaluates ln(m)
+/// with the atanh series, which converges quickly on that interval. The
+/// vector versions below use exactly the same steps.
+inline float fast_log10(float x) {
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof bits);
+	int e = (int)(bits >> 23) - 127;
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	float m;
+	memcpy(&m, &bits, sizeof m);
+	if (m > sqrt2) {
+		m *= 0.5f;
+		++e;
+	}
+	float s = (m - 1.f) / (m + 1.f);
+	float s2 = s * s;
+	float ln_m = 2.f * s * (1.f + s2 * (1.f/3 + s2 * (1.f/5 + s2 * (1.f/7 + s2 * (1.f/9)))));
+	return (e * ln2 + ln_m) * log10_e;
+}
+
+void butterflies_scalar(float *re, float *im, size_t n, size_t half, const float *wr, const float *wi) {
+	for (size_t i = 0; i < n; i += 2 * half) {
+		for (size_t k = 0; k < half; ++k) {
+			size_t j = i + k, l = j + half;
+			float tr = wr[k] * re[l] - wi[k] * im[l];
+			float ti = wr[k] * im[l] + wi[k] * re[l];
+			re[l] = re[j] - tr;
+			im[l] = im[j] - ti;
+			re[j] += tr;
+			im[j] += ti;
+		}
+	}
+}
+
+/// Turn the half-size complex transform z into bins [begin, end) of the real transform
+void split_scalar(const float *zr, const float *zi, size_t m, const float *wr, const float *wi, float *out_r, float *out_i, size_t begin, size_t end) {
+	for (size_t k = begin; k < end; ++k) {
+		size_t mk = (m - k) & (m - 1);
+		// Even and odd samples' spectra are (z[k] + z*[m-k]) / 2 and (z[k] - z*[m-k]) / 2i
+		float er = .5f * (zr[k] + zr[mk]), ei = .5f * (zi[k] - zi[mk]);
+		float or_ = .5f * (zi[k] + zi[mk]), oi = -.5f * (zr[k] - zr[mk]);
+		out_r[k] = er + wr[k] * or_ - wi[k] * oi;
+		out_i[k] = ei + wr[k] * oi + wi[k] * or_;
+	}
+}
+
+void power_scalar(const float *re, const float *im, size_t begin, size_t count, float scale, float *out) {
+	for (size_t i = begin; i < count; ++i)
+		out[i] = fast_log10(std::sqrt(re[i] * re[i] + im[i] * im[i]) * scale + 1.f);
+}
+
+#ifdef AGI_X86
+AGI_TARGET("sse2")
+void butterflies_sse2(float *re, float *im, size_t n, size_t half, const float *wr, const float *wi) {
+	for (size_t i = 0; i < n; i += 2 * half) {
+		for (size_t k = 0; k < half; k += 4) {
+			float *rj = re + i + k, *ij = im + i + k, *rl = rj + half, *il = ij + half;
+			__m128 w_r = _mm_loadu_ps(wr + k), w_i = _mm_loadu_ps(wi + k);
+			__m128 xr = _mm_loadu_ps(rl), xi = _mm_loadu_ps(il);
+			__m128 tr = _mm_sub_ps(_mm_mul_ps(w_r, xr), _mm_mul_ps(w_i, xi));
+			__m128 ti = _mm_add_ps(_mm_mul_ps(w_r, xi), _mm_mul_ps(w_i, xr));
+			__m128 ar = _mm_loadu_ps(rj), ai = _mm_loadu_ps(ij);
+			_mm_storeu_ps(rl, _mm_sub_ps(ar, tr));
+			_mm_storeu_ps(il, _mm_sub_ps(ai, ti));
+			_mm_storeu_ps(rj, _mm_add_ps(ar, tr));
+			_mm_storeu_ps(ij, _mm_add_ps(ai, ti));
+		}
+	}
+}
+
+AGI_TARGET("sse2")
+size_t split_sse2(const float *zr, const float *zi, size_t m, const float *wr, const float *wi, float *out_r, float *out_i, size_t k) {
+	const __m128 half = _mm_set1_ps(.5f);
+	for (; k + 4 <= m; k += 4) {
+		// z[m-k-3..m-k] reversed, so that lane i holds z[m-k-i]
+		__m128 br = _mm_loadu_ps(zr + m - k - 3), bi = _mm_loadu_ps(zi + m - k - 3);
+		br = _mm_shuffle_ps(br, br, _MM_SHUFFLE(0, 1, 2, 3));
+		bi = _mm_shuffle_ps(bi, bi, _MM_SHUFFLE(0, 1, 2, 3));
+		__m128 ar = _mm_loadu_ps(zr + k), ai = _mm_loadu_ps(zi + k);
+
+		__m128 er = _mm_mul_ps(half, _mm_add_ps(ar, br));
+		__m128 ei = _mm_mul_ps(half, _mm_sub_ps(ai, bi));
+		__m128 or_ = _mm_mul_ps(half, _mm_add_ps(ai, bi));
+		__m128 oi = _mm_mul_ps(half, _mm_sub_ps(br, ar));
+
+		__m128 w_r = _mm_loadu_ps(wr + k), w_i = _mm_loadu_ps(wi + k);
+		_mm_storeu_ps(out_r + k, _mm_add_ps(er, _mm_sub_ps(_mm_mul_ps(w_r, or_), _mm_mul_ps(w_i, oi))));
+		_mm_storeu_ps(out_i + k, _mm_add_ps(ei, _mm_add_ps(_mm_mul_ps(w_r, oi), _mm_mul_ps(w_i, or_))));
+	}
+	return k;
+}
+
+AGI_TARGET("sse2")
+size_t power_sse2(const float *re, const float *im, size_t count, float scale, float *out) {
+	const __m128 vscale = _mm_set1_ps(scale), one = _mm_set1_ps(1.f), half = _mm_set1_ps(.5f);
+	const __m128 vsqrt2 = _mm_set1_ps(sqrt2), vln2 = _mm_set1_ps(ln2), vlog10_e = _mm_set1_ps(log10_e);
+	const __m128i mantissa_mask = _mm_set1_epi32(0x007fffff), exponent_one = _mm_set1_epi32(0x3f800000), bias = _mm_set1_epi32(127);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 r = _mm_loadu_ps(re + i), m = _mm_loadu_ps(im + i);
+		__m128 y = _mm_add_ps(_mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m))), vscale), one);
+
+		__m128i bits = _mm_castps_si128(y);
+		__m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), bias);
+		__m128 mant = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissa_mask), exponent_one));
+		__m128 big = _mm_cmpgt_ps(mant, vsqrt2);
+		mant = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(mant, half)), _mm_andnot_ps(big, mant));
+		e = _mm_sub_epi32(e, _mm_castps_si128(big));
+
+		__m128 s = _mm_div_ps(_mm_sub_ps(mant, one), _mm_add_ps(mant, one));
+		__m128 s2 = _mm_mul_ps(s, s);
+		__m128 poly = _mm_set1_ps(1.f/9);
+		poly = _mm_add_ps(_mm_mul_ps(poly, s2), _mm_set1_ps(1.f/7));
+		poly = _mm_add_ps(_mm_mul_ps(poly, s2), _mm_set1_ps(1.f/5));
+		poly = _mm_add_ps(_mm_mul_ps(poly, s2), _mm_set1_ps(1.f/3));
+		poly = _mm_add_ps(_mm_mul_ps(poly, s2), one);
+		__m128 ln_m = _mm_mul_ps(_mm_add_ps(s, s), poly);
+
+		__m128 ln = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(e), vln2), ln_m);
+		_mm_storeu_ps(out + i, _mm_mul_ps(ln, vlog10_e));
+	}
+	return i;
+}
+
+AGI_TARGET("avx2")
+void butterflies_avx2(float *re, float *im, size_t n, size_t half, const float *wr, const float *wi) {
+	for (size_t i = 0; i < n; i += 2 * half) {
+		for (size_t k = 0; k < half; k += 8) {
+			float *rj = re + i + k, *ij = im + i + k, *rl = rj + half, *il = ij + half;
+			__m256 w_r = _mm256_loadu_ps(wr + k), w_i = _mm256_loadu_ps(wi + k);
+			__m256 xr = _mm256_loadu_ps(rl), xi = _mm256_loadu_ps(il);
+			__m256 tr = _mm256_sub_ps(_mm256_mul_ps(w_r, xr), _mm256_mul_ps(w_i, xi));
+			__m256 ti = _mm256_add_ps(_mm256_mul_ps(w_r, xi), _mm256_mul_ps(w_i, xr));
+			__m256 ar = _mm256_loadu_ps(rj), ai = _mm256_loadu_ps(ij);
+			_mm256_storeu_ps(rl, _mm256_sub_ps(ar, tr));
+			_mm256_storeu_ps(il, _mm256_sub_ps(ai, ti));
+			_mm256_storeu_ps(rj, _mm256_add_ps(ar, tr));
+			_mm256_storeu_ps(ij, _mm256_add_ps(ai, ti));
+		}
+	}
+}
+
+AGI_TARGET("avx2")
+size_t split_avx2(const float *zr, const float *zi, size_t m, const float *wr, const float *wi, float *out_r, float *out_i, size_t k) {
+	const __m256 half = _mm256_set1_ps(.5f);
+	const __m256i reversed = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	for (; k + 8 <= m; k += 8) {
+		__m256 br = _mm256_permutevar8x32_ps(_mm256_loadu_ps(zr + m - k - 7), reversed);
+		__m256 bi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(zi + m - k - 7), reversed);
+		__m256 ar = _mm256_loadu_ps(zr + k), ai = _mm256_loadu_ps(zi + k);
+
+		__m256 er = _mm256_mul_ps(half, _mm256_add_ps(ar, br));
+		__m256 ei = _mm256_mul_ps(half, _mm256_sub_ps(ai, bi));
+		__m256 or_ = _mm256_mul_ps(half, _mm256_add_ps(ai, bi));
+		__m256 oi = _mm256_mul_ps(half, _mm256_sub_ps(br, ar));
+
+		__m256 w_r = _mm256_loadu_ps(wr + k), w_i = _mm256_loadu_ps(wi + k);
+		_mm256_storeu_ps(out_r + k, _mm256_add_ps(er, _mm256_sub_ps(_mm256_mul_ps(w_r, or_), _mm256_mul_ps(w_i, oi))));
+		_mm256_storeu_ps(out_i + k, _mm256_add_ps(ei, _mm256_add_ps(_mm256_mul_ps(w_r, oi), _mm256_mul_ps(w_i, or_))));
+	}
+	return k;
+}
+
+AGI_TARGET("avx2")
+size_t power_avx2(const float *re, const float *im, size_t count, float scale, float *out) {
+	const __m256 vscale = _mm256_set1_ps(scale), one = _mm256_set1_ps(1.f), half = _mm256_set1_ps(.5f);
+	const __m256 vsqrt2 = _mm256_set1_ps(sqrt2), vln2 = _mm256_set1_ps(ln2), vlog10_e = _mm256_set1_ps(log10_e);
+	const __m256i mantissa_mask = _mm256_set1_epi32(0x007fffff), exponent_one = _mm256_set1_epi32(0x3f800000), bias = _mm256_set1_epi32(127);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 r = _mm256_loadu_ps(re + i), m = _mm256_loadu_ps(im + i);
+		__m256 y = _mm256_add_ps(_mm256_mul_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(m, m))), vscale), one);
+
+		__m256i bits = _mm256_castps_si256(y);
+		__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), bias);
+		__m256 mant = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, mantissa_mask), exponent_one));
+		__m256 big = _mm256_cmp_ps(mant, vsqrt2, _CMP_GT_OQ);
+		mant = _mm256_blendv_ps(mant, _mm256_mul_ps(mant, half), big);
+		e = _mm256_sub_epi32(e, _mm256_castps_si256(big));
+
+		__m256 s = _mm256_div_ps(_mm256_sub_ps(mant, one), _mm256_add_ps(mant, one));
+		__m256 s2 = _mm256_mul_ps(s, s);
+		__m256 poly = _mm256_set1_ps(1.f/9);
+		poly = _mm256_add_ps(_mm256_mul_ps(poly, s2), _mm256_set1_ps(1.f/7));
+		poly = _mm256_add_ps(_mm256_mul_ps(poly, s2), _mm256_set1_ps(1.f/5));
+		poly = _mm256_add_ps(_mm256_mul_ps(poly, s2), _mm256_set1_ps(1.f/3));
+		poly = _mm256_add_ps(_mm256_mul_ps(poly, s2), one);
+		__m256 ln_m = _mm256_mul_ps(_mm256_add_ps(s, s), poly);
+
+		__m256 ln = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(e), vln2), ln_m);
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(ln, vlog10_e));
+	}
+	return i;
+}
+#endif
+}
+
+namespace agi {
+void FFT::DoTransform (size_t n_samples,float *input,float *output_r,float *output_i,bool inverse) {
+	if (!IsPowerOfTwo(n_samples))
+		throw agi::InternalError("FFT requires power of two input.");
+
+	// Inverse transform
+	float angle_num = 2.0f * 3.1415926535897932384626433832795f;
+	if (inverse) angle_num = -angle_num;
+
+	// Variables
+	unsigned int i, j, k, n;
+	float tr, ti;
+
+	// Calculate needed bits
+	unsigned int NumBits;
+	NumBits = NumberOfBitsNeeded(n_samples);
+
+	// Copy samples to output buffers
+	for (i=0;i<n_samples;i++) {
+		j = ReverseBits (i,NumBits);
+		output_r[j] = input[i];
+		output_i[j] = 0.0f;
+	}
+
+	unsigned int BlockEnd = 1;
+	unsigned int BlockSize;
+	for (BlockSize = 2;BlockSize<=n_samples;BlockSize<<=1) {
+		// Calculate variables for this iteration
+		float delta_angle = angle_num / (float)BlockSize;
+		float sm2 = sin (-2 * delta_angle);
+		float sm1 = sin (-delta_angle);
+		float cm2 = cos (-2 * delta_angle);
+		float cm1 = cos (-delta_angle);
+		float w = 2 * cm1;
+		float ar0, ar1, ar2, ai0, ai1, ai2;
+
+		// Apply for every sample
+		for(i=0;i<n_samples;i+=BlockSize) {
+			ar1 = cm1;
+			ar2 = cm2;
+			ai1 = sm1;
+			ai2 = sm2;
+
+			for (j=i,n=0;n<BlockEnd;j++,n++) {
+				k = j + BlockEnd;
+
+				ar0 = w*ar1 - ar2;
+				ai0 = w*ai1 - ai2;
+				ar2 = ar1;
+				ai2 = ai1;
+				ar1 = ar0;
+				ai1 = ai0;
+
+				tr = ar0*output_r[k] - ai0*output_i[k];
+				ti = ar0*output_i[k] + ai0*output_r[k];
+
+				output_r[k] = output_r[j] - tr;
+				output_i[k] = output_i[j] - ti;
+
+				output_r[j] += tr;
+				output_i[j] += ti;
+			}
+		}
+
+		// Set next block end to current size
+		BlockEnd = BlockSize;
+	}
+
+	// Divide everything by number of samples if it's an inverse transform
+	if (inverse) {
+		float denom = 1.0f/(float)n_samples;
+		for (i=0;i<n_samples;i++) {
+			output_r[i] *= denom;
+			output_i[i] *= denom;
+		}
+	}
+}
+
+void FFT::Transform(size_t n_samples,float *input,float *output_r,float *output_i) {
+	DoTransform(n_samples,input,output_r,output_i,false);
+}
+
+void FFT::InverseTransform(size_t n_samples,float *input,float *output_r,float *output_i) {
+	DoTransform(n_samples,input,output_r,output_i,true);
+}
+
+/// @brief Checks if number is a power of two
+bool FFT::IsPowerOfTwo (unsigned int x) {
+	if (x < 2) return false;
+	if (x & (x-1)) return false;
+    return true;
+}
+
+/// @brief Bits needed by the FFT
+unsigned int FFT::NumberOfBitsNeeded (unsigned int n_samples) {
+	int i;
+
+	if (n_samples < 2) {
+		return 0;
+	}
+
+	for (i=0; ;i++) {
+		if(n_samples & (1 << i)) return i;
+    }
+}
+
+/// @brief Get reversed bit position
+unsigned int FFT::ReverseBits (unsigned int index, unsigned int bits) {
+	unsigned int i, rev;
+
+	for(i=rev=0;i<bits;i++) {
+		rev = (rev << 1) | (index & 1);
+		index >>= 1;
+	}
+
+	return rev;
+}
+
+/// @brief Get frequency at index
+float FFT::FrequencyAtIndex (unsigned int baseFreq, unsigned int n_samples, unsigned int index) {
+	if (index >= n_samples) return 0.0;
+	else if (index <= n_samples/2) {
+		return ((float)index / (float)n_samples * baseFreq);
+	}
+	else {
+		return (-(float)(n_samples-index) / (float)n_samples * baseFreq);
+	}
+}
+
+RealFFT::RealFFT(size_t size, InstructionSet max_isa)
+: size(size)
+, isa(std::min(max_isa, agi::BestInstructionSet()))
+{
+	if (size < 2 || (size & (size - 1)))
+		throw agi::InternalError("FFT requires power of two input.");
+
+	const size_t m = size / 2;
+	const double pi = 3.1415926535897932384626433832795;
+
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < m) ++bits;
+	reverse.resize(m);
+	for (size_t i = 0; i < m; ++i) {
+		uint32_t rev = 0;
+		for (unsigned int b = 0; b < bits; ++b)
+			rev |= ((i >> b) & 1) << (bits - 1 - b);
+		reverse[i] = rev;
+	}
+
+	twiddle_r.resize(m > 1 ? m - 1 : 1);
+	twiddle_i.resize(twiddle_r.size());
+	for (size_t half = 1; half < m; half *= 2) {
+		for (size_t k = 0; k < half; ++k) {
+			twiddle_r[half - 1 + k] = (float)cos(pi * k / half);
+			twiddle_i[half - 1 + k] = (float)-sin(pi * k / half);
+		}
+	}
+
+	split_r.resize(m);
+	split_i.resize(m);
+	for (size_t k = 0; k < m; ++k) {
+		split_r[k] = (float)cos(2 * pi * k / size);
+		split_i[k] = (float)-sin(2 * pi * k / size);
+	}
+
+	work_r.resize(m);
+	work_i.resize(m);
+}
+
+void RealFFT::Transform(const float *input, float *output_r, float *output_i) {
+	const size_t m = size / 2;
+	float *re = &work_r[0], *im = &work_i[0];
+
+	// Treat the even and odd samples as the real and imaginary parts of a
+	// complex signal of half the length
+	for (size_t i = 0; i < m; ++i) {
+		re[reverse[i]] = input[2 * i];
+		im[reverse[i]] = input[2 * i + 1];
+	}
+
+	for (size_t half = 1; half < m; half *= 2) {
+		const float *wr = &twiddle_r[half - 1], *wi = &twiddle_i[half - 1];
+#ifdef AGI_X86
+		if (isa == InstructionSet::AVX2 && half >= 8)
+			butterflies_avx2(re, im, m, half, wr, wi);
+		else if (isa != InstructionSet::Scalar && half >= 4)
+			butterflies_sse2(re, im, m, half, wr, wi);
+		else
+#endif
+			butterflies_scalar(re, im, m, half, wr, wi);
+	}
+
+	split_scalar(re, im, m, &split_r[0], &split_i[0], output_r, output_i, 0, 1);
+	size_t k = 1;
+#ifdef AGI_X86
+	if (isa == InstructionSet::AVX2)
+		k = split_avx2(re, im, m, &split_r[0], &split_i[0], output_r, output_i, k);
+	if (isa != InstructionSet::Scalar)
+		k = split_sse2(re, im, m, &split_r[0], &split_i[0], output_r, output_i, k);
+#endif
+	split_scalar(re, im, m, &split_r[0], &split_i[0], output_r, output_i, k, m);
+}
+
+void RealFFT::Power(const float *real, const float *imag, float scale, float *output) const {
+	const size_t count = size / 2;
+	size_t i = 0;
+#ifdef AGI_X86
+	if (isa == InstructionSet::AVX2)
+		i = power_avx2(real, imag, count, scale, output);
+	else if (isa == InstructionSet::SSE2)
+		i = power_sse2(real, imag, count, scale, output);
+#endif
+	power_scalar(real, imag, i, count, scale, output);
+}
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/peaks.h"
+
+#include "libaegisub/exception.h"
+#include "libaegisub/file_mapping.h"
+#include "libaegisub/fs.h"
+#include "libaegisub/io.h"
+#include "libaegisub/log.h"
+#include "libaegisub/make_unique.h"
+
+#include <algorithm>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+
+namespace {
+const agi::AudioPeaks::Peak empty_peak = {0, 0, 0, 0};
+
+/// Header of a peak cache file
+struct file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t level_count;
+	int64_t num_samples;
+};
+
+const char peak_file_magic[8] = {'A', 'G', 'I', 'P', 'E', 'A', 'K', 'S'};
+/// Bump whenever the layout of the file or the meaning of the blocks changes
+const uint32_t peak_file_version = 1;
+
+static_assert(sizeof(agi::AudioPeaks::Peak) == 12, "Peak must not have padding as it is written to disk directly");
+
+void merge(agi::AudioPeaks::Peak &dst, agi::AudioPeaks::Peak const& src) {
+	dst.min = std::min(dst.min, src.min);
+	dst.max = std::max(dst.max, src.max);
+	dst.neg_sum += src.neg_sum;
+	dst.pos_sum += src.pos_sum;
+}
+}
+
+namespace agi {
+AudioPeaks::AudioPeaks(int64_t num_samples)
+: num_samples(num_samples)
+{
+	for (int i = 0; i < level_count; ++i) {
+		levels[i].resize((num_samples + BlockSize(i) - 1) / BlockSize(i));
+		partial[i] = empty_peak;
+	}
+}
+
+void AudioPeaks::Push(int level) {
+	const size_t index = written / BlockSize(level) - (written % BlockSize(level) == 0);
+	levels[level][index] = partial[level];
+	if (level + 1 < level_count)
+		merge(partial[level + 1], partial[level]);
+	partial[level] = empty_peak;
+}
+
+void AudioPeaks::Append(const int16_t *samples, int64_t count) {
+	count = std::min(count, num_samples - written);
+	if (count <= 0) return;
+
+	const int64_t block = BlockSize(0);
+	while (count > 0) {
+		// Accumulate up to the end of the current finest block
+		auto run = std::min(count, block - written % block);
+		Peak &p = partial[0];
+		for (auto end = samples + run; samples != end; ++samples) {
+			if (*samples > 0) {
+				p.max = std::max(p.max, *samples);
+				p.pos_sum += *samples;
+			}
+			else {
+				p.min = std::min(p.min, *samples);
+				p.neg_sum += *samples;
+			}
+		}
+		written += run;
+		count -= run;
+
+		// Propagate every block which this run completed
+		const bool done = written == num_samples;
+		for (int level = 0; level < level_count; ++level) {
+			if (written % BlockSize(level) != 0 && !done) break;
+			Push(level);
+		}
+	}
+
+	available = written - (written == num_samples ? 0 : written % block);
+}
+
+void AudioPeaks::Save(fs::path const& filename) const {
+	if (available != num_samples)
+		throw InternalError("Tried to save an incomplete audio peak summary");
+
+	file_header header;
+	std::copy(std::begin(peak_file_magic), std::end(peak_file_magic), header.magic);
+	header.version = peak_file_version;
+	header.level_count = level_count;
+	header.num_samples = num_samples;
+
+	try {
+		io::Save file(filename, true);
+		auto& out = file.Get();
+		out.write(reinterpret_cast<const char *>(&header), sizeof header);
+		for (auto const& level : levels)
+			out.write(reinterpret_cast<const char *>(level.data()), level.size() * sizeof(Peak));
+	}
+	catch (agi::Exception const& e) {
+		LOG_E("audio/peaks") << "Failed to save peak cache: " << e.GetMessage();
+	}
+}
+
+std::unique_ptr<AudioPeaks> AudioPeaks::Load(fs::path const& filename, int64_t num_samples) {
+	if (!fs::FileExists(filename)) return nullptr;
+
+	try {
+		read_file_mapping file(filename);
+		if (file.size() < sizeof(file_header)) return nullptr;
+
+		file_header header;
+		memcpy(&header, file.read(0, sizeof header), sizeof header);
+		if (!std::equal(std::begin(peak_file_magic), std::end(peak_file_magic), header.magic)
+			|| header.version != peak_file_version
+			|| header.level_count != level_count
+			|| header.num_samples != num_samples)
+		{
+			LOG_D("audio/peaks") << "Ignoring outdated peak cache " << filename;
+			return nullptr;
+		}
+
+		auto peaks = agi::make_unique<AudioPeaks>(num_samples);
+		uint64_t expected_size = sizeof header;
+		for (auto const& level : peaks->levels)
+			expected_size += level.size() * sizeof(Peak);
+		if (file.size() != expected_size) return nullptr;
+
+		uint64_t offset = sizeof header;
+		for (auto& level : peaks->levels) {
+			auto bytes = level.size() * sizeof(Peak);
+			if (bytes)
+				memcpy(level.data(), file.read(offset, bytes), bytes);
+			offset += bytes;
+		}
+
+		peaks->written = num_samples;
+		peaks->available = num_samples;
+		return peaks;
+	}
+	catch (agi::Exception const& e) {
+		LOG_E("audio/peaks") << "Failed to load peak cache: " << e.GetMessage();
+	}
+	catch (std::exception const& e) {
+		LOG_E("audio/peaks") << "Failed to load peak cache: " << e.what();
+	}
+	return nullptr;
+}
+
+int AudioPeaks::LevelFor(double samples) {
+	for (int level = level_count - 1; level >= 0; --level) {
+		if (BlockSize(level) <= samples)
+			return level;
+	}
+	return -1;
+}
+
+bool AudioPeaks::Get(int level, int64_t start, int64_t end, Range &out) const {
+	const int64_t block = BlockSize(level);
+	const int64_t avail = available;
+
+	start = std::max<int64_t>(start, 0);
+	end = std::min(end, num_samples);
+	auto first = (start + block - 1) / block;
+	auto last = (end + block - 1) / block;
+	if (last <= first) {
+		// Range doesn't contain the start of any block, so fall back to the
+		// block containing the range
+		first = start / block;
+		last = first + 1;
+	}
+
+	const int64_t complete = avail == num_samples ? (int64_t)levels[level].size() : avail / block;
+	if (last > complete || first >= (int64_t)levels[level].size()) return false;
+
+	out = Range();
+	for (auto i = first; i < last; ++i) {
+		auto const& p = levels[level][i];
+		out.min = std::min<int>(out.min, p.min);
+		out.max = std::max<int>(out.max, p.max);
+		out.neg_sum += p.neg_sum;
+		out.pos_sum += p.pos_sum;
+	}
+	out.samples = std::min(last * block, num_samples) - first * block;
+	return true;
+}
+}
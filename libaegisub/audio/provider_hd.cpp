@@ -16,6 +16,7 @@
 
 #include "libaegisub/audio/provider.h"
 
+#include <libaegisub/audio/peaks.h>
 #include <libaegisub/file_mapping.h>
 #include <libaegisub/format.h>
 #include <libaegisub/fs.h>
@@ -32,6 +33,9 @@ using namespace agi;
 
 class HDAudioProvider final : public AudioProviderWrapper {
 	mutable temp_file_mapping file;
+	std::unique_ptr<AudioPeaks> peaks;
+	/// File to save the peaks to once decoding finishes, if any
+	fs::path peak_file;
 	std::atomic<bool> cancelled = {false};
 	std::thread decoder;
 
@@ -59,22 +63,40 @@ class HDAudioProvider final : public AudioProviderWrapper {
 	}
 
 public:
-	HDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir)
+	HDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir, agi::fs::path const& peak_filename)
 	: AudioProviderWrapper(std::move(src))
 	, file(dir / CacheFilename(dir), num_samples * bytes_per_sample)
+	, peak_file(peak_filename)
 	{
 		decoded_samples = 0;
+		if (bytes_per_sample == 2 && channels == 1 && !float_samples) {
+			if (!peak_file.empty())
+				peaks = AudioPeaks::Load(peak_file, num_samples);
+			if (peaks)
+				peak_file.clear();
+			else
+				peaks = agi::make_unique<AudioPeaks>(num_samples);
+		}
+
 		decoder = std::thread([&] {
 			int64_t block = 65536;
 			for (int64_t i = 0; i < num_samples; i += block) {
 				if (cancelled) break;
 				block = std::min(block, num_samples - i);
-				source->GetAudio(file.write(i * bytes_per_sample, block * bytes_per_sample), i, block);
+				auto buf = file.write(i * bytes_per_sample, block * bytes_per_sample);
+				source->GetAudio(buf, i, block);
+				if (peaks)
+					peaks->Append(reinterpret_cast<int16_t *>(buf), block);
 				decoded_samples += block;
 			}
+
+			if (peaks && !peak_file.empty() && peaks->GetAvailableSamples() == num_samples)
+				peaks->Save(peak_file);
 		});
 	}
 
+	AudioPeaks const* GetPeaks() const override { return peaks.get(); }
+
 	~HDAudioProvider() {
 		cancelled = true;
 		decoder.join();
@@ -83,7 +105,7 @@ public:
 }
 
 namespace agi {
-std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir) {
-	return agi::make_unique<HDAudioProvider>(std::move(src), dir);
+std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir, agi::fs::path const& peak_file) {
+	return agi::make_unique<HDAudioProvider>(std::move(src), dir, peak_file);
 }
 }
@@ -16,6 +16,8 @@
 
 #include "libaegisub/audio/provider.h"
 
+#include "libaegisub/audio/peaks.h"
+#include "libaegisub/fs.h"
 #include "libaegisub/make_unique.h"
 
 #include <array>
@@ -34,14 +36,18 @@ class RAMAudioProvider final : public AudioProviderWrapper {
 #else
 	boost::container::stable_vector<std::array<char, CacheBlockSize>> blockcache;
 #endif
+	std::unique_ptr<AudioPeaks> peaks;
+	/// File to save the peaks to once decoding finishes, if any
+	fs::path peak_file;
 	std::atomic<bool> cancelled = {false};
 	std::thread decoder;
 
 	void FillBuffer(void *buf, int64_t start, int64_t count) const override;
 
 public:
-	RAMAudioProvider(std::unique_ptr<AudioProvider> src)
+	RAMAudioProvider(std::unique_ptr<AudioProvider> src, fs::path const& peak_filename)
 	: AudioProviderWrapper(std::move(src))
+	, peak_file(peak_filename)
 	{
 		decoded_samples = 0;
 
@@ -52,17 +58,33 @@ public:
 			throw AudioProviderError("Not enough memory available to cache in RAM");
 		}
 
+		if (bytes_per_sample == 2 && channels == 1 && !float_samples) {
+			if (!peak_file.empty())
+				peaks = AudioPeaks::Load(peak_file, num_samples);
+			if (peaks)
+				peak_file.clear();
+			else
+				peaks = agi::make_unique<AudioPeaks>(num_samples);
+		}
+
 		decoder = std::thread([&] {
 			int64_t readsize = CacheBlockSize / source->GetBytesPerSample();
 			for (size_t i = 0; i < blockcache.size(); i++) {
 				if (cancelled) break;
 				auto actual_read = std::min<int64_t>(readsize, num_samples - i * readsize);
 				source->GetAudio(&blockcache[i][0], i * readsize, actual_read);
+				if (peaks)
+					peaks->Append(reinterpret_cast<int16_t *>(&blockcache[i][0]), actual_read);
 				decoded_samples += actual_read;
 			}
+
+			if (peaks && !peak_file.empty() && peaks->GetAvailableSamples() == num_samples)
+				peaks->Save(peak_file);
 		});
 	}
 
+	AudioPeaks const* GetPeaks() const override { return peaks.get(); }
+
 	~RAMAudioProvider() {
 		cancelled = true;
 		decoder.join();
@@ -90,7 +112,7 @@ void RAMAudioProvider::FillBuffer(void *buf, int64_t start, int64_t count) const
 }
 
 namespace agi {
-std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> src) {
-	return agi::make_unique<RAMAudioProvider>(std::move(src));
+std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> src, fs::path const& peak_file) {
+	return agi::make_unique<RAMAudioProvider>(std::move(src), peak_file);
 }
 }
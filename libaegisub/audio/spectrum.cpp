@@ -0,0 +1,135 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/spectrum.h"
+
+#include "libaegisub/audio/provider.h"
+#include "libaegisub/make_unique.h"
+
+#ifdef WITH_FFTW3
+#include <fftw3.h>
+#include <mutex>
+#else
+#include "libaegisub/audio/fft.h"
+#endif
+
+#include <cmath>
+#include <vector>
+
+namespace {
+#ifdef WITH_FFTW3
+/// Everything in FFTW other than fftw_execute is not thread-safe
+std::mutex fftw_planner_mutex;
+#endif
+
+template<class T>
+void convert_to_float(std::vector<int16_t> const& src, T *dest) {
+	for (size_t si = 0; si < src.size(); ++si)
+		dest[si] = (T)(src[si]) / 32768.0;
+}
+}
+
+namespace agi {
+struct AudioSpectrumCalculator::Impl {
+	/// Pre-allocated scratch area for storing raw audio data
+	std::vector<int16_t> audio_scratch;
+
+#ifdef WITH_FFTW3
+	/// FFTW plan data
+	fftw_plan dft_plan = nullptr;
+	/// Pre-allocated input array for FFTW
+	double *dft_input = nullptr;
+	/// Pre-allocated output array for FFTW
+	fftw_complex *dft_output = nullptr;
+
+	Impl(size_t derivation_size)
+	: audio_scratch(2 << derivation_size)
+	{
+		std::lock_guard<std::mutex> lock(fftw_planner_mutex);
+		dft_input = fftw_alloc_real(2<<derivation_size);
+		dft_output = fftw_alloc_complex(2<<derivation_size);
+		dft_plan = fftw_plan_dft_r2c_1d(
+			2<<derivation_size,
+			dft_input,
+			dft_output,
+			FFTW_MEASURE);
+	}
+
+	~Impl() {
+		std::lock_guard<std::mutex> lock(fftw_planner_mutex);
+		fftw_destroy_plan(dft_plan);
+		fftw_free(dft_input);
+		fftw_free(dft_output);
+	}
+#else
+	/// Transform with tables for this derivation size
+	RealFFT fft;
+	/// Pre-allocated scratch area for doing FFT derivations
+	std::vector<float> fft_scratch;
+
+	Impl(size_t derivation_size)
+	: audio_scratch(2 << derivation_size)
+	, fft(2 << derivation_size)
+	// Allocate scratch for 4x the derivation size:
+	// 2x for the input sample data
+	// 1x for the real part of the output
+	// 1x for the imaginary part of the output
+	, fft_scratch(4 << derivation_size)
+	{
+	}
+#endif
+};
+
+AudioSpectrumCalculator::AudioSpectrumCalculator(size_t derivation_size)
+: impl(agi::make_unique<Impl>(derivation_size))
+, derivation_size(derivation_size)
+{
+}
+
+AudioSpectrumCalculator::~AudioSpectrumCalculator() { }
+
+void AudioSpectrumCalculator::Calculate(AudioProvider const& provider, int64_t first_sample, float *block) {
+	provider.GetAudio(&impl->audio_scratch[0], first_sample, 2 << derivation_size);
+
+#ifdef WITH_FFTW3
+	convert_to_float(impl->audio_scratch, impl->dft_input);
+
+	fftw_execute(impl->dft_plan);
+
+	double scale_factor = 9 / sqrt(2 << (derivation_size + 1));
+
+	fftw_complex *o = impl->dft_output;
+	for (size_t si = (size_t)1<<derivation_size; si > 0; --si)
+	{
+		*block++ = log10( sqrt(o[0][0] * o[0][0] + o[0][1] * o[0][1]) * scale_factor + 1 );
+		o++;
+	}
+#else
+	convert_to_float(impl->audio_scratch, &impl->fft_scratch[0]);
+
+	float *fft_input = &impl->fft_scratch[0];
+	float *fft_real = &impl->fft_scratch[0] + (2 << derivation_size);
+	float *fft_imag = &impl->fft_scratch[0] + (3 << derivation_size);
+
+	impl->fft.Transform(fft_input, fft_real, fft_imag);
+
+	// With x in range [0;1], log10(x*9+1) will also be in range [0;1],
+	// although the FFT output can apparently get greater magnitudes than 1
+	// despite the input being limited to [-1;+1).
+	impl->fft.Power(fft_real, fft_imag, 9 / sqrt(2 * (float)(2<<derivation_size)), block);
+#endif
+}
+}
@@ -21,28 +21,188 @@
 #include "libaegisub/file_mapping.h"
 #include "libaegisub/scoped_ptr.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef AGI_X86
+#include <immintrin.h>
+#endif
+
 #ifdef WITH_UCHARDET
 #include <uchardet/uchardet.h>
 #endif
 
+namespace {
+/// Size of the blocks the file is checked in, and so how often the binary
+/// heuristic gets a chance to bail out
+const uint64_t block_size = 64 * 1024;
+/// Size of each window of a non-UTF-8 file given to uchardet
+const uint64_t sample_size = 16 * 1024;
+/// Number of windows to give uchardet for files which are larger than that
+const uint64_t max_samples = 16;
+
+bool is_control(unsigned char c) {
+	return c < 32 && c != '\r' && c != '\n' && c != '\t';
+}
+
+size_t count_control_scalar(const unsigned char *data, size_t len, size_t i) {
+	size_t count = 0;
+	for (; i < len; ++i)
+		count += is_control(data[i]);
+	return count;
+}
+
+#ifdef AGI_X86
+/// Count the control bytes in whole vectors starting at i, advancing i past them
+AGI_TARGET("sse2")
+size_t count_control_sse2(const unsigned char *data, size_t len, size_t& i) {
+	const __m128i max_control = _mm_set1_epi8(31);
+	const __m128i tab = _mm_set1_epi8('\t'), lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sums = zero;
+
+	while (i + 16 <= len) {
+		// Matches are -1, so subtracting them counts them per byte lane,
+		// which can be done 255 times before they have to be added up
+		__m128i counts = zero;
+		for (int n = 0; n < 255 && i + 16 <= len; ++n, i += 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, max_control), v);
+			__m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, lf)), _mm_cmpeq_epi8(v, cr));
+			counts = _mm_sub_epi8(counts, _mm_andnot_si128(space, control));
+		}
+		sums = _mm_add_epi64(sums, _mm_sad_epu8(counts, zero));
+	}
+
+	alignas(16) uint64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i *>(lanes), sums);
+	return (size_t)(lanes[0] + lanes[1]);
+}
+
+AGI_TARGET("avx2")
+size_t count_control_avx2(const unsigned char *data, size_t len, size_t& i) {
+	const __m256i max_control = _mm256_set1_epi8(31);
+	const __m256i tab = _mm256_set1_epi8('\t'), lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sums = zero;
+
+	while (i + 32 <= len) {
+		__m256i counts = zero;
+		for (int n = 0; n < 255 && i + 32 <= len; ++n, i += 32) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+			__m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(v, max_control), v);
+			__m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, lf)), _mm256_cmpeq_epi8(v, cr));
+			counts = _mm256_sub_epi8(counts, _mm256_andnot_si256(space, control));
+		}
+		sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counts, zero));
+	}
+
+	alignas(32) uint64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+	return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+/// Advance i past whole vectors of ASCII characters
+AGI_TARGET("sse2")
+size_t skip_ascii_sse2(const unsigned char *data, size_t len, size_t i) {
+	for (; i + 16 <= len; i += 16) {
+		if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))))
+			break;
+	}
+	return i;
+}
+
+AGI_TARGET("avx2")
+size_t skip_ascii_avx2(const unsigned char *data, size_t len, size_t i) {
+	for (; i + 32 <= len; i += 32) {
+		if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i))))
+			break;
+	}
+	return i;
+}
+#endif
+}
+
 namespace agi { namespace charset {
+size_t ValidUtf8Prefix(const char *buf, size_t len, InstructionSet max_isa) {
+	auto data = reinterpret_cast<const unsigned char *>(buf);
+	auto isa = std::min(max_isa, BestInstructionSet());
+
+	size_t i = 0;
+	while (i < len) {
+		// Subtitles are mostly ASCII even in languages which aren't, since
+		// the timestamps and override tags are, so skip over it a vector at
+		// a time and only check the multibyte sequences byte by byte
+		if (data[i] < 0x80) {
+#ifdef AGI_X86
+			if (isa == InstructionSet::AVX2)
+				i = skip_ascii_avx2(data, len, i);
+			else if (isa == InstructionSet::SSE2)
+				i = skip_ascii_sse2(data, len, i);
+#endif
+			while (i < len && data[i] < 0x80)
+				++i;
+			continue;
+		}
+
+		// Number of continuation bytes, and the valid range of the first one,
+		// which excludes overlong forms, surrogates and values over U+10FFFF
+		unsigned char c = data[i];
+		size_t n = 0;
+		unsigned char lo = 0x80, hi = 0xBF;
+		if (c >= 0xC2 && c <= 0xDF) n = 1;
+		else if (c == 0xE0) { n = 2; lo = 0xA0; }
+		else if (c == 0xED) { n = 2; hi = 0x9F; }
+		else if (c >= 0xE1 && c <= 0xEF) n = 2;
+		else if (c == 0xF0) { n = 3; lo = 0x90; }
+		else if (c == 0xF4) { n = 3; hi = 0x8F; }
+		else if (c >= 0xF1 && c <= 0xF3) n = 3;
+		else return i;
+
+		if (i + n >= len || data[i + 1] < lo || data[i + 1] > hi)
+			return i;
+		for (size_t j = 2; j <= n; ++j) {
+			if ((data[i + j] & 0xC0) != 0x80)
+				return i;
+		}
+		i += n + 1;
+	}
+	return len;
+}
+
+size_t CountControlBytes(const char *buf, size_t len, InstructionSet max_isa) {
+	auto data = reinterpret_cast<const unsigned char *>(buf);
+	auto isa = std::min(max_isa, BestInstructionSet());
+
+	size_t count = 0, i = 0;
+#ifdef AGI_X86
+	if (isa == InstructionSet::AVX2)
+		count += count_control_avx2(data, len, i);
+	if (isa != InstructionSet::Scalar)
+		count += count_control_sse2(data, len, i);
+#endif
+	return count + count_control_scalar(data, len, i);
+}
+
 std::string Detect(agi::fs::path const& file) {
 	agi::read_file_mapping fp(file);
 
 	// First check for known magic bytes which identify the file type
 	if (fp.size() >= 4) {
 		const char* header = fp.read(0, 4);
-		if (!strncmp(header, "\xef\xbb\xbf", 3))
+		if (!memcmp(header, "\xef\xbb\xbf", 3))
 			return "utf-8";
-		if (!strncmp(header, "\x00\x00\xfe\xff", 4))
+		if (!memcmp(header, "\x00\x00\xfe\xff", 4))
 			return "utf-32be";
-		if (!strncmp(header, "\xff\xfe\x00\x00", 4))
+		if (!memcmp(header, "\xff\xfe\x00\x00", 4))
 			return "utf-32le";
-		if (!strncmp(header, "\xfe\xff", 2))
+		if (!memcmp(header, "\xfe\xff", 2))
 			return "utf-16be";
-		if (!strncmp(header, "\xff\xfe", 2))
+		if (!memcmp(header, "\xff\xfe", 2))
 			return "utf-16le";
-		if (!strncmp(header, "\x1a\x45\xdf\xa3", 4))
+		if (!memcmp(header, "\x1a\x45\xdf\xa3", 4))
 			return "binary"; // Actually EBML/Matroska
 	}
 
@@ -51,38 +211,76 @@ std::string Detect(agi::fs::path const& file) {
 	if (fp.size() > 100 * 1024 * 1024)
 		return "binary";
 
+	// Most files are UTF-8, and checking that a file is valid UTF-8 is far
+	// faster than having uchardet guess, so try that first while also
+	// applying a dumb heuristic to detect binary files
 	uint64_t binaryish = 0;
+	uint64_t offset = 0;
+	// End of the bytes whose control bytes have been counted, as blocks
+	// overlap when a multibyte sequence is split between them
+	uint64_t counted = 0;
+	uint64_t invalid = 0;
+	while (offset < fp.size()) {
+		auto read = std::min<uint64_t>(block_size, fp.size() - offset);
+		auto buf = fp.read(offset, read);
+
+		binaryish += CountControlBytes(buf + (counted - offset), offset + read - counted);
+		counted = offset + read;
+		if (binaryish > counted / 8)
+			return "binary";
+
+		auto valid = ValidUtf8Prefix(buf, read);
+		if (valid == read)
+			offset += read;
+		else if (valid > 0 && read - valid < 4 && offset + read < fp.size())
+			offset += valid;
+		else {
+			invalid = offset + valid;
+			break;
+		}
+	}
+
+	if (offset == fp.size())
+		return "utf-8";
+
+	// uchardet only needs a representative sample of the text, so give it
+	// evenly spaced windows of large files rather than the entire thing, plus
+	// one at the first invalid byte in case that's the only non-ASCII text
+	std::vector<uint64_t> starts;
+	uint64_t stride = std::max(sample_size, fp.size() / max_samples);
+	for (uint64_t start = 0; start < fp.size(); start += stride)
+		starts.push_back(start);
+	starts.insert(std::upper_bound(starts.begin(), starts.end(), invalid), invalid);
 
 #ifdef WITH_UCHARDET
 	agi::scoped_holder<uchardet_t> ud(uchardet_new(), uchardet_delete);
-	for (uint64_t offset = 0; offset < fp.size(); ) {
-		auto read = std::min<uint64_t>(4096, fp.size() - offset);
-		auto buf = fp.read(offset, read);
+#endif
+	uint64_t checked = counted;
+	uint64_t end = 0;
+	for (auto start : starts) {
+		// Don't feed uchardet the same bytes twice if windows overlap
+		start = std::max(start, end);
+		if (start >= fp.size()) break;
+		auto read = std::min<uint64_t>(sample_size, fp.size() - start);
+		auto buf = fp.read(start, read);
+		end = start + read;
+#ifdef WITH_UCHARDET
 		uchardet_handle_data(ud, buf, read);
+#endif
 
-		offset += read;
-
-		// A dumb heuristic to detect binary files
-		for (size_t i = 0; i < read; ++i) {
-			if ((unsigned char)buf[i] < 32 && (buf[i] != '\r' && buf[i] != '\n' && buf[i] != '\t'))
-				++binaryish;
+		if (end > counted) {
+			auto skip = start < counted ? counted - start : 0;
+			binaryish += CountControlBytes(buf + skip, read - skip);
+			checked += read - skip;
+			if (binaryish > checked / 8)
+				return "binary";
 		}
-
-		if (binaryish > offset / 8)
-			return "binary";
 	}
+
+#ifdef WITH_UCHARDET
 	uchardet_data_end(ud);
 	return uchardet_get_charset(ud);
 #else
-	auto read = std::min<uint64_t>(4096, fp.size());
-	auto buf = fp.read(0, read);
-	for (size_t i = 0; i < read; ++i) {
-		if ((unsigned char)buf[i] < 32 && (buf[i] != '\r' && buf[i] != '\n' && buf[i] != '\t'))
-			++binaryish;
-	}
-
-	if (binaryish > read / 8)
-		return "binary";
 	return "utf-8";
 #endif
 }
@@ -0,0 +1,60 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/cpu.h"
+
+#ifdef AGI_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace {
+agi::InstructionSet detect() {
+#if defined(AGI_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	// AVX state must be enabled by the OS as well as supported by the CPU
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	if (avx && max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			return agi::InstructionSet::AVX2;
+	}
+	return sse2 ? agi::InstructionSet::SSE2 : agi::InstructionSet::Scalar;
+#elif defined(AGI_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return agi::InstructionSet::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return agi::InstructionSet::SSE2;
+	return agi::InstructionSet::Scalar;
+#else
+	return agi::InstructionSet::Scalar;
+#endif
+}
+}
+
+namespace agi {
+InstructionSet BestInstructionSet() {
+	static const InstructionSet best = detect();
+	return best;
+}
+}
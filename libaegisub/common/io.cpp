@@ -58,6 +58,8 @@ Save::Save(fs::path const& file, bool binary)
 
 Save::~Save() noexcept(false) {
 	fp.reset(); // Need to close before rename on Windows to unlock the file
+	if (cancelled) return;
+
 	for (int i = 0; i < 10; ++i) {
 		try {
 			fs::Rename(tmp_name, file_name);
@@ -72,5 +74,16 @@ Save::~Save() noexcept(false) {
 	}
 }
 
+void Save::Cancel() {
+	cancelled = true;
+	fp.reset();
+	try {
+		fs::Remove(tmp_name);
+	}
+	catch (agi::fs::FileSystemError const& e) {
+		LOG_E("agi/io/save/file") << "Could not remove " << tmp_name << ": " << e.GetMessage();
+	}
+}
+
 	} // namespace io
 } // namespace agi
@@ -17,13 +17,20 @@
 
 #include <boost/algorithm/string/case_conv.hpp>
 
+#include <cstring>
+
 namespace agi {
 
+bool is_utf8_compatible(std::string encoding) {
+	boost::to_lower(encoding);
+	// uchardet reports files with no non-ASCII characters as ASCII
+	return encoding == "utf-8" || encoding == "utf8" || encoding == "ascii" || encoding == "us-ascii";
+}
+
 line_iterator_base::line_iterator_base(std::istream &stream, std::string encoding)
 : stream(&stream)
 {
-	boost::to_lower(encoding);
-	if (encoding != "utf-8") {
+	if (!is_utf8_compatible(encoding)) {
 		agi::charset::IconvWrapper c("utf-8", encoding.c_str());
 		c.Convert("\r", 1, reinterpret_cast<char *>(&cr), sizeof(int));
 		c.Convert("\n", 1, reinterpret_cast<char *>(&lf), sizeof(int));
@@ -76,4 +83,24 @@ bool line_iterator_base::getline(std::string &str) {
 
 	return true;
 }
+
+void buffer_line_iterator::next() {
+	if (!next_line) {
+		valid = false;
+		return;
+	}
+
+	const char *start = next_line;
+	auto end = static_cast<const char *>(memchr(start, '\n', buffer_end - start));
+	if (end)
+		next_line = end + 1;
+	else {
+		end = buffer_end;
+		next_line = nullptr;
+	}
+
+	if (end != start && end[-1] == '\r')
+		--end;
+	line = value_type(start, end);
+}
 }
@@ -16,6 +16,14 @@
 
 #include "libaegisub/ycbcr_conv.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef AGI_X86
+#include <immintrin.h>
+#endif
+
 namespace {
 double matrix_coefficients[][3] = {
 	{.299, .587, .114},    // BT.601
@@ -40,6 +48,139 @@ void col_mult(std::array<double, 9>& m, std::array<double, 3> v) {
 		m[6] * v[0], m[7] * v[1], m[8] * v[2],
 	}};
 }
+
+const int precision = agi::ycbcr_row_converter::precision;
+
+typedef int16_t coeff_table[3][3];
+
+int convert_scalar(coeff_table const& coeff, const int32_t *offset, const uint8_t *y, const uint8_t *cb, const uint8_t *cr, int shift, int width, uint8_t *bgra, int x) {
+	for (bgra += 4 * x; x < width; ++x) {
+		int u = cb[x >> shift], v = cr[x >> shift];
+		for (int c = 0; c < 3; ++c) {
+			int val = (coeff[c][0] * y[x] + coeff[c][1] * u + coeff[c][2] * v + offset[c]) >> precision;
+			*bgra++ = val < 0 ? 0 : val > 255 ? 255 : val;
+		}
+		*bgra++ = 0;
+	}
+	return x;
+}
+
+#ifdef AGI_X86
+/// Load the chroma samples for 8 pixels starting at pixel x into the low half of a register
+AGI_TARGET("sse2")
+inline __m128i load_chroma8(const uint8_t *c, int x, int shift) {
+	if (shift == 0)
+		return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(c + x));
+	if (shift == 1) {
+		int32_t v;
+		memcpy(&v, c + x / 2, sizeof v);
+		__m128i r = _mm_cvtsi32_si128(v);
+		return _mm_unpacklo_epi8(r, r);
+	}
+	uint16_t v;
+	memcpy(&v, c + x / 4, sizeof v);
+	__m128i r = _mm_cvtsi32_si128(v);
+	r = _mm_unpacklo_epi8(r, r);
+	return _mm_unpacklo_epi8(r, r);
+}
+
+/// Pack one coefficient for each of a pair of 16-bit values for use with pmaddwd
+inline int32_t coeff_pair(int16_t first, int16_t second) {
+	return (int32_t)((uint32_t)(uint16_t)first | ((uint32_t)(uint16_t)second << 16));
+}
+
+AGI_TARGET("sse2")
+int convert_sse2(coeff_table const& coeff, const int32_t *offset, const uint8_t *y, const uint8_t *cb, const uint8_t *cr, int shift, int width, uint8_t *bgra, int x) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i c_ycb[3], c_cr[3], k[3];
+	for (int c = 0; c < 3; ++c) {
+		c_ycb[c] = _mm_set1_epi32(coeff_pair(coeff[c][0], coeff[c][1]));
+		c_cr[c] = _mm_set1_epi32(coeff_pair(coeff[c][2], 0));
+		k[c] = _mm_set1_epi32(offset[c]);
+	}
+
+	for (; x + 8 <= width; x += 8) {
+		__m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + x)), zero);
+		__m128i cb16 = _mm_unpacklo_epi8(load_chroma8(cb, x, shift), zero);
+		__m128i cr16 = _mm_unpacklo_epi8(load_chroma8(cr, x, shift), zero);
+
+		// (Y, Cb) and (Cr, 0) pairs for pixels 0-3 and 4-7
+		__m128i ycb_lo = _mm_unpacklo_epi16(y16, cb16), ycb_hi = _mm_unpackhi_epi16(y16, cb16);
+		__m128i cr_lo = _mm_unpacklo_epi16(cr16, zero), cr_hi = _mm_unpackhi_epi16(cr16, zero);
+
+		__m128i out[3];
+		for (int c = 0; c < 3; ++c) {
+			__m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(ycb_lo, c_ycb[c]), _mm_madd_epi16(cr_lo, c_cr[c])), k[c]);
+			__m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(ycb_hi, c_ycb[c]), _mm_madd_epi16(cr_hi, c_cr[c])), k[c]);
+			out[c] = _mm_packs_epi32(_mm_srai_epi32(lo, precision), _mm_srai_epi32(hi, precision));
+		}
+
+		// Saturate to bytes and interleave into BGRA
+		__m128i br = _mm_packus_epi16(out[0], out[2]);
+		__m128i g0 = _mm_packus_epi16(out[1], zero);
+		__m128i bg = _mm_unpacklo_epi8(br, g0);
+		__m128i r0 = _mm_unpackhi_epi8(br, g0);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bgra + 4 * x), _mm_unpacklo_epi16(bg, r0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bgra + 4 * x + 16), _mm_unpackhi_epi16(bg, r0));
+	}
+	return x;
+}
+
+/// Load the chroma samples for 16 pixels starting at pixel x
+AGI_TARGET("avx2")
+inline __m128i load_chroma16(const uint8_t *c, int x, int shift) {
+	if (shift == 0)
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + x));
+	if (shift == 1) {
+		__m128i r = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(c + x / 2));
+		return _mm_unpacklo_epi8(r, r);
+	}
+	int32_t v;
+	memcpy(&v, c + x / 4, sizeof v);
+	__m128i r = _mm_cvtsi32_si128(v);
+	r = _mm_unpacklo_epi8(r, r);
+	return _mm_unpacklo_epi8(r, r);
+}
+
+AGI_TARGET("avx2")
+int convert_avx2(coeff_table const& coeff, const int32_t *offset, const uint8_t *y, const uint8_t *cb, const uint8_t *cr, int shift, int width, uint8_t *bgra, int x) {
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i c_ycb[3], c_cr[3], k[3];
+	for (int c = 0; c < 3; ++c) {
+		c_ycb[c] = _mm256_set1_epi32(coeff_pair(coeff[c][0], coeff[c][1]));
+		c_cr[c] = _mm256_set1_epi32(coeff_pair(coeff[c][2], 0));
+		k[c] = _mm256_set1_epi32(offset[c]);
+	}
+
+	for (; x + 16 <= width; x += 16) {
+		__m256i y16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)));
+		__m256i cb16 = _mm256_cvtepu8_epi16(load_chroma16(cb, x, shift));
+		__m256i cr16 = _mm256_cvtepu8_epi16(load_chroma16(cr, x, shift));
+
+		// Unpacking works within each 128-bit lane, so lo holds pixels 0-3
+		// and 8-11 and hi holds 4-7 and 12-15, which packing puts back in order
+		__m256i ycb_lo = _mm256_unpacklo_epi16(y16, cb16), ycb_hi = _mm256_unpackhi_epi16(y16, cb16);
+		__m256i cr_lo = _mm256_unpacklo_epi16(cr16, zero), cr_hi = _mm256_unpackhi_epi16(cr16, zero);
+
+		__m256i out[3];
+		for (int c = 0; c < 3; ++c) {
+			__m256i lo = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(ycb_lo, c_ycb[c]), _mm256_madd_epi16(cr_lo, c_cr[c])), k[c]);
+			__m256i hi = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(ycb_hi, c_ycb[c]), _mm256_madd_epi16(cr_hi, c_cr[c])), k[c]);
+			out[c] = _mm256_packs_epi32(_mm256_srai_epi32(lo, precision), _mm256_srai_epi32(hi, precision));
+		}
+
+		__m256i br = _mm256_packus_epi16(out[0], out[2]);
+		__m256i g0 = _mm256_packus_epi16(out[1], zero);
+		__m256i bg = _mm256_unpacklo_epi8(br, g0);
+		__m256i r0 = _mm256_unpackhi_epi8(br, g0);
+		// Pixels 0-3 and 8-11, then 4-7 and 12-15
+		__m256i first = _mm256_unpacklo_epi16(bg, r0), second = _mm256_unpackhi_epi16(bg, r0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bgra + 4 * x), _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bgra + 4 * x + 32), _mm256_permute2x128_si256(first, second, 0x31));
+	}
+	return x;
+}
+#endif
 }
 
 namespace agi {
@@ -94,5 +235,32 @@ ycbcr_converter::ycbcr_converter(ycbcr_matrix src_mat, ycbcr_range src_range, yc
 	init_src(src_mat, src_range);
 	init_dst(dst_mat, dst_range);
 }
+
+ycbcr_row_converter::ycbcr_row_converter(ycbcr_converter const& conv, InstructionSet max_isa)
+: isa(std::min(max_isa, BestInstructionSet()))
+{
+	const double scale = 1 << precision;
+	// from_ycbcr produces R, G, B, while the output is B, G, R
+	for (int c = 0; c < 3; ++c) {
+		int row = 2 - c;
+		double constant = .5;
+		for (int i = 0; i < 3; ++i) {
+			double factor = conv.from_ycbcr[row * 3 + i];
+			coeff[c][i] = (int16_t)std::lround(factor * scale);
+			constant += factor * conv.shift_from[i];
+		}
+		offset[c] = (int32_t)std::lround(constant * scale);
+	}
 }
 
+void ycbcr_row_converter::convert(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, int chroma_shift, int width, uint8_t *bgra) const {
+	int x = 0;
+#ifdef AGI_X86
+	if (isa == InstructionSet::AVX2)
+		x = convert_avx2(coeff, offset, y, cb, cr, chroma_shift, width, bgra, x);
+	if (isa != InstructionSet::Scalar)
+		x = convert_sse2(coeff, offset, y, cb, cr, chroma_shift, width, bgra, x);
+#endif
+	convert_scalar(coeff, offset, y, cb, cr, chroma_shift, width, bgra, x);
+}
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file journal.h
+/// @brief Reading and writing autosave journals
+///
+/// An autosave journal is an append-only UTF-8 text file of the changes made
+/// to the dialogue lines of a file since it was saved as a snapshot, with one
+/// record per line:
+///
+///     I <id> <id> ...           Ids of the lines in the snapshot, in order
+///     L <id> <after> <line>     A line was added or changed, and belongs after
+///                               line <after>, or first if <after> is 0
+///     D <id>                    A line was removed
+///     S <name>                  Section <name> was replaced by the lines in
+///                               the R records which follow
+///     R <line>                  A line of the replacement section
+///     E                         End of a commit
+///
+/// The first line of the file is a fixed header. Ids are only meaningful
+/// within the journal, and section names are up to the writer.
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace agi { namespace ass {
+/// A change to a line recorded in an autosave journal
+struct JournalRecord {
+	enum class Type { Line, Remove, Section, SectionLine };
+	Type type;
+	/// Line id, or 0 for sections
+	int id;
+	/// Line this one belongs after, or 0 if it is first
+	int after;
+	/// Line in ASS format, or the section name for Section
+	std::string data;
+};
+
+/// The records of one commit
+typedef std::vector<JournalRecord> JournalCommit;
+
+/// Contents of a new journal for a snapshot with the given lines
+std::string JournalHeader(std::vector<int> const& ids);
+
+/// Append a record of a line being added or changed
+void JournalAddLine(std::string& out, int id, int after, std::string const& data);
+/// Append a record of a line being removed
+void JournalRemoveLine(std::string& out, int id);
+/// Append the records of a section being replaced by the given lines
+void JournalSection(std::string& out, std::string const& name, std::vector<std::string> const& lines);
+/// Append the end of a commit
+void JournalEndCommit(std::string& out);
+
+/// @brief Read an autosave journal
+/// @param      stream  Journal to read
+/// @param[out] ids     Ids of the lines in the snapshot
+/// @param[out] commits The complete commits in the journal
+/// @return false if the stream is not an autosave journal
+///
+/// Reading stops at the first malformed record, keeping the commits before
+/// it, as anything after that point is presumably from a write which was cut
+/// off by a crash. A commit without an end record is discarded.
+bool ReadJournal(std::istream& stream, std::vector<int>& ids, std::vector<JournalCommit>& commits);
+
+/// @brief Check if a commit can be applied to a set of lines
+/// @param[in,out] ids Ids of the current lines, which are updated to the
+///                    ids after the commit only if it can be applied
+/// @return Does every record refer to lines which exist when it is applied?
+bool CheckJournalCommit(std::unordered_set<int>& ids, JournalCommit const& commit);
+} }
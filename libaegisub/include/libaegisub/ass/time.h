@@ -26,11 +26,16 @@ class Time {
 public:
 	Time(int ms = 0);
 	Time(std::string const& text);
+	/// Parse a time from a range of characters, such as a field of a line
+	Time(const char *begin, const char *end);
 
 	/// Get millisecond, rounded to centisecond precision
 	// Always round up for 5ms because the range is [start, stop)
 	operator int() const { return (time + 5) - (time + 5) % 10; }
 
+	/// Get the exact time in milliseconds, without rounding
+	int GetExactTime() const { return time; }
+
 	/// Return the time as a string
 	/// @param ms Use milliseconds precision, for non-ASS formats
 	std::string GetAssFormatted(bool ms=false) const;
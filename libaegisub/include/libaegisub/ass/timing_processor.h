@@ -0,0 +1,97 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file timing_processor.h
+/// @brief Timing post-processor passes over lines sorted by start time
+///
+/// Each pass takes a vector of pointers to lines with Start and End members
+/// which are convertible to and assignable from int, sorted by start time.
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <set>
+#include <vector>
+
+namespace agi { namespace ass {
+/// @brief Move the start of each line back by up to lead_in
+///
+/// A line is not extended back past the end of an earlier line which it
+/// doesn't already overlap. The earlier lines are swept with a heap of their
+/// end times, so this takes O(n log n) time.
+template<typename Line>
+void AddLeadIn(std::vector<Line *> const& lines, int lead_in) {
+	// End times of the earlier lines which end after the current line starts
+	std::priority_queue<int, std::vector<int>, std::greater<int>> open;
+	// Latest end time of the earlier lines which don't
+	int closed = INT_MIN;
+
+	for (auto line : lines) {
+		int start = line->Start;
+		for (; !open.empty() && open.top() <= start; open.pop())
+			closed = std::max(closed, open.top());
+		open.push(line->End);
+		line->Start = std::max(start - lead_in, closed);
+	}
+}
+
+/// @brief Move the end of each line forward by up to lead_out
+///
+/// A line is not extended past the start of a later line which starts at or
+/// after its end. The later lines are swept in reverse with a set of their
+/// start times, so this takes O(n log n) time.
+template<typename Line>
+void AddLeadOut(std::vector<Line *> const& lines, int lead_out) {
+	std::set<int> starts;
+	for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+		auto line = *it;
+		int start = line->Start;
+		int end = line->End;
+
+		int new_end = end + lead_out;
+		// An empty line doesn't stop at later lines which start at the same time
+		auto next = starts.lower_bound(std::max(end, start + 1));
+		if (next != starts.end())
+			new_end = std::min(new_end, *next);
+		line->End = new_end;
+		starts.insert(start);
+	}
+}
+
+/// @brief Close small gaps and overlaps between consecutive lines
+/// @param max_gap     Largest gap between lines to close
+/// @param max_overlap Largest overlap between lines to remove
+/// @param bias        Fraction of the gap or overlap to take from the first
+///                    line rather than the second
+template<typename Line>
+void MakeAdjacent(std::vector<Line *> const& lines, int max_gap, int max_overlap, double bias) {
+	for (size_t i = 1; i < lines.size(); ++i) {
+		Line *prev = lines[i - 1];
+		Line *cur = lines[i];
+
+		int prev_end = prev->End;
+		int dist = cur->Start - prev_end;
+		if ((dist < 0 && -dist <= max_overlap) || (dist > 0 && dist <= max_gap)) {
+			int pos = prev_end + int(dist * bias);
+			cur->Start = pos;
+			prev->End = pos;
+		}
+	}
+}
+} }
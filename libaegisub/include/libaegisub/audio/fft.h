@@ -0,0 +1,102 @@
+// Copyright (c) 2005, Rodrigo Braz Monteiro
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//   * Neither the name of the Aegisub Group nor the names of its contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <libaegisub/cpu.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace agi {
+class FFT {
+	void DoTransform(size_t n_samples,float *input,float *output_r,float *output_i,bool inverse);
+
+public:
+	void Transform(size_t n_samples,float *input,float *output_r,float *output_i);
+	void InverseTransform(size_t n_samples,float *input,float *output_r,float *output_i);
+	bool IsPowerOfTwo(unsigned int x);
+	unsigned int NumberOfBitsNeeded(unsigned int n_samples);
+	unsigned int ReverseBits(unsigned int index, unsigned int bits);
+	float FrequencyAtIndex(unsigned int baseFreq, unsigned int n_samples, unsigned int index);
+};
+
+/// @class RealFFT
+/// @brief Forward FFT of real input with a fixed power-of-two size
+///
+/// The input is transformed as a complex FFT of half the size followed by a
+/// split step, with the bit reversal and twiddle tables computed once on
+/// construction. The butterflies, split step and Power use SSE2 or AVX2 when
+/// the CPU supports them. Unlike FFT, only the non-redundant first half of the
+/// spectrum is produced.
+///
+/// An instance holds scratch buffers, so it must not be shared between threads.
+class RealFFT {
+public:
+	typedef agi::InstructionSet InstructionSet;
+
+private:
+	size_t size;
+	InstructionSet isa;
+
+	/// Bit-reversed position of each complex input
+	std::vector<uint32_t> reverse;
+	/// Butterfly twiddles; the stage of width 2w starts at index w - 1
+	std::vector<float> twiddle_r, twiddle_i;
+	/// Twiddles for the split step
+	std::vector<float> split_r, split_i;
+	/// Half-size complex transform being worked on
+	std::vector<float> work_r, work_i;
+
+public:
+	/// @param size    Number of real input samples; must be a power of two of at least 2
+	/// @param max_isa Most capable instruction set to use, for testing and benchmarking
+	RealFFT(size_t size, InstructionSet max_isa = InstructionSet::AVX2);
+
+	size_t GetSize() const { return size; }
+	InstructionSet GetInstructionSet() const { return isa; }
+
+	/// @brief Transform GetSize() real samples
+	/// @param input    Samples to transform
+	/// @param output_r Real part of the first GetSize() / 2 bins
+	/// @param output_i Imaginary part of the first GetSize() / 2 bins
+	void Transform(const float *input, float *output_r, float *output_i);
+
+	/// @brief Calculate log10(|bin| * scale + 1) for each bin of a transform
+	/// @param real   Real part of GetSize() / 2 bins
+	/// @param imag   Imaginary part of GetSize() / 2 bins
+	/// @param scale  Factor to scale the magnitudes by
+	/// @param output GetSize() / 2 values to write
+	///
+	/// Uses a polynomial approximation of the logarithm which is accurate to
+	/// around 1e-6 for the inputs Transform produces.
+	void Power(const float *real, const float *imag, float scale, float *output) const;
+};
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <libaegisub/fs_fwd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace agi {
+/// @class AudioPeaks
+/// @brief Multi-resolution min/max/sum summary of 16-bit mono audio
+///
+/// Level n summarizes blocks of BlockSize(n) samples, each level being 16
+/// times coarser than the previous one. Samples are fed in order by a single
+/// writer (normally the decoding thread of a caching audio provider), and any
+/// number of readers may concurrently query the blocks completed so far.
+class AudioPeaks {
+public:
+	/// Summary of a single block of samples
+	struct Peak {
+		int16_t min;
+		int16_t max;
+		// 2^16 samples of magnitude at most 2^15 fit in an int32_t
+		int32_t neg_sum;
+		int32_t pos_sum;
+	};
+
+	/// Summary of an arbitrary run of blocks
+	struct Range {
+		int min = 0;
+		int max = 0;
+		int64_t neg_sum = 0;
+		int64_t pos_sum = 0;
+		/// Number of samples covered by the blocks summarized
+		int64_t samples = 0;
+	};
+
+	static const int level_count = 3;
+
+	/// Number of samples summarized by each entry of the given level
+	static int64_t BlockSize(int level) { return INT64_C(1) << (8 + 4 * level); }
+
+private:
+	std::vector<Peak> levels[level_count];
+	/// Block currently being accumulated for each level
+	Peak partial[level_count];
+
+	int64_t num_samples;
+	/// Number of samples passed to Append; only touched by the writer
+	int64_t written = 0;
+	/// Number of samples whose blocks have been published to readers
+	std::atomic<int64_t> available{0};
+
+	void Push(int level);
+
+public:
+	AudioPeaks(int64_t num_samples);
+
+	/// Add the next count samples of the audio to the summary
+	void Append(const int16_t *samples, int64_t count);
+
+	/// @brief Write a completed summary to a cache file
+	///
+	/// The file is a small header followed by the blocks of each level in
+	/// order, in native byte order, so that it can be mapped and loaded
+	/// without any parsing. As the cache is purely an optimization, failing
+	/// to write it is logged rather than reported to the caller.
+	void Save(fs::path const& filename) const;
+
+	/// @brief Load a summary previously written with Save
+	/// @param filename    Cache file to load
+	/// @param num_samples Expected length of the audio
+	/// @return The complete summary, or nullptr if the file does not exist
+	///         or does not match the audio
+	static std::unique_ptr<AudioPeaks> Load(fs::path const& filename, int64_t num_samples);
+
+	int64_t GetNumSamples() const { return num_samples; }
+	int64_t GetAvailableSamples() const { return available; }
+
+	/// Get the coarsest level whose blocks are no larger than the given
+	/// number of samples, or -1 if even the finest level is too coarse
+	static int LevelFor(double samples);
+
+	/// @brief Summarize the samples in [start, end) using the given level
+	/// @param[out] out Summary of all blocks starting in the range
+	/// @return false if the range has not been summarized yet
+	///
+	/// The range is rounded to the block boundaries of the level, so that
+	/// adjacent ranges never summarize a block twice.
+	bool Get(int level, int64_t start, int64_t end, Range &out) const;
+};
+}
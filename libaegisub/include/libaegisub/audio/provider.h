@@ -23,6 +23,8 @@
 #include <vector>
 
 namespace agi {
+class AudioPeaks;
+
 class AudioProvider {
 protected:
 	int channels = 0;
@@ -54,6 +56,9 @@ public:
 
 	/// Does this provider benefit from external caching?
 	virtual bool NeedsCache() const { return false; }
+
+	/// Get the peak summary of the decoded audio, if this provider builds one
+	virtual AudioPeaks const* GetPeaks() const { return nullptr; }
 };
 
 /// Helper base class for an audio provider which wraps another provider
@@ -88,8 +93,17 @@ std::unique_ptr<AudioProvider> CreatePCMAudioProvider(fs::path const& filename,
 
 std::unique_ptr<AudioProvider> CreateConvertAudioProvider(std::unique_ptr<AudioProvider> source_provider);
 std::unique_ptr<AudioProvider> CreateLockAudioProvider(std::unique_ptr<AudioProvider> source_provider);
-std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> source_provider, fs::path const& dir);
-std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> source_provider);
+
+/// @brief Create a provider which caches the decoded audio on disk
+/// @param dir       Directory to write the cache to
+/// @param peak_file If not empty, a peak cache file to load the waveform peaks
+///                  from, or to save them to once decoding has finished
+std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> source_provider, fs::path const& dir, fs::path const& peak_file);
+
+/// @brief Create a provider which caches the decoded audio in memory
+/// @param peak_file As for CreateHDAudioProvider
+std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> source_provider, fs::path const& peak_file);
+
 
 void SaveAudioClip(AudioProvider const& provider, fs::path const& path, int start_time, int end_time);
 }
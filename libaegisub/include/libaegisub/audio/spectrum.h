@@ -0,0 +1,56 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace agi {
+class AudioProvider;
+
+/// @class AudioSpectrumCalculator
+/// @brief Derives frequency-power data from 16-bit mono audio
+///
+/// Each calculator owns its FFT plan and scratch buffers, so any number of
+/// calculators may be used concurrently from different threads, but a single
+/// calculator may only be used by one thread at a time.
+class AudioSpectrumCalculator {
+	struct Impl;
+	std::unique_ptr<Impl> impl;
+
+	/// Binary logarithm of the number of values produced per derivation
+	size_t derivation_size;
+
+public:
+	/// @param derivation_size Binary logarithm of the number of values to
+	///                        produce per derivation. Each derivation reads
+	///                        twice that many samples.
+	AudioSpectrumCalculator(size_t derivation_size);
+	~AudioSpectrumCalculator();
+
+	/// Number of values written by each call to Calculate
+	size_t GetBlockSize() const { return (size_t)1 << derivation_size; }
+
+	/// @brief Calculate the spectrum of a range of audio
+	/// @param provider    Audio provider to read from
+	/// @param first_sample First sample of the derivation; may be negative
+	/// @param[out] block  Buffer of GetBlockSize() values to fill with the
+	///                    power of each frequency band, roughly in [0, 1]
+	void Calculate(AudioProvider const& provider, int64_t first_sample, float *block);
+};
+}
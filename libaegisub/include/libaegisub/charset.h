@@ -16,8 +16,10 @@
 /// @brief Character set detection and manipulation utilities.
 /// @ingroup libaegisub
 
+#include <libaegisub/cpu.h>
 #include <libaegisub/fs_fwd.h>
 
+#include <cstddef>
 #include <string>
 
 namespace agi {
@@ -29,5 +31,21 @@ namespace agi {
 /// @return Detected character set.
 std::string Detect(agi::fs::path const& file);
 
+/// @brief Get the length of the longest prefix of a buffer which is valid UTF-8
+/// @param data    Buffer to check
+/// @param len     Length of the buffer in bytes
+/// @param max_isa Most capable instruction set to use, for testing and benchmarking
+/// @return len if the entire buffer is valid
+///
+/// A multibyte sequence which is cut off by the end of the buffer is not
+/// part of the valid prefix.
+size_t ValidUtf8Prefix(const char *data, size_t len, InstructionSet max_isa = InstructionSet::AVX2);
+
+/// @brief Count the control characters other than tab, CR and LF in a buffer
+/// @param data    Buffer to check
+/// @param len     Length of the buffer in bytes
+/// @param max_isa Most capable instruction set to use, for testing and benchmarking
+size_t CountControlBytes(const char *data, size_t len, InstructionSet max_isa = InstructionSet::AVX2);
+
 	} // namespace util
 } // namespace agi
@@ -0,0 +1,39 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+/// Defined when SSE2 and AVX2 code paths can be compiled
+#define AGI_X86
+
+#ifdef _MSC_VER
+#define AGI_TARGET(isa)
+#else
+/// Allow a function to use the intrinsics for isa without requiring that
+/// instruction set for the rest of the program
+#define AGI_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace agi {
+/// SIMD instruction sets which code paths may be optimized for, in order of
+/// increasing capability
+enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+/// Get the most capable instruction set supported by both the CPU and the OS
+InstructionSet BestInstructionSet();
+}
@@ -119,6 +119,14 @@ namespace agi {
 		/// time if it does
 		void Touch(path const& file_path);
 
+		/// Append data to a file and flush it to disk
+		/// @param file_path File to append to, which is created if needed
+		/// @param data      Bytes to append
+		///
+		/// Intended for small journal-style writes which need to survive a
+		/// crash immediately after this returns.
+		void Append(path const& file_path, std::string const& data);
+
 		/// Rename a file or directory
 		/// @param from Source path
 		/// @param to   Destination path
@@ -0,0 +1,164 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace agi {
+/// @class interval_index
+/// @brief Index of half-open [start, end) intervals for overlap queries
+///
+/// The intervals are kept sorted by start time, with a segment tree of the
+/// maximum end time of each range of intervals. Finding the k intervals which
+/// overlap a range takes O(k log n) time. Inserting or removing intervals
+/// costs O(n) moves and an O(n) rebuild of the tree before the next query,
+/// which is cheap compared to sorting but much more than a query.
+template<typename T>
+class interval_index {
+public:
+	struct interval {
+		int start;
+		int end;
+		T value;
+	};
+
+private:
+	/// Intervals sorted by start
+	std::vector<interval> items;
+	/// Maximum end of each node of a complete binary tree over items, with
+	/// the leaves starting at index leaves
+	std::vector<int> max_end;
+	size_t leaves = 0;
+	/// Does max_end need to be rebuilt?
+	bool dirty = false;
+
+	static bool by_start(interval const& lft, interval const& rgt) {
+		return lft.start < rgt.start;
+	}
+
+	/// Index of the first interval starting after time
+	size_t first_after(int time) const {
+		return std::upper_bound(items.begin(), items.end(), time,
+			[](int t, interval const& i) { return t < i.start; }) - items.begin();
+	}
+
+	void build() {
+		leaves = 1;
+		while (leaves < items.size()) leaves *= 2;
+		max_end.assign(leaves * 2, INT_MIN);
+		for (size_t i = 0; i < items.size(); ++i)
+			max_end[leaves + i] = items[i].end;
+		for (size_t i = leaves - 1; i > 0; --i)
+			max_end[i] = std::max(max_end[i * 2], max_end[i * 2 + 1]);
+		dirty = false;
+	}
+
+	template<typename Func>
+	void visit(size_t node, size_t first, size_t count, size_t limit, int start, Func& f) const {
+		if (first >= limit || max_end[node] <= start) return;
+		if (node >= leaves) {
+			f(items[node - leaves]);
+			return;
+		}
+		count /= 2;
+		visit(node * 2, first, count, limit, start, f);
+		visit(node * 2 + 1, first + count, count, limit, start, f);
+	}
+
+public:
+	/// Replace the contents of the index
+	void assign(std::vector<interval> new_items) {
+		items = std::move(new_items);
+		std::stable_sort(items.begin(), items.end(), by_start);
+		dirty = true;
+	}
+
+	void clear() {
+		items.clear();
+		dirty = true;
+	}
+
+	/// Add an interval, after any existing intervals with the same start
+	void insert(int start, int end, T value) {
+		items.insert(items.begin() + first_after(start), interval{start, end, value});
+		dirty = true;
+	}
+
+	/// Remove every interval for which pred returns true
+	template<typename Pred>
+	void erase_if(Pred pred) {
+		items.erase(std::remove_if(items.begin(), items.end(), pred), items.end());
+		dirty = true;
+	}
+
+	/// @brief Call f for every interval which overlaps [start, end]
+	///
+	/// Intervals overlap if they start at or before end and end after
+	/// start, so passing the same time for both finds the intervals
+	/// containing that time. Intervals are visited in order of start.
+	template<typename Func>
+	void for_each_overlapping(int start, int end, Func f) {
+		if (dirty) build();
+		if (items.empty()) return;
+		visit(1, 0, leaves, first_after(end), start, f);
+	}
+
+	/// @brief Call f(a, b) for every pair of overlapping intervals
+	///
+	/// Unlike for_each_overlapping, both ends are exclusive here: intervals
+	/// overlap if each starts before the other ends, so intervals which only
+	/// touch do not overlap. a is the interval which comes first in order of
+	/// start. The intervals are swept in order of start with a heap of the
+	/// ends of the ones still open, which takes O(n log n + k) time for k
+	/// pairs.
+	template<typename Func>
+	void for_each_overlapping_pair(Func f) const {
+		// Indices of the open intervals, as a heap with the earliest end first
+		std::vector<size_t> open;
+		auto later_end = [&](size_t lft, size_t rgt) { return items[lft].end > items[rgt].end; };
+
+		for (size_t i = 0; i < items.size(); ++i) {
+			auto const& item = items[i];
+			while (!open.empty() && items[open.front()].end <= item.start) {
+				std::pop_heap(open.begin(), open.end(), later_end);
+				open.pop_back();
+			}
+
+			// An empty interval only overlaps the ones which started before
+			// it, and nothing which starts after it
+			if (item.end <= item.start) {
+				for (size_t j : open) {
+					if (items[j].start < item.start)
+						f(items[j], item);
+				}
+				continue;
+			}
+
+			for (size_t j : open)
+				f(items[j], item);
+			open.push_back(i);
+			std::push_heap(open.begin(), open.end(), later_end);
+		}
+	}
+
+	std::vector<interval> const& intervals() const { return items; }
+	size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+};
+}
@@ -35,11 +35,16 @@ class Save {
 	std::unique_ptr<std::ostream> fp;
 	const fs::path file_name;
 	const fs::path tmp_name;
+	bool cancelled = false;
 
 public:
 	Save(fs::path const& file, bool binary = false);
 	~Save() noexcept(false);
 	std::ostream& Get() { return *fp; }
+
+	/// Delete the temporary file rather than replacing the target file with
+	/// it when this is destroyed, for when writing it failed partway through
+	void Cancel();
 };
 
 	} // namespace io
@@ -20,9 +20,11 @@
 
 #include <iterator>
 #include <memory>
+#include <string>
 
 #include <cstdint>
 #include <boost/interprocess/streams/bufferstream.hpp>
+#include <boost/range/iterator_range.hpp>
 
 namespace agi {
 
@@ -114,6 +116,62 @@ line_iterator<T>& begin(line_iterator<T>& it) { return it; }
 template<typename T>
 line_iterator<T> end(line_iterator<T>&) { return agi::line_iterator<T>(); }
 
+/// Can text in the named encoding be read as UTF-8 without converting it?
+bool is_utf8_compatible(std::string encoding);
+
+/// @class buffer_line_iterator
+/// @brief An iterator over the lines of UTF-8 text in memory
+///
+/// Each line is a range pointing into the buffer without the line ending,
+/// so nothing is copied or converted. Lines are split the same way as
+/// line_iterator splits them, including the empty line after a final
+/// newline.
+class buffer_line_iterator final : public std::iterator<std::input_iterator_tag, boost::iterator_range<const char *>> {
+	/// Start of the line after the current one, or nullptr if the current
+	/// line is the last one
+	const char *next_line = nullptr;
+	const char *buffer_end = nullptr;
+	value_type line;
+	bool valid = false;
+
+	void next();
+
+public:
+	/// @param data Buffer to iterate over, which must outlive the iterator
+	/// @param len  Length of the buffer in bytes
+	buffer_line_iterator(const char *data, size_t len)
+	: next_line(data ? data : "")
+	, buffer_end(next_line + len)
+	, valid(true)
+	{
+		next();
+	}
+
+	/// @brief Invalid iterator constructor; use for end iterator
+	buffer_line_iterator() = default;
+
+	value_type const& operator*() const { return line; }
+	value_type const* operator->() const { return &line; }
+
+	buffer_line_iterator& operator++() {
+		next();
+		return *this;
+	}
+	buffer_line_iterator operator++(int) {
+		buffer_line_iterator tmp(*this);
+		next();
+		return tmp;
+	}
+
+	bool operator==(buffer_line_iterator const& rgt) const {
+		return valid == rgt.valid && (!valid || line.begin() == rgt.line.begin());
+	}
+	bool operator!=(buffer_line_iterator const& rgt) const { return !operator==(rgt); }
+};
+
+inline buffer_line_iterator& begin(buffer_line_iterator& it) { return it; }
+inline buffer_line_iterator end(buffer_line_iterator&) { return buffer_line_iterator(); }
+
 template<class OutputType>
 void line_iterator<OutputType>::next() {
 	std::string str;
@@ -0,0 +1,141 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace agi {
+/// @class lru_cache
+/// @brief Hash-indexed least recently used cache with a limit in bytes
+///
+/// The size of each value is supplied by the caller when it is inserted.
+/// Inserting evicts the least recently used values until the new value fits,
+/// but the most recently inserted value is always kept even if it alone is
+/// larger than the limit. The storage of the last evicted value is reused for
+/// the new one, so a full cache of equally sized values does not allocate.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class lru_cache {
+	struct entry {
+		Key key;
+		Value value;
+		size_t size;
+
+		entry(Key const& key, Value const& value, size_t size)
+		: key(key), value(value), size(size) { }
+	};
+
+	/// Values with the most recently used at the front
+	std::list<entry> items;
+	/// Holds the most recently evicted value so that it can be recycled
+	std::list<entry> spare;
+	std::unordered_map<Key, typename std::list<entry>::iterator, Hash> index;
+
+	size_t max_size;
+	size_t total_size = 0;
+
+public:
+	/// Counters for tuning the size of the cache
+	struct stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		/// Largest total size the cache has reached
+		size_t peak_size = 0;
+	};
+
+private:
+	stats counters;
+
+	void remove_last() {
+		auto last = std::prev(items.end());
+		index.erase(last->key);
+		total_size -= last->size;
+		++counters.evictions;
+		spare.clear();
+		spare.splice(spare.begin(), items, last);
+	}
+
+public:
+	/// @param max_size Maximum total size in bytes of the values in the cache
+	lru_cache(size_t max_size) : max_size(max_size) { }
+
+	/// @brief Look up a value and mark it as the most recently used
+	/// @return The cached value, or nullptr if the key is not in the cache
+	///
+	/// The returned pointer is invalidated by the next call to put or clear.
+	Value *get(Key const& key) {
+		auto it = index.find(key);
+		if (it == index.end()) {
+			++counters.misses;
+			return nullptr;
+		}
+		++counters.hits;
+		items.splice(items.begin(), items, it->second);
+		return &it->second->value;
+	}
+
+	/// @brief Insert or replace a value as the most recently used
+	/// @param key   Key to store the value under
+	/// @param value Value to copy into the cache
+	/// @param size  Size in bytes to account for the value
+	void put(Key const& key, Value const& value, size_t size) {
+		auto it = index.find(key);
+		if (it != index.end()) {
+			total_size -= it->second->size;
+			spare.clear();
+			spare.splice(spare.begin(), items, it->second);
+			index.erase(it);
+		}
+
+		while (!items.empty() && total_size + size > max_size)
+			remove_last();
+
+		if (spare.empty())
+			items.emplace_front(key, value, size);
+		else {
+			items.splice(items.begin(), spare, spare.begin());
+			auto& front = items.front();
+			front.key = key;
+			front.value = value;
+			front.size = size;
+		}
+
+		index[key] = items.begin();
+		total_size += size;
+		if (total_size > counters.peak_size)
+			counters.peak_size = total_size;
+	}
+
+	/// Remove all values from the cache, keeping the counters
+	void clear() {
+		items.clear();
+		spare.clear();
+		index.clear();
+		total_size = 0;
+	}
+
+	/// Number of values in the cache
+	size_t count() const { return items.size(); }
+	/// Total size in bytes of the values in the cache
+	size_t size() const { return total_size; }
+	size_t capacity() const { return max_size; }
+	stats const& get_stats() const { return counters; }
+};
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <libaegisub/dispatch.h>
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace agi {
+/// @class parallel_batches
+/// @brief Transform a sequence of items on the background queue
+///
+/// Items are collected into batches, and each full batch is transformed on
+/// agi::dispatch::Background() while the caller continues to add items.
+/// finish() then waits for the batches and hands the results to the caller
+/// in the order the items were added. Any exception thrown by the transform
+/// is rethrown from finish(), after the results of the batches before the
+/// one which failed have been delivered.
+///
+/// The items are often pointers into data owned by the caller, so the
+/// destructor waits for any batches which are still running, such as when
+/// finish() is left early by an exception.
+template<typename In, typename Out>
+class parallel_batches {
+	typedef std::function<Out (In&)> transform_type;
+
+	std::shared_ptr<const transform_type> transform;
+	size_t batch_size;
+	std::vector<In> pending;
+	std::deque<std::future<std::vector<Out>>> batches;
+
+	void submit() {
+		if (pending.empty()) return;
+
+		auto promise = std::make_shared<std::promise<std::vector<Out>>>();
+		batches.push_back(promise->get_future());
+
+		auto input = std::make_shared<std::vector<In>>(std::move(pending));
+		pending.clear();
+		pending.reserve(batch_size);
+
+		// The job holds its own reference to the transform rather than
+		// referring to this object
+		auto transform = this->transform;
+		agi::dispatch::Background().Async([=] {
+			try {
+				std::vector<Out> output;
+				output.reserve(input->size());
+				for (auto& item : *input)
+					output.push_back((*transform)(item));
+				promise->set_value(std::move(output));
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+			}
+		});
+	}
+
+public:
+	/// @param transform  Function to apply to each item. Must be safe to call
+	///                   from several threads at once.
+	/// @param batch_size Number of items to transform in each job
+	parallel_batches(transform_type transform, size_t batch_size)
+	: transform(std::make_shared<const transform_type>(std::move(transform)))
+	, batch_size(batch_size)
+	{
+		pending.reserve(batch_size);
+	}
+
+	~parallel_batches() {
+		for (auto& batch : batches) {
+			if (batch.valid())
+				batch.wait();
+		}
+	}
+
+	parallel_batches(parallel_batches const&) = delete;
+	parallel_batches& operator=(parallel_batches const&) = delete;
+
+	/// Add an item to be transformed
+	void add(In item) {
+		pending.push_back(std::move(item));
+		if (pending.size() >= batch_size)
+			submit();
+	}
+
+	/// @brief Wait for all of the items added so far to be transformed
+	/// @param sink Function called with each result in order
+	template<typename Sink>
+	void finish(Sink&& sink) {
+		submit();
+		while (!batches.empty()) {
+			auto output = batches.front().get();
+			batches.pop_front();
+			for (auto& item : output)
+				sink(std::move(item));
+		}
+	}
+
+	/// Number of batches which have been submitted but not collected
+	size_t outstanding() const { return batches.size(); }
+};
+}
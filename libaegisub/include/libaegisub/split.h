@@ -15,6 +15,7 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include <boost/range/iterator_range.hpp>
+#include <iterator>
 
 namespace agi {
 	typedef boost::iterator_range<std::string::const_iterator> StringRange;
@@ -25,7 +26,7 @@ namespace agi {
 		Iterator b;
 		Iterator cur;
 		Iterator e;
-		typename Iterator::value_type c;
+		typename std::iterator_traits<Iterator>::value_type c;
 
 	public:
 		using iterator_category = std::forward_iterator_tag;
@@ -34,7 +35,7 @@ namespace agi {
 		using reference = value_type&;
 		using difference_type = ptrdiff_t;
 
-		split_iterator(Iterator begin, Iterator end, typename Iterator::value_type c)
+		split_iterator(Iterator begin, Iterator end, typename std::iterator_traits<Iterator>::value_type c)
 		: b(begin), cur(begin), e(end), c(c)
 		{
 			if (b != e)
@@ -95,8 +96,23 @@ namespace agi {
 		return std::string(r.begin(), r.end());
 	}
 
+	/// Trim ASCII whitespace from both ends of a range without copying it,
+	/// and without the locale lookups boost::trim does per call
+	template<typename Iterator>
+	boost::iterator_range<Iterator> Trim(boost::iterator_range<Iterator> const& r) {
+		auto is_space = [](char c) {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+		};
+		auto begin = r.begin(), end = r.end();
+		while (begin != end && is_space(*begin)) ++begin;
+		while (begin != end && is_space(*std::prev(end))) --end;
+		return boost::make_iterator_range(begin, end);
+	}
+
 	template<typename Str, typename Char>
 	split_iterator<typename Str::const_iterator> Split(Str const& str, Char delim) {
+		using std::begin;
+		using std::end;
 		return split_iterator<typename Str::const_iterator>(begin(str), end(str), delim);
 	}
 
@@ -18,6 +18,7 @@
 #include <cstdint>
 
 #include <libaegisub/color.h>
+#include <libaegisub/cpu.h>
 
 namespace agi {
 enum class ycbcr_matrix {
@@ -34,6 +35,8 @@ enum class ycbcr_range {
 
 /// A converter between YCbCr colorspaces and RGB
 class ycbcr_converter {
+	friend class ycbcr_row_converter;
+
 	std::array<double, 9> from_ycbcr;
 	std::array<double, 9> to_ycbcr;
 
@@ -92,5 +95,40 @@ public:
 		return Color{arr[0], arr[1], arr[2], c.a};
 	}
 };
-}
 
+/// @class ycbcr_row_converter
+/// @brief Fixed-point conversion of rows of planar 8-bit YCbCr to BGRA
+///
+/// The converter's floating point matrix is turned into 13-bit fixed-point
+/// coefficients, and rows are converted with SSE2 or AVX2 when the CPU
+/// supports them. Results may differ from ycbcr_converter::ycbcr_to_rgb by
+/// one due to the rounding of the coefficients.
+class ycbcr_row_converter {
+	/// Coefficients for Y, Cb and Cr of each of B, G and R
+	int16_t coeff[3][3];
+	/// Constant term of each of B, G and R, including rounding
+	int32_t offset[3];
+	InstructionSet isa;
+
+public:
+	/// Fractional bits of the coefficients
+	static const int precision = 13;
+
+	/// @param conv    Converter whose YCbCr to RGB conversion should be used
+	/// @param max_isa Most capable instruction set to use, for testing and benchmarking
+	ycbcr_row_converter(ycbcr_converter const& conv, InstructionSet max_isa = InstructionSet::AVX2);
+
+	InstructionSet get_instruction_set() const { return isa; }
+
+	/// @brief Convert one row of pixels
+	/// @param y            width luma samples
+	/// @param cb           Chroma samples, one per 2^chroma_shift pixels
+	/// @param cr           Chroma samples, one per 2^chroma_shift pixels
+	/// @param chroma_shift Binary logarithm of the horizontal chroma subsampling; 0 to 2
+	/// @param width        Number of pixels to convert
+	/// @param[out] bgra    4 * width bytes to write; the fourth byte of each pixel is zero
+	///
+	/// No more than ceil(width / 2^chroma_shift) chroma samples are read.
+	void convert(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, int chroma_shift, int width, uint8_t *bgra) const;
+};
+}
@@ -20,10 +20,13 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
+#include <cerrno>
+#include <cstring>
 #include <fcntl.h>
 #include <fnmatch.h>
 #include <istream>
 #include <sys/time.h>
+#include <unistd.h>
 
 namespace bfs = boost::filesystem;
 
@@ -42,6 +45,40 @@ void Touch(path const& file) {
 	}
 }
 
+void Append(path const& file, std::string const& data) {
+	int fd = open(file.c_str(), O_CREAT | O_APPEND | O_WRONLY, 0644);
+	if (fd < 0) {
+		acs::CheckDirWrite(file.parent_path());
+		acs::CheckFileWrite(file);
+		throw FileSystemUnknownError("Failed to open " + file.string() + ": " + strerror(errno));
+	}
+
+	const char *buf = data.data();
+	size_t remaining = data.size();
+	while (remaining > 0) {
+		ssize_t written = write(fd, buf, remaining);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			int err = errno;
+			close(fd);
+			if (err == ENOSPC)
+				throw DriveFull(file);
+			throw FileSystemUnknownError("Failed to write to " + file.string() + ": " + strerror(err));
+		}
+		buf += written;
+		remaining -= written;
+	}
+
+	// Errors from writing the data back can show up in either of these
+	if (fsync(fd) != 0) {
+		int err = errno;
+		close(fd);
+		throw FileSystemUnknownError("Failed to flush " + file.string() + ": " + strerror(err));
+	}
+	if (close(fd) != 0)
+		throw FileSystemUnknownError("Failed to close " + file.string() + ": " + strerror(errno));
+}
+
 void Copy(fs::path const& from, fs::path const& to) {
 	acs::CheckFileRead(from);
 	CreateDirectory(to.parent_path());
@@ -25,6 +25,7 @@
 using agi::charset::ConvertW;
 using agi::charset::ConvertLocal;
 
+#include <algorithm>
 #include <boost/filesystem.hpp>
 namespace bfs = boost::filesystem;
 
@@ -59,6 +60,34 @@ void Touch(path const& file) {
 		throw EnvironmentError("SetFileTime failed with error: " + util::ErrorString(GetLastError()));
 }
 
+void Append(path const& file, std::string const& data) {
+	scoped_holder<HANDLE, BOOL (__stdcall *)(HANDLE)>
+		h(CreateFile(file.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr), CloseHandle);
+	if (h == INVALID_HANDLE_VALUE) {
+		acs::CheckDirWrite(file.parent_path());
+		acs::CheckFileWrite(file);
+		throw FileSystemUnknownError("Failed to open " + file.string() + ": " + util::ErrorString(GetLastError()));
+	}
+
+	// WriteFile takes a DWORD size, so write very large data in pieces
+	const char *buf = data.data();
+	size_t remaining = data.size();
+	while (remaining > 0) {
+		DWORD size = static_cast<DWORD>(std::min<size_t>(remaining, 1 << 30));
+		DWORD written = 0;
+		if (!WriteFile(h, buf, size, &written, nullptr) || written != size) {
+			if (GetLastError() == ERROR_DISK_FULL)
+				throw DriveFull(file);
+			throw FileSystemUnknownError("Failed to write to " + file.string() + ": " + util::ErrorString(GetLastError()));
+		}
+		buf += written;
+		remaining -= written;
+	}
+
+	if (!FlushFileBuffers(h))
+		throw FileSystemUnknownError("Failed to flush " + file.string() + ": " + util::ErrorString(GetLastError()));
+}
+
 void Copy(fs::path const& from, fs::path const& to) {
 	acs::CheckFileRead(from);
 	CreateDirectory(to.parent_path());
@@ -35,21 +35,24 @@
 #include "subtitle_format.h"
 #include "utils.h"
 
-#include <libaegisub/of_type_adaptor.h>
+#include <libaegisub/character_count.h>
 #include <libaegisub/split.h>
 #include <libaegisub/make_unique.h>
 
+#include <atomic>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/join.hpp>
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/range/adaptor/transformed.hpp>
 #include <boost/regex.hpp>
 #include <boost/spirit/include/karma_generate.hpp>
 #include <boost/spirit/include/karma_int.hpp>
+#include <mutex>
 
 using namespace boost::adaptors;
 
-static int next_id = 0;
+// Lines are created by the background threads when parsing files
+static std::atomic<int> next_id{0};
 
 AssDialogue::AssDialogue() {
 	Id = ++next_id;
@@ -71,32 +74,52 @@ AssDialogue::AssDialogue(std::string const& data) {
 
 AssDialogue::~AssDialogue () { }
 
+namespace {
+typedef boost::iterator_range<const char *> char_range;
+
+/// Splits a line into its fields without copying them
 class tokenizer {
-	agi::StringRange str;
-	agi::split_iterator<agi::StringRange::const_iterator> pos;
+	char_range str;
+	agi::split_iterator<const char *> pos;
 
 public:
-	tokenizer(agi::StringRange const& str) : str(str) , pos(agi::Split(str, ',')) { }
+	tokenizer(char_range const& str) : str(str) , pos(agi::Split(str, ',')) { }
 
-	agi::StringRange next_tok() {
+	char_range next_tok() {
 		if (pos.eof())
 			throw SubtitleFormatParseError("Failed parsing line: " + std::string(str.begin(), str.end()));
 		return *pos++;
 	}
 
-	std::string next_str() { return agi::str(next_tok()); }
-	std::string next_str_trim() { return agi::str(boost::trim_copy(next_tok())); }
+	char_range next_tok_trim() { return agi::Trim(next_tok()); }
+
+	int next_int() {
+		auto tok = next_tok();
+		return boost::lexical_cast<int>(tok.begin(), tok.size());
+	}
+
+	agi::Time next_time() {
+		auto tok = next_tok_trim();
+		return agi::Time(tok.begin(), tok.end());
+	}
 };
 
+/// Set a field, skipping the flyweight lookup if it already has the value
+void intern(boost::flyweight<std::string>& field, char_range const& value) {
+	if (field.get().size() != value.size() || !std::equal(value.begin(), value.end(), field.get().begin()))
+		field = std::string(value.begin(), value.end());
+}
+}
+
 void AssDialogue::Parse(std::string const& raw) {
-	agi::StringRange str;
+	char_range str;
 	if (boost::starts_with(raw, "Dialogue:")) {
 		Comment = false;
-		str = agi::StringRange(raw.begin() + 10, raw.end());
+		str = char_range(raw.data() + std::min<size_t>(10, raw.size()), raw.data() + raw.size());
 	}
 	else if (boost::starts_with(raw, "Comment:")) {
 		Comment = true;
-		str = agi::StringRange(raw.begin() + 9, raw.end());
+		str = char_range(raw.data() + std::min<size_t>(9, raw.size()), raw.data() + raw.size());
 	}
 	else
 		throw SubtitleFormatParseError("Failed parsing line: " + raw);
@@ -104,46 +127,49 @@ void AssDialogue::Parse(std::string const& raw) {
 	tokenizer tkn(str);
 
 	// Get first token and see if it has "Marked=" in it
-	auto tmp = tkn.next_str_trim();
+	auto tmp = tkn.next_tok_trim();
 	bool ssa = boost::istarts_with(tmp, "marked=");
 
 	// Get layer number
 	if (ssa)
 		Layer = 0;
 	else
-		Layer = boost::lexical_cast<int>(tmp);
-
-	Start = tkn.next_str_trim();
-	End = tkn.next_str_trim();
-	Style = tkn.next_str_trim();
-	Actor = tkn.next_str_trim();
+		Layer = boost::lexical_cast<int>(tmp.begin(), tmp.size());
+
+	// All of the fields are parsed before any are interned so that a
+	// malformed line doesn't do any unneeded work
+	Start = tkn.next_time();
+	End = tkn.next_time();
+	auto style = tkn.next_tok_trim();
+	auto actor = tkn.next_tok_trim();
 	for (int& margin : Margin)
-		margin = mid(0, boost::lexical_cast<int>(tkn.next_str()), 9999);
-	Effect = tkn.next_str_trim();
+		margin = mid(0, tkn.next_int(), 9999);
+	auto effect = tkn.next_tok_trim();
+	auto text = char_range(tkn.next_tok().begin(), str.end());
 
-	std::string text{tkn.next_tok().begin(), str.end()};
+	intern(Style, style);
+	intern(Actor, actor);
+	intern(Effect, effect);
 
 	if (text.size() > 1 && text[0] == '{' && text[1] == '=') {
 		static const boost::regex extradata_test("^\\{(=\\d+)+\\}");
-		boost::match_results<std::string::iterator> rematch;
+		boost::match_results<const char *> rematch;
 		if (boost::regex_search(text.begin(), text.end(), rematch, extradata_test)) {
-			std::string extradata_str = rematch.str(0);
-			text = rematch.suffix().str();
-
 			static const boost::regex idmatcher("=(\\d+)");
-			auto start = extradata_str.begin();
-			auto end = extradata_str.end();
+			auto start = rematch[0].first;
+			auto end = rematch[0].second;
+			text = char_range(end, text.end());
+
 			std::vector<uint32_t> ids;
 			while (boost::regex_search(start, end, rematch, idmatcher)) {
-				auto id = boost::lexical_cast<uint32_t>(rematch.str(1));
-				ids.push_back(id);
-				start = rematch.suffix().first;
+				ids.push_back(boost::lexical_cast<uint32_t>(rematch[1].first, rematch[1].length()));
+				start = rematch[0].second;
 			}
 			ExtradataIds = ids;
 		}
 	}
 
-	Text = text;
+	Text = std::string(text.begin(), text.end());
 }
 
 static void append_int(std::string &str, int v) {
@@ -167,8 +193,14 @@ static void append_unsafe_str(std::string &out, std::string const& str) {
 }
 
 std::string AssDialogue::GetEntryData() const {
-	std::string str = Comment ? "Comment: " : "Dialogue: ";
-	str.reserve(51 + Style.get().size() + Actor.get().size() + Effect.get().size() + Text.get().size());
+	std::string str;
+	str.reserve(61 + Style.get().size() + Actor.get().size() + Effect.get().size() + Text.get().size());
+	AppendEntryData(str);
+	return str;
+}
+
+void AssDialogue::AppendEntryData(std::string& str) const {
+	str += Comment ? "Comment: " : "Dialogue: ";
 
 	append_int(str, Layer);
 	append_str(str, Start.GetAssFormatted());
@@ -192,21 +224,77 @@ std::string AssDialogue::GetEntryData() const {
 		if (c != '\n' && c != '\r')
 			str += c;
 	}
+}
 
-	return str;
+typedef std::vector<std::unique_ptr<AssDialogueBlock>> BlockVector;
+
+struct AssDialogue::TextInfo {
+	/// Reference to the text so that the address used as the cache key can't
+	/// be reused for a different string while the entry exists
+	boost::flyweight<std::string> text;
+	/// The parsed blocks, which are copied for each caller of ParseTags as
+	/// the callers are free to modify them
+	std::shared_ptr<const BlockVector> blocks;
+	/// The text with tags stripped, if it has been needed
+	std::unique_ptr<std::string> stripped;
+	/// Number of characters for each ignore mask, or -1 if not counted yet
+	std::array<int, 8> character_count;
+};
+
+namespace {
+typedef agi::lru_cache<const std::string *, std::shared_ptr<AssDialogue::TextInfo>> TextCache;
+
+/// Information about recently used line texts, keyed on the address of the
+/// interned text so that lookups do not need to hash the whole string
+TextCache& text_cache() {
+	// Constructed on first use so that it is destroyed before the flyweight
+	// factory which owns the strings it holds references to
+	static TextCache cache(16 * 1024 * 1024);
+	return cache;
 }
 
-std::vector<std::unique_ptr<AssDialogueBlock>> AssDialogue::ParseTags() const {
-	std::vector<std::unique_ptr<AssDialogueBlock>> Blocks;
+/// Lines are parsed on background threads when exporting and searching, so
+/// the cache and the entries in it are only touched with this held
+std::mutex text_cache_mutex;
+
+std::shared_ptr<AssDialogue::TextInfo> text_info(boost::flyweight<std::string> const& text) {
+	std::lock_guard<std::mutex> lock(text_cache_mutex);
+	if (auto info = text_cache().get(&text.get()))
+		return *info;
+
+	auto info = std::make_shared<AssDialogue::TextInfo>();
+	info->text = text;
+	info->character_count.fill(-1);
+	// Parsed blocks take a few times as much memory as the text they came
+	// from, and this doesn't need to be exact
+	text_cache().put(&text.get(), info, sizeof(AssDialogue::TextInfo) + text.get().size() * 4);
+	return info;
+}
+
+std::unique_ptr<AssDialogueBlock> copy_block(AssDialogueBlock const& block) {
+	switch (block.GetType()) {
+		case AssBlockType::PLAIN:
+			return agi::make_unique<AssDialogueBlockPlain>(static_cast<AssDialogueBlockPlain const&>(block));
+		case AssBlockType::COMMENT:
+			return agi::make_unique<AssDialogueBlockComment>(static_cast<AssDialogueBlockComment const&>(block));
+		case AssBlockType::DRAWING:
+			return agi::make_unique<AssDialogueBlockDrawing>(static_cast<AssDialogueBlockDrawing const&>(block));
+		case AssBlockType::OVERRIDE:
+		default:
+			return agi::make_unique<AssDialogueBlockOverride>(static_cast<AssDialogueBlockOverride const&>(block));
+	}
+}
+
+BlockVector parse_blocks(std::string const& text) {
+	BlockVector Blocks;
 
 	// Empty line, make an empty block
-	if (Text.get().empty()) {
+	if (text.empty()) {
 		Blocks.push_back(agi::make_unique<AssDialogueBlockPlain>());
 		return Blocks;
 	}
 
 	int drawingLevel = 0;
-	std::string const& text(Text.get());
 
 	for (size_t len = text.size(), cur = 0; cur < len; ) {
 		// Overrides block
@@ -266,6 +354,32 @@ plain:
 	return Blocks;
 }
 
+std::shared_ptr<const BlockVector> cached_blocks(AssDialogue::TextInfo& info) {
+	{
+		std::lock_guard<std::mutex> lock(text_cache_mutex);
+		if (info.blocks) return info.blocks;
+	}
+
+	// Parse without holding the lock; if two threads parse the same text at
+	// once one of the results is simply discarded
+	auto blocks = std::make_shared<const BlockVector>(parse_blocks(info.text.get()));
+	std::lock_guard<std::mutex> lock(text_cache_mutex);
+	if (!info.blocks)
+		info.blocks = blocks;
+	return info.blocks;
+}
+}
+
+std::vector<std::unique_ptr<AssDialogueBlock>> AssDialogue::ParseTags() const {
+	auto blocks = cached_blocks(*text_info(Text));
+
+	std::vector<std::unique_ptr<AssDialogueBlock>> Blocks;
+	Blocks.reserve(blocks->size());
+	for (auto const& block : *blocks)
+		Blocks.push_back(copy_block(*block));
+	return Blocks;
+}
+
 void AssDialogue::StripTags() {
 	Text = GetStrippedText();
 }
@@ -281,8 +395,40 @@ bool AssDialogue::CollidesWith(const AssDialogue *target) const {
 	return ((Start < target->Start) ? (target->Start < End) : (Start < target->End));
 }
 
-static std::string get_text_p(AssDialogueBlock *d) { return d->GetText(); }
 std::string AssDialogue::GetStrippedText() const {
-	auto blocks = ParseTags();
-	return join(blocks | agi::of_type<AssDialogueBlockPlain>() | transformed(get_text_p), "");
+	auto info = text_info(Text);
+	{
+		std::lock_guard<std::mutex> lock(text_cache_mutex);
+		if (info->stripped) return *info->stripped;
+	}
+
+	std::string stripped;
+	for (auto const& block : *cached_blocks(*info)) {
+		if (block->GetType() == AssBlockType::PLAIN)
+			stripped += static_cast<AssDialogueBlockPlain const&>(*block).text;
+	}
+
+	std::lock_guard<std::mutex> lock(text_cache_mutex);
+	if (!info->stripped)
+		info->stripped = agi::make_unique<std::string>(stripped);
+	return stripped;
+}
+
+size_t AssDialogue::CharacterCount(int ignore_mask) const {
+	auto info = text_info(Text);
+	auto& count = info->character_count[ignore_mask & 7];
+	{
+		std::lock_guard<std::mutex> lock(text_cache_mutex);
+		if (count >= 0) return count;
+	}
+
+	size_t ret = agi::CharacterCount(Text, ignore_mask);
+	std::lock_guard<std::mutex> lock(text_cache_mutex);
+	count = static_cast<int>(ret);
+	return ret;
+}
+
+AssDialogue::TextCacheStats AssDialogue::GetTextCacheStats() {
+	std::lock_guard<std::mutex> lock(text_cache_mutex);
+	return text_cache().get_stats();
 }
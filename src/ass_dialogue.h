@@ -31,6 +31,7 @@
 #include "ass_override.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/lru_cache.h>
 
 #include <array>
 #include <boost/flyweight.hpp>
@@ -161,10 +162,23 @@ public:
 	/// Strip a specific ASS tag from the text
 	/// Get text without tags
 	std::string GetStrippedText() const;
+	/// Get the number of characters in the text
+	/// @param ignore_mask agi::IGNORE_* flags to pass to agi::CharacterCount
+	size_t CharacterCount(int ignore_mask) const;
+
+	/// Information derived from a line's text which is cached and shared by
+	/// every line with the same text
+	struct TextInfo;
+	typedef agi::lru_cache<const std::string *, std::shared_ptr<TextInfo>>::stats TextCacheStats;
+	/// Get the hit counters of the text information cache
+	static TextCacheStats GetTextCacheStats();
 
 	/// Update the text of the line from parsed blocks
 	void UpdateText(std::vector<std::unique_ptr<AssDialogueBlock>>& blocks);
 	std::string GetEntryData() const;
+	/// Append the line as it is written to a file to a string, which avoids
+	/// allocating a string for each line when writing many lines
+	void AppendEntryData(std::string& str) const;
 
 	/// Does this line collide with the passed line?
 	bool CollidesWith(const AssDialogue *target) const;
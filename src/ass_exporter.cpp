@@ -85,6 +85,9 @@ void AssExporter::Export(agi::fs::path const& filename, std::string const& chars
 	for (auto filter : filters) {
 		filter->LoadSettings(is_default, c);
 		filter->ProcessSubs(&subs, export_dialog);
+		// The copy isn't committed, so let later filters see the changes in
+		// the file's time index
+		subs.LinesChanged(AssFile::COMMIT_DIAG_ADDREM);
 	}
 
 	const SubtitleFormat *writer = SubtitleFormat::GetWriter(filename);
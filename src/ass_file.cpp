@@ -77,6 +77,27 @@ AssFile::AssFile(const AssFile &from)
 		[](AssDialogue *e) { delete e; });
 }
 
+AssFile::AssFile(AssFileSnapshot const& snapshot)
+: Attachments(*snapshot.attachments)
+, Extradata(*snapshot.extradata)
+, next_extradata_id(snapshot.next_extradata_id)
+{
+	Info.reserve(snapshot.script_info->size());
+	for (auto const& info : *snapshot.script_info)
+		Info.emplace_back(info.first, info.second);
+	for (auto const& style : *snapshot.styles)
+		Styles.push_back(*new AssStyle(style));
+
+	int row = 0;
+	for (auto const& chunk : snapshot.events) {
+		for (auto const& line : *chunk) {
+			auto diag = new AssDialogue(*line);
+			diag->Row = row++;
+			Events.push_back(*diag);
+		}
+	}
+}
+
 void AssFile::swap(AssFile& from) throw() {
 	Info.swap(from.Info);
 	Styles.swap(from.Styles);
@@ -85,6 +106,9 @@ void AssFile::swap(AssFile& from) throw() {
 	Extradata.swap(from.Extradata);
 	std::swap(Properties, from.Properties);
 	std::swap(next_extradata_id, from.next_extradata_id);
+	std::swap(time_index, from.time_index);
+	std::swap(time_index_state, from.time_index_state);
+	std::swap(time_index_line, from.time_index_line);
 }
 
 AssFile& AssFile::operator=(AssFile from) {
@@ -175,13 +199,124 @@ int AssFile::Commit(wxString const& desc, int type, int amend_id, AssDialogue *s
 			event.Row = i++;
 	}
 
-	PushState({desc, &amend_id, single_line});
+	LinesChanged(type, single_line);
+
+	PushState({desc, &amend_id, single_line, type});
 
 	AnnounceCommit(type, single_line);
 
 	return amend_id;
 }
 
+void AssFile::LinesChanged(int type, AssDialogue *single_line) {
+	if (type == COMMIT_NEW || (type & COMMIT_DIAG_ADDREM))
+		time_index_state = IndexState::Rebuild;
+	else if (!(type & COMMIT_DIAG_TIME))
+		return;
+	else if (time_index_state == IndexState::Current && single_line) {
+		time_index_state = IndexState::SingleLine;
+		time_index_line = single_line;
+	}
+	else if (time_index_state == IndexState::Current
+		|| (time_index_state == IndexState::SingleLine && time_index_line != single_line))
+		time_index_state = IndexState::Times;
+}
+
+void AssFile::UpdateTimeIndex() {
+	switch (time_index_state) {
+	case IndexState::Current:
+		return;
+
+	case IndexState::Rebuild: {
+		// Removed lines have already been deleted, so the old entries can't
+		// be checked against the lines and the index has to start over
+		std::vector<agi::interval_index<AssDialogue *>::interval> intervals;
+		intervals.reserve(time_index.size());
+		for (auto& line : Events)
+			intervals.push_back({line.Start, line.End, &line});
+		time_index.assign(std::move(intervals));
+		break;
+	}
+
+	case IndexState::SingleLine: {
+		auto line = time_index_line;
+		time_index.erase_if([=](agi::interval_index<AssDialogue *>::interval const& i) { return i.value == line; });
+		time_index.insert(line->Start, line->End, line);
+		break;
+	}
+
+	case IndexState::Times: {
+		// Every indexed line still exists, so find the ones which moved
+		std::vector<AssDialogue *> moved;
+		for (auto const& i : time_index.intervals()) {
+			if (i.start != i.value->Start || i.end != i.value->End)
+				moved.push_back(i.value);
+		}
+
+		if (moved.size() > time_index.size() / 8) {
+			time_index_state = IndexState::Rebuild;
+			return UpdateTimeIndex();
+		}
+
+		time_index.erase_if([](agi::interval_index<AssDialogue *>::interval const& i) {
+			return i.start != i.value->Start || i.end != i.value->End;
+		});
+		for (auto line : moved)
+			time_index.insert(line->Start, line->End, line);
+		break;
+	}
+	}
+
+	time_index_state = IndexState::Current;
+	time_index_line = nullptr;
+}
+
+std::vector<AssDialogue *> AssFile::LinesInRange(int start, int end) {
+	UpdateTimeIndex();
+
+	std::vector<AssDialogue *> lines;
+	time_index.for_each_overlapping(start, end, [&](agi::interval_index<AssDialogue *>::interval const& i) {
+		lines.push_back(i.value);
+	});
+	sort(lines.begin(), lines.end(), [](AssDialogue *lft, AssDialogue *rgt) { return lft->Row < rgt->Row; });
+	return lines;
+}
+
+std::vector<AssDialogue *> AssFile::LinesByStart() {
+	UpdateTimeIndex();
+
+	std::vector<AssDialogue *> lines;
+	lines.reserve(time_index.size());
+	for (auto const& i : time_index.intervals())
+		lines.push_back(i.value);
+	return lines;
+}
+
+std::vector<AssDialogue *> AssFile::OverlappingLines(const AssDialogue *line) {
+	auto lines = LinesInRange(line->Start, line->End);
+	lines.erase(remove_if(begin(lines), end(lines), [=](AssDialogue *other) {
+		return other == line || !(other->Start < line->End && line->Start < other->End);
+	}), end(lines));
+	return lines;
+}
+
+std::vector<std::pair<AssDialogue *, AssDialogue *>> AssFile::OverlappingPairs() {
+	UpdateTimeIndex();
+
+	std::vector<std::pair<AssDialogue *, AssDialogue *>> pairs;
+	time_index.for_each_overlapping_pair([&](agi::interval_index<AssDialogue *>::interval const& a, agi::interval_index<AssDialogue *>::interval const& b) {
+		if (a.value->Row < b.value->Row)
+			pairs.emplace_back(a.value, b.value);
+		else
+			pairs.emplace_back(b.value, a.value);
+	});
+	sort(pairs.begin(), pairs.end(), [](std::pair<AssDialogue *, AssDialogue *> const& lft, std::pair<AssDialogue *, AssDialogue *> const& rgt) {
+		return lft.first->Row < rgt.first->Row
+			|| (lft.first == rgt.first && lft.second->Row < rgt.second->Row);
+	});
+	return pairs;
+}
+
 bool AssFile::CompStart(AssDialogue const& lft, AssDialogue const& rgt) {
 	return lft.Start < rgt.Start;
 }
@@ -30,15 +30,20 @@
 #include "ass_entry.h"
 
 #include <libaegisub/fs_fwd.h>
+#include <libaegisub/interval_index.h>
 #include <libaegisub/signal.h>
 
 #include <boost/intrusive/list.hpp>
 #include <map>
+#include <memory>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 class AssAttachment;
 class AssDialogue;
+struct AssDialogueBase;
 class AssInfo;
 class AssStyle;
 class wxString;
@@ -56,6 +61,8 @@ struct AssFileCommit {
 	wxString const& message;
 	int *commit_id;
 	AssDialogue *single_line;
+	/// Type of changes made (AssFile::CommitType)
+	int type;
 };
 
 struct ProjectProperties {
@@ -78,10 +85,43 @@ struct ProjectProperties {
 	int video_position = 0;
 };
 
+/// @class AssFileSnapshot
+/// @brief An immutable copy of the contents of an AssFile
+///
+/// Each part of the file is held in shared immutable storage, so copying a
+/// snapshot is cheap and successive snapshots of a file share everything
+/// which didn't change between them. Snapshots can be read from any thread
+/// while the file they were taken from continues to be edited.
+struct AssFileSnapshot {
+	typedef std::vector<std::shared_ptr<const AssDialogueBase>> EventChunk;
+
+	std::shared_ptr<const std::vector<std::pair<std::string, std::string>>> script_info;
+	std::shared_ptr<const std::vector<AssStyle>> styles;
+	/// The dialogue lines in blocks which are shared separately, so that
+	/// changing a line only requires copying the block containing it
+	std::vector<std::shared_ptr<const EventChunk>> events;
+	std::shared_ptr<const std::vector<AssAttachment>> attachments;
+	std::shared_ptr<const std::vector<ExtradataEntry>> extradata;
+	uint32_t next_extradata_id = 0;
+};
+
 class AssFile {
 	/// A set of changes has been committed to the file (AssFile::COMMITType)
 	agi::signal::Signal<int, const AssDialogue*> AnnounceCommit;
 	agi::signal::Signal<AssFileCommit> PushState;
+
+	/// Start and end times of the dialogue lines
+	agi::interval_index<AssDialogue *> time_index;
+	/// What needs to be done to bring time_index up to date
+	enum class IndexState {
+		Current,    ///< Nothing
+		SingleLine, ///< The times of time_index_line have changed
+		Times,      ///< The times of any lines may have changed
+		Rebuild     ///< Lines may have been added or removed
+	} time_index_state = IndexState::Rebuild;
+	AssDialogue *time_index_line = nullptr;
+
+	void UpdateTimeIndex();
 public:
 	/// The lines in the file
 	std::vector<AssInfo> Info;
@@ -95,6 +135,8 @@ public:
 
 	AssFile();
 	AssFile(const AssFile &from);
+	/// Make a mutable copy of a snapshot
+	explicit AssFile(AssFileSnapshot const& snapshot);
 	AssFile& operator=(AssFile from);
 	~AssFile();
 
@@ -179,6 +221,46 @@ public:
 	/// @return Unique identifier for the new undo group
 	int Commit(wxString const& desc, int type, int commitId = -1, AssDialogue *single_line = nullptr);
 
+	/// @brief Record changes made to the lines without committing them
+	/// @param type        Type of changes made (AssFile::CommitType)
+	/// @param single_line Line which was changed, if only one line was
+	///
+	/// Commit does this itself, so this is only needed for files which are
+	/// not committed, such as private copies of the project's file.
+	void LinesChanged(int type, AssDialogue *single_line = nullptr);
+
+	/// @brief Get the dialogue lines overlapping a range of times
+	/// @param start First time in the range, in milliseconds
+	/// @param end   Last time in the range, in milliseconds
+	/// @return Lines with Start <= end and End > start, in file order
+	///
+	/// The lines are found with an index which is updated as changes are
+	/// committed, so changes to the times of lines which have not yet been
+	/// committed or passed to LinesChanged may not be reflected in the result.
+	std::vector<AssDialogue *> LinesInRange(int start, int end);
+	/// Get the dialogue lines visible at the given time, in file order
+	std::vector<AssDialogue *> LinesAt(int time) { return LinesInRange(time, time); }
+	/// @brief Get all of the dialogue lines in order of start time
+	///
+	/// Lines with the same start time are in file order if their times have
+	/// not changed since they were loaded. This reads the time index, so it
+	/// takes O(n) time rather than sorting the lines.
+	std::vector<AssDialogue *> LinesByStart();
+
+	/// @brief Get the dialogue lines which overlap a line, in file order
+	///
+	/// Lines overlap if each starts before the other ends, so lines which
+	/// only touch do not overlap. The line itself is not included.
+	std::vector<AssDialogue *> OverlappingLines(const AssDialogue *line);
+	/// @brief Get every pair of overlapping dialogue lines
+	/// @return Pairs with the line earlier in the file first, in file order
+	///
+	/// This uses the same index as LinesInRange, and takes O(n log n + k)
+	/// time for k pairs rather than comparing every pair of lines. Callers
+	/// which only care about collisions within a layer or style can filter
+	/// the pairs.
+	std::vector<std::pair<AssDialogue *, AssDialogue *>> OverlappingPairs();
+
 	/// Comparison function for use when sorting
 	typedef bool (*CompFunc)(AssDialogue const& lft, AssDialogue const& rgt);
 
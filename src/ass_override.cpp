@@ -52,6 +52,21 @@ AssOverrideParameter::AssOverrideParameter(VariableDataType type, AssParameterCl
 {
 }
 
+AssOverrideParameter::AssOverrideParameter(AssOverrideParameter const& other)
+: value(other.value)
+, block(other.block ? agi::make_unique<AssDialogueBlockOverride>(*other.block) : nullptr)
+, type(other.type)
+, classification(other.classification)
+, omitted(other.omitted)
+{
+}
+
+AssOverrideParameter& AssOverrideParameter::operator=(AssOverrideParameter const& other) {
+	if (this != &other)
+		*this = AssOverrideParameter(other);
+	return *this;
+}
+
 AssOverrideParameter::~AssOverrideParameter() = default;
 
 template<> std::string AssOverrideParameter::Get<std::string>() const {
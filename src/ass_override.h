@@ -69,7 +69,9 @@ class AssOverrideParameter {
 
 public:
 	AssOverrideParameter(VariableDataType type, AssParameterClass classification);
+	AssOverrideParameter(AssOverrideParameter const&);
 	AssOverrideParameter(AssOverrideParameter&&) = default;
+	AssOverrideParameter& operator=(AssOverrideParameter const&);
 	AssOverrideParameter& operator=(AssOverrideParameter&&) = default;
 	~AssOverrideParameter();
 
@@ -93,7 +95,9 @@ class AssOverrideTag {
 public:
 	AssOverrideTag() = default;
 	AssOverrideTag(std::string const& text);
+	AssOverrideTag(AssOverrideTag const&) = default;
 	AssOverrideTag(AssOverrideTag&&) = default;
+	AssOverrideTag& operator=(AssOverrideTag const&) = default;
 	AssOverrideTag& operator=(AssOverrideTag&&) = default;
 
 	std::string Name;
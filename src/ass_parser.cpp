@@ -99,6 +99,7 @@ AssParser::AssParser(AssFile *target, int version)
 , target(target)
 , version(version)
 , state(&AssParser::ParseScriptInfoLine)
+, events([](std::string& data) { return agi::make_unique<AssDialogue>(data); }, 2000)
 {
 }
 
@@ -178,7 +179,7 @@ void AssParser::ParseMetadataLine(std::string const& data) {
 
 void AssParser::ParseEventLine(std::string const& data) {
 	if (boost::starts_with(data, "Dialogue:") || boost::starts_with(data, "Comment:"))
-		target->Events.push_back(*new AssDialogue(data));
+		events.add(data);
 }
 
 void AssParser::ParseStyleLine(std::string const& data) {
@@ -223,6 +224,12 @@ void AssParser::ParseExtradataLine(std::string const &data) {
 	}
 }
 
+void AssParser::Finish() {
+	events.finish([&](std::unique_ptr<AssDialogue> line) {
+		target->Events.push_back(*line.release());
+	});
+}
+
 void AssParser::AddLine(std::string const& data) {
 	// Special-case for attachments since a line could theoretically be both a
 	// valid attachment data line and a valid section header, and if an
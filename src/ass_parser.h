@@ -12,9 +12,13 @@
 // ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
 // OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <libaegisub/parallel_batches.h>
+
 #include <memory>
+#include <string>
 
 class AssAttachment;
+class AssDialogue;
 class AssFile;
 
 class AssParser {
@@ -25,6 +29,8 @@ class AssParser {
 	int version;
 	std::unique_ptr<AssAttachment> attach;
 	void (AssParser::*state)(std::string const&);
+	/// Dialogue lines being parsed on background threads
+	agi::parallel_batches<std::string, std::unique_ptr<AssDialogue>> events;
 
 	void ParseAttachmentLine(std::string const& data);
 	void ParseEventLine(std::string const& data);
@@ -40,4 +46,10 @@ public:
 	~AssParser();
 
 	void AddLine(std::string const& data);
+
+	/// @brief Wait for the dialogue lines to be parsed and add them to the file
+	///
+	/// Must be called after the last line has been added, as parsing the
+	/// events is done in the background.
+	void Finish();
 };
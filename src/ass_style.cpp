@@ -53,20 +53,33 @@ AssStyle::AssStyle() {
 AssEntryGroup AssStyle::Group() const { return AssEntryGroup::STYLE; }
 
 namespace {
+typedef boost::iterator_range<const char *> char_range;
+
 class parser {
-	agi::split_iterator<agi::StringRange::const_iterator> pos;
+	agi::split_iterator<const char *> pos;
 
-	std::string next_tok() {
+	char_range next_tok() {
 		if (pos.eof())
 			throw SubtitleFormatParseError("Malformed style: not enough fields");
-		return agi::str(trim_copy(*pos++));
+		return trim_copy(*pos++);
+	}
+
+	template<typename T>
+	T next_number(const char *error) {
+		auto tok = next_tok();
+		try {
+			return boost::lexical_cast<T>(tok.begin(), tok.size());
+		}
+		catch (boost::bad_lexical_cast const&) {
+			throw SubtitleFormatParseError(error);
+		}
 	}
 
 public:
 	parser(std::string const& str) {
-		auto colon = find(str.begin(), str.end(), ':');
-		if (colon != str.end())
-			pos = agi::Split(agi::StringRange(colon + 1, str.end()), ',');
+		auto colon = std::find(str.data(), str.data() + str.size(), ':');
+		if (colon != str.data() + str.size())
+			pos = agi::Split(char_range(colon + 1, str.data() + str.size()), ',');
 	}
 
 	void check_done() const {
@@ -74,26 +87,15 @@ public:
 			throw SubtitleFormatParseError("Malformed style: too many fields");
 	}
 
-	std::string next_str() { return next_tok(); }
-	agi::Color next_color() { return next_tok(); }
-
-	int next_int() {
-		try {
-			return boost::lexical_cast<int>(next_tok());
-		}
-		catch (boost::bad_lexical_cast const&) {
-			throw SubtitleFormatParseError("Malformed style: bad int field");
-		}
+	std::string next_str() {
+		auto tok = next_tok();
+		return std::string(tok.begin(), tok.end());
 	}
 
-	double next_double() {
-		try {
-			return boost::lexical_cast<double>(next_tok());
-		}
-		catch (boost::bad_lexical_cast const&) {
-			throw SubtitleFormatParseError("Malformed style: bad double field");
-		}
-	}
+	// Colors are short enough that the string doesn't allocate
+	agi::Color next_color() { return next_str(); }
+	int next_int() { return next_number<int>("Malformed style: bad int field"); }
+	double next_double() { return next_number<double>("Malformed style: bad double field"); }
 
 	void skip_token() {
 		if (!pos.eof())
@@ -20,37 +20,41 @@
 #include "ass_file.h"
 #include "export_fixstyle.h"
 #include "include/aegisub/subtitles_provider.h"
+#include "options.h"
 #include "video_frame.h"
 #include "video_provider_manager.h"
 
 #include <libaegisub/dispatch.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
 
 enum {
 	NEW_SUBS_FILE = -1,
 	SUBS_FILE_ALREADY_LOADED = -2
 };
 
-std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, double time, bool raw) {
-	// Find an unused buffer to use or allocate a new one if needed
-	std::shared_ptr<VideoFrame> frame;
+/// Find an unused buffer to use or allocate a new one if needed
+static std::shared_ptr<VideoFrame> get_buffer(std::vector<std::shared_ptr<VideoFrame>>& buffers) {
 	for (auto& buffer : buffers) {
-		if (buffer.use_count() == 1) {
-			frame = buffer;
-			break;
-		}
+		if (buffer.use_count() == 1)
+			return buffer;
 	}
 
-	if (!frame) {
-		frame = std::make_shared<VideoFrame>();
-		buffers.push_back(frame);
-	}
+	buffers.push_back(std::make_shared<VideoFrame>());
+	return buffers.back();
+}
 
+std::shared_ptr<VideoFrame> AsyncVideoProvider::DecodeFrame(int frame_number) {
+	auto frame = get_buffer(raw_buffers);
 	try {
 		source_provider->GetFrame(frame_number, *frame);
 	}
 	catch (VideoProviderError const& err) { throw VideoProviderErrorEvent(err); }
+	return frame;
+}
 
-	if (raw || !subs_provider || !subs) return frame;
+std::shared_ptr<VideoFrame> AsyncVideoProvider::RenderFrame(std::shared_ptr<VideoFrame> const& raw, int frame_number, double time) {
+	if (!subs_provider || !subs) return raw;
 
 	try {
 		if (single_frame != frame_number && single_frame != SUBS_FILE_ALREADY_LOADED) {
@@ -73,6 +77,11 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, doub
 	}
 	catch (agi::Exception const& err) { throw SubtitlesProviderErrorEvent(err.GetMessage()); }
 
+	// The raw frame is kept for re-rendering after subtitle changes, so draw
+	// onto a copy of it
+	auto frame = get_buffer(buffers);
+	*frame = *raw;
+
 	try {
 		subs_provider->DrawSubtitles(*frame, time / 1000.);
 	}
@@ -93,23 +102,41 @@ static std::unique_ptr<SubtitlesProvider> get_subs_provider(wxEvtHandler *evt_ha
 
 AsyncVideoProvider::AsyncVideoProvider(agi::fs::path const& video_filename, std::string const& colormatrix, wxEvtHandler *parent, agi::BackgroundRunner *br)
 : worker(agi::dispatch::Create())
+, render_worker(agi::dispatch::Create())
 , subs_provider(get_subs_provider(parent, br))
 , source_provider(VideoProviderFactory::GetProvider(video_filename, colormatrix, br))
 , parent(parent)
+, read_ahead_buffer(agi::make_unique<VideoFrame>())
 {
+	if (source_provider->IsCaching()) {
+		// Reading ahead further than fits in the cache would evict the frames
+		// decoded ahead before they are requested
+		size_t frame_size = (size_t)source_provider->GetWidth() * source_provider->GetHeight() * 4;
+		size_t cache_size = (size_t)OPT_GET("Provider/Video/Cache/Size")->GetInt() << 20;
+		int fits = (int)(cache_size / std::max<size_t>(frame_size, 1));
+		read_ahead = std::max(0, std::min<int>(OPT_GET("Provider/Video/Cache/Read Ahead")->GetInt(), fits - 2));
+	}
 }
 
 AsyncVideoProvider::~AsyncVideoProvider() {
-	// Block until all currently queued jobs are complete
+	// Block until all currently queued jobs are complete. Decoding jobs can
+	// queue rendering jobs, so the decoding queue has to be flushed first.
 	worker->Sync([]{});
+	render_worker->Sync([]{});
+
+	if (read_ahead_hits + read_ahead_misses > 0)
+		LOG_I("video/read_ahead")
+			<< "hits: " << read_ahead_hits
+			<< " misses: " << read_ahead_misses
+			<< " hit rate: " << 100 * read_ahead_hits / (read_ahead_hits + read_ahead_misses) << "%";
 }
 
-void AsyncVideoProvider::LoadSubtitles(const AssFile *new_subs) throw() {
+void AsyncVideoProvider::LoadSubtitles(std::shared_ptr<const AssFileSnapshot> new_subs) throw() {
+	if (!new_subs) return;
 	uint_fast32_t req_version = ++version;
 
-	auto copy = new AssFile(*new_subs);
-	worker->Async([=]{
-		subs.reset(copy);
+	QueueRender([=]{
+		subs = agi::make_unique<AssFile>(*new_subs);
 		single_frame = NEW_SUBS_FILE;
 		ProcAsync(req_version, false);
 	});
@@ -121,29 +148,103 @@ void AsyncVideoProvider::UpdateSubtitles(const AssFile *new_subs, const AssDialo
 	// Copy just the line which were changed, then replace the line at the
 	// same index in the worker's copy of the file with the new entry
 	auto copy = new AssDialogue(*changed);
-	worker->Async([=]{
-		int i = 0;
+	QueueRender([=]{
 		auto it = subs->Events.begin();
-		std::advance(it, copy->Row - i);
-		i = copy->Row;
-		subs->Events.insert(it, *copy);
-		delete &*it--;
+		std::advance(it, copy->Row);
+		static_cast<AssDialogueBase&>(*it) = *copy;
+		delete copy;
+		subs->LinesChanged(AssFile::COMMIT_DIAG_FULL, &*it);
 
 		single_frame = NEW_SUBS_FILE;
 		ProcAsync(req_version, true);
 	});
 }
 
-void AsyncVideoProvider::RequestFrame(int new_frame, double new_time) throw() {
-	uint_fast32_t req_version = ++version;
+void AsyncVideoProvider::QueueRender(std::function<void ()> job) {
+	// Rendering jobs have to run after the rendering for any frame requests
+	// made before them, but if all of those have already been decoded there's
+	// no need to wait for the decoding queue (which may be busy reading ahead)
+	if (pending_decodes == 0)
+		render_worker->Async(job);
+	else
+		worker->Async([=]{ render_worker->Async(job); });
+}
 
-	worker->Async([=]{
+void AsyncVideoProvider::ProcDecode(uint_fast32_t req_version, uint_fast32_t req_frame_version, int new_frame, double new_time, bool moved) {
+	// Don't bother decoding frames which have already been superseded by a
+	// newer request, but do decode them if only the subtitles have changed
+	// since then, as the subtitle changes will be rendered onto this frame
+	if (req_frame_version < frame_version) return;
+
+	if (read_ahead && moved) {
+		if (read_ahead_frames.count(new_frame))
+			++read_ahead_hits;
+		else
+			++read_ahead_misses;
+
+		// Forget frames which have probably been evicted from the cache
+		read_ahead_frames.erase(read_ahead_frames.begin(), read_ahead_frames.lower_bound(new_frame - read_ahead));
+		read_ahead_frames.erase(read_ahead_frames.upper_bound(new_frame + read_ahead), read_ahead_frames.end());
+	}
+
+	std::shared_ptr<VideoFrame> raw;
+	try {
+		raw = DecodeFrame(new_frame);
+	}
+	catch (wxEvent const& err) {
+		parent->QueueEvent(err.Clone());
+		return;
+	}
+
+	// Rendering happens on its own queue so that the decoding queue can move
+	// on to the next request or read-ahead frame in the meantime
+	render_worker->Async([=]{
 		time = new_time;
 		frame_number = new_frame;
+		raw_frame = raw;
 		ProcAsync(req_version, false);
 	});
 }
 
+void AsyncVideoProvider::RequestFrame(int new_frame, double new_time) throw() {
+	uint_fast32_t req_version = ++version;
+	uint_fast32_t req_frame_version = ++frame_version;
+
+	const bool moved = new_frame != last_requested;
+	const bool backwards = new_frame < last_requested;
+	last_requested = new_frame;
+
+	++pending_decodes;
+	worker->Async([=]{
+		ProcDecode(req_version, req_frame_version, new_frame, new_time, moved);
+		--pending_decodes;
+	});
+
+	if (!read_ahead || !moved) return;
+
+	// Queue each frame as a separate job so that a new request only has to
+	// wait for at most one speculative decode. Stepping backwards is usually
+	// one frame at a time and backwards decoding is expensive, so only read
+	// one frame behind in that case.
+	const int step = backwards ? -1 : 1;
+	const int count = backwards ? 1 : read_ahead;
+	for (int i = 1; i <= count; ++i)
+		worker->Async([=]{ ReadAhead(req_frame_version, new_frame + i * step); });
+}
+
+void AsyncVideoProvider::ReadAhead(uint_fast32_t req_frame_version, int frame) {
+	if (req_frame_version < frame_version || frame < 0 || frame >= source_provider->GetFrameCount()) return;
+	if (read_ahead_frames.count(frame)) return;
+
+	try {
+		source_provider->GetFrame(frame, *read_ahead_buffer);
+		read_ahead_frames.insert(frame);
+	}
+	catch (VideoProviderError const&) {
+		// Reported if and when the frame is actually requested
+	}
+}
+
 bool AsyncVideoProvider::NeedUpdate(std::vector<AssDialogueBase const*> const& visible_lines) {
 	// Always need to render after a seek
 	if (single_frame != NEW_SUBS_FILE || frame_number != last_rendered)
@@ -175,12 +276,12 @@ bool AsyncVideoProvider::NeedUpdate(std::vector<AssDialogueBase const*> const& v
 
 void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated) {
 	// Only actually produce the frame if there's no queued changes waiting
-	if (req_version < version || frame_number < 0) return;
+	if (req_version < version || frame_number < 0 || !raw_frame) return;
 
 	std::vector<AssDialogueBase const*> visible_lines;
-	for (auto const& line : subs->Events) {
-		if (!line.Comment && !(line.Start > time || line.End <= time))
-			visible_lines.push_back(&line);
+	for (auto line : subs->LinesAt((int)time)) {
+		if (!line->Comment)
+			visible_lines.push_back(line);
 	}
 
 	if (check_updated && !NeedUpdate(visible_lines)) return;
@@ -192,7 +293,7 @@ void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated
 	last_rendered = frame_number;
 
 	try {
-		FrameReadyEvent *evt = new FrameReadyEvent(ProcFrame(frame_number, time), time);
+		FrameReadyEvent *evt = new FrameReadyEvent(RenderFrame(raw_frame, frame_number, time), time);
 		evt->SetEventType(EVT_FRAME_READY);
 		parent->QueueEvent(evt);
 	}
@@ -204,12 +305,17 @@ void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated
 
 std::shared_ptr<VideoFrame> AsyncVideoProvider::GetFrame(int frame, double time, bool raw) {
 	std::shared_ptr<VideoFrame> ret;
-	worker->Sync([&]{ ret = ProcFrame(frame, time, raw); });
+	worker->Sync([&]{ ret = DecodeFrame(frame); });
+	if (!raw)
+		render_worker->Sync([&]{ ret = RenderFrame(ret, frame, time); });
 	return ret;
 }
 
 void AsyncVideoProvider::SetColorSpace(std::string const& matrix) {
-	worker->Async([=] { source_provider->SetColorSpace(matrix); });
+	worker->Async([=] {
+		source_provider->SetColorSpace(matrix);
+		read_ahead_frames.clear();
+	});
 }
 
 wxDEFINE_EVENT(EVT_FRAME_READY, FrameReadyEvent);
@@ -20,6 +20,7 @@
 #include <libaegisub/fs_fwd.h>
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <set>
 #include <wx/event.h>
@@ -30,6 +31,7 @@ class SubtitlesProvider;
 class VideoProvider;
 class VideoProviderError;
 struct AssDialogueBase;
+struct AssFileSnapshot;
 struct VideoFrame;
 namespace agi {
 	class BackgroundRunner;
@@ -37,9 +39,17 @@ namespace agi {
 }
 
 /// An asynchronous video decoding and subtitle rendering wrapper
+///
+/// Decoding and subtitle rendering run on separate serial queues, so that
+/// decoding the next frame overlaps with rendering subtitles onto the current
+/// one. Everything passes through the decoding queue first so that the
+/// rendering queue sees requests in the order they were made.
 class AsyncVideoProvider {
-	/// Asynchronous work queue
+	/// Decoding queue; the only user of source_provider
 	std::unique_ptr<agi::dispatch::Queue> worker;
+	/// Subtitle rendering queue; the only user of subs_provider, subs and
+	/// all of the state about the current frame
+	std::unique_ptr<agi::dispatch::Queue> render_worker;
 
 	/// Subtitles provider
 	std::unique_ptr<SubtitlesProvider> subs_provider;
@@ -50,6 +60,9 @@ class AsyncVideoProvider {
 
 	int frame_number = -1; ///< Last frame number requested
 	double time = -1.; ///< Time of the frame to pass to the subtitle renderer
+	/// Decoded image of frame_number without subtitles, so that subtitle
+	/// changes can be rendered without decoding the frame again
+	std::shared_ptr<VideoFrame> raw_frame;
 
 	/// Copy of the subtitles file to avoid having to touch the project context
 	std::unique_ptr<AssFile> subs;
@@ -67,24 +80,63 @@ class AsyncVideoProvider {
 	/// lines have actually changed
 	bool NeedUpdate(std::vector<AssDialogueBase const*> const& visible_lines);
 
-	std::shared_ptr<VideoFrame> ProcFrame(int frame, double time, bool raw = false);
+	/// Decode a frame into one of raw_buffers; called on the decoding queue
+	std::shared_ptr<VideoFrame> DecodeFrame(int frame);
+	/// Render subtitles onto a copy of a decoded frame; called on the
+	/// rendering queue
+	std::shared_ptr<VideoFrame> RenderFrame(std::shared_ptr<VideoFrame> const& raw, int frame, double time);
 
 	/// Produce a frame if req_version is still the current version
 	void ProcAsync(uint_fast32_t req_version, bool check_updated);
 
+	/// Decode a requested frame and queue rendering subtitles onto it
+	void ProcDecode(uint_fast32_t req_version, uint_fast32_t req_frame_version, int frame, double time, bool moved);
+
+	/// Run a job on the rendering queue after the rendering of all frames
+	/// requested so far
+	void QueueRender(std::function<void ()> job);
+
 	/// Monotonic counter used to drop frames when changes arrive faster than
 	/// they can be rendered
 	std::atomic<uint_fast32_t> version{ 0 };
-
+	/// Version of the most recent RequestFrame, used to skip decoding frames
+	/// which have already been superseded
+	std::atomic<uint_fast32_t> frame_version{ 0 };
+	/// Number of frame requests which have not yet been passed on to the
+	/// rendering queue
+	std::atomic<int> pending_decodes{ 0 };
+
+	/// Frames with subtitles rendered onto them
 	std::vector<std::shared_ptr<VideoFrame>> buffers;
+	/// Decoded frames
+	std::vector<std::shared_ptr<VideoFrame>> raw_buffers;
+
+	/// Number of frames after the requested one to decode into the source
+	/// provider's cache while waiting for the next request, or 0 if the
+	/// source provider doesn't cache frames
+	int read_ahead = 0;
+	/// Last frame number passed to RequestFrame; only used on the main thread
+	int last_requested = -1;
+	/// Frames near the current one which were decoded by read-ahead
+	std::set<int> read_ahead_frames;
+	/// Destination for frames decoded by read-ahead, which are then discarded
+	std::unique_ptr<VideoFrame> read_ahead_buffer;
+	/// Number of requested frames which had been decoded by read-ahead
+	uint64_t read_ahead_hits = 0;
+	/// Number of requested frames which had to be decoded on request
+	uint64_t read_ahead_misses = 0;
+
+	/// Decode a frame into the cache if no frame has been requested since
+	/// the request with version req_frame_version
+	void ReadAhead(uint_fast32_t req_frame_version, int frame);
 
 public:
 	/// @brief Load the passed subtitle file
-	/// @param subs File to load
+	/// @param subs Snapshot of the file to load
 	///
-	/// This function blocks until is it is safe for the calling thread to
-	/// modify subs
-	void LoadSubtitles(const AssFile *subs) throw();
+	/// The rendering queue makes its own copy of the file from the snapshot,
+	/// so this does not have to wait for anything.
+	void LoadSubtitles(std::shared_ptr<const AssFileSnapshot> subs) throw();
 
 	/// @brief Update a previously loaded subtitle file
 	/// @param subs Subtitle file which was last passed to LoadSubtitles
@@ -73,6 +73,9 @@ class AudioDisplay: public wxWindow {
 	/// The current audio renderer
 	std::unique_ptr<AudioRendererBitmapProvider> audio_renderer_provider;
 
+	/// Redraws the display when the renderer finishes calculating data in the background
+	agi::signal::Connection renderer_data_connection;
+
 	/// The controller managing us
 	AudioController *controller = nullptr;
 
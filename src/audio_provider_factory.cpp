@@ -21,10 +21,12 @@
 #include "utils.h"
 
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/file_mapping.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/log.h>
 #include <libaegisub/path.h>
 
+#include <boost/crc.hpp>
 #include <boost/range/iterator_range.hpp>
 
 using namespace agi;
@@ -49,6 +51,45 @@ const factory providers[] = {
 	{"Avisynth", CreateAvisynthAudioProvider, false},
 #endif
 };
+
+/// Get the name of the waveform peak cache file for an audio file
+///
+/// The name is derived from the path, size, modification time and a hash
+/// of the beginning and end of the file's contents, so that a stale cache
+/// is never picked up after the file is replaced or edited.
+fs::path GetPeakCacheFilename(fs::path const& filename, Path const& path_helper) {
+	if (!OPT_GET("Audio/Cache/Peaks/Enabled")->GetBool()) return fs::path();
+
+	try {
+		const uint64_t len = fs::Size(filename);
+		const uint64_t sample_len = 65536;
+
+		boost::crc_32_type hash;
+		hash.process_bytes(filename.string().c_str(), filename.string().size());
+
+		read_file_mapping file(filename);
+		const uint64_t head = std::min(len, sample_len);
+		hash.process_bytes(file.read(0, head), head);
+		if (len > head) {
+			const uint64_t tail = std::min(len - head, sample_len);
+			hash.process_bytes(file.read(len - tail, tail), tail);
+		}
+
+		auto result = path_helper.Decode("?local/peakcache/" + std::to_string(hash.checksum()) + "_" + std::to_string(len) + "_" + std::to_string(fs::ModifiedTime(filename)) + ".peaks");
+		fs::CreateDirectory(result.parent_path());
+
+		CleanCache(result.parent_path(), "*.peaks",
+			OPT_GET("Audio/Cache/Peaks/Size")->GetInt(),
+			OPT_GET("Audio/Cache/Peaks/Files")->GetInt());
+
+		return result;
+	}
+	catch (agi::Exception const& e) {
+		// Not being able to cache the peaks shouldn't stop the audio from loading
+		LOG_D("audio_provider") << "Not caching waveform peaks: " << e.GetMessage();
+	}
+	return fs::path();
+}
 }
 
 std::vector<std::string> GetAudioProviderNames() {
@@ -112,8 +153,10 @@ std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
 	if (!cache || !needs_cache)
 		return CreateLockAudioProvider(std::move(provider));
 
+	auto peak_file = GetPeakCacheFilename(filename, path_helper);
+
 	// Convert to RAM
-	if (cache == 1) return CreateRAMAudioProvider(std::move(provider));
+	if (cache == 1) return CreateRAMAudioProvider(std::move(provider), peak_file);
 
 	// Convert to HD
 	if (cache == 2) {
@@ -121,7 +164,7 @@ std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
 		if (path == "default")
 			path = "?temp";
 		auto cache_dir = path_helper.MakeAbsolute(path_helper.Decode(path), "?temp");
-		return CreateHDAudioProvider(std::move(provider), cache_dir);
+		return CreateHDAudioProvider(std::move(provider), cache_dir, peak_file);
 	}
 
 	throw InternalError("Invalid audio caching method");
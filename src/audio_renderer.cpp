@@ -70,6 +70,7 @@ AudioRenderer::AudioRenderer()
 	bitmaps.reserve(AudioStyle_MAX);
 	for (int i = 0; i < AudioStyle_MAX; ++i)
 		bitmaps.emplace_back(256, AudioRendererBitmapCacheBitmapFactory(this));
+	incomplete.resize(AudioStyle_MAX);
 
 	// Make sure there's *some* values for those fields, and in the caches
 	SetMillisecondsPerPixel(1);
@@ -149,6 +150,7 @@ void AudioRenderer::ResetBlockCount()
 	{
 		const size_t total_blocks = NumBlocks(provider->GetNumSamples());
 		for (auto& bmp : bitmaps) bmp.SetBlockCount(total_blocks);
+		for (auto& set : incomplete) set.clear();
 	}
 }
 
@@ -165,9 +167,12 @@ wxBitmap const& AudioRenderer::GetCachedBitmap(const int i, const AudioRendering
 
 	bool created = false;
 	auto& bmp = bitmaps[style].Get(i, &created);
-	if (created)
+	if (created || incomplete[style].count(i))
 	{
-		renderer->Render(bmp, i*cache_bitmap_width, style);
+		if (renderer->Render(bmp, i*cache_bitmap_width, style))
+			incomplete[style].erase(i);
+		else
+			incomplete[style].insert(i);
 		needs_age = true;
 	}
 
@@ -192,7 +197,7 @@ void AudioRenderer::Render(wxDC &dc, wxPoint origin, const int start, const int
 	// And the offset in it to start its use at
 	const int firstbitmapoffset = start % cache_bitmap_width;
 	// The last bitmap required
-	const int lastbitmap = std::min<int>(end / cache_bitmap_width, NumBlocks(provider->GetDecodedSamples()) - 1);
+	const int lastbitmap = std::min<int>(end / cache_bitmap_width, NumBlocks(renderer->GetRenderableSamples()) - 1);
 
 	// Set a clipping region so that the first and last bitmaps don't draw
 	// outside the requested range
@@ -220,6 +225,7 @@ void AudioRenderer::Render(wxDC &dc, wxPoint origin, const int start, const int
 void AudioRenderer::Invalidate()
 {
 	for (auto& bmp : bitmaps) bmp.Age(0);
+	for (auto& set : incomplete) set.clear();
 	needs_age = false;
 }
 
@@ -229,6 +235,11 @@ void AudioRendererBitmapProvider::SetProvider(agi::AudioProvider *const _provide
 		OnSetProvider();
 }
 
+int64_t AudioRendererBitmapProvider::GetRenderableSamples() const
+{
+	return provider ? provider->GetDecodedSamples() : 0;
+}
+
 void AudioRendererBitmapProvider::SetMillisecondsPerPixel(const double new_pixel_ms)
 {
 	if (compare_and_set(pixel_ms, new_pixel_ms))
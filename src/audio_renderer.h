@@ -30,8 +30,11 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
+#include <libaegisub/signal.h>
+
 #include <wx/gdicmn.h>
 
 #include "audio_rendering_style.h"
@@ -91,6 +94,9 @@ class AudioRenderer {
 
 	/// Cached bitmaps for audio ranges
 	std::vector<AudioRendererBitmapCache> bitmaps;
+	/// Indices of cached bitmaps, per style, which were rendered before all
+	/// of their data was available and need to be rendered again
+	std::vector<std::unordered_set<int>> incomplete;
 	/// The maximum allowed size of each bitmap cache, in bytes
 	size_t cache_bitmap_maxsize = 0;
 	/// The maximum allowed size of the renderer's cache, in bytes
@@ -110,7 +116,8 @@ class AudioRenderer {
 	/// @return The requested bitmap
 	///
 	/// Will attempt retrieving the requested bitmap from the cache, creating it
-	/// if the cache doesn't have it.
+	/// if the cache doesn't have it. Bitmaps which were incomplete when they
+	/// were last rendered are rendered again.
 	wxBitmap const& GetCachedBitmap(int i, AudioRenderingStyle style);
 
 	/// @brief Update the block count in the bitmap caches
@@ -222,6 +229,9 @@ public:
 /// Derive from this class to implement a way to render audio to images.
 class AudioRendererBitmapProvider {
 protected:
+	/// Data which was missing from a previous render has become available
+	agi::signal::Signal<> AnnounceDataReady;
+
 	/// Audio provider to use for rendering
 	agi::AudioProvider *provider;
 	/// Horizontal zoom in milliseconds per pixel
@@ -255,10 +265,13 @@ public:
 	/// @param bmp   Bitmap to render to
 	/// @param start First pixel from beginning of the audio stream to render
 	/// @param style Style to render audio in
+	/// @return false if some of the data needed was not available yet and
+	///         placeholders were rendered instead
 	///
 	/// Deriving classes must implement this method. The bitmap in bmp holds
-	/// the width and height to render.
-	virtual void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) = 0;
+	/// the width and height to render. Renderers which return false should
+	/// trigger AnnounceDataReady once more data is available.
+	virtual bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) = 0;
 
 	/// @brief Blank audio rendering function
 	/// @param dc    The device context to render to
@@ -281,10 +294,18 @@ public:
 	/// @param amplitude_scale Scaling factor to zoom to
 	void SetAmplitudeScale(float amplitude_scale);
 
+	/// @brief Get the number of samples from the start of the audio which can be rendered
+	///
+	/// Normally only decoded audio can be rendered, but renderers which can
+	/// work from precomputed data may override this to render further.
+	virtual int64_t GetRenderableSamples() const;
+
 	/// @brief Age any caches the renderer might keep
 	/// @param max_size Maximum size in bytes the caches should be
 	///
 	/// Deriving classes should override this method if they implement any
 	/// kind of caching.
 	virtual void AgeCache(size_t max_size) { }
+
+	DEFINE_SIGNAL_ADDERS(AnnounceDataReady, AddDataReadyListener)
 };
@@ -35,37 +35,34 @@
 #include "audio_renderer_spectrum.h"
 
 #include "audio_colorscheme.h"
-#ifndef WITH_FFTW3
-#include "fft.h"
-#endif
 
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/audio/spectrum.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/make_unique.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #include <wx/image.h>
 #include <wx/dcmemory.h>
 
+namespace {
+/// Number of blocks calculated by each background task
+const size_t blocks_per_job = 16;
+/// Number of columns past the rendered range to calculate in advance
+const int prefetch_columns = 256;
+}
+
 /// Allocates blocks of derived data for the audio spectrum
 struct AudioSpectrumCacheBlockFactory {
-	typedef std::unique_ptr<float, std::default_delete<float[]>> BlockType;
+	typedef std::unique_ptr<float[]> BlockType;
 
 	/// Pointer back to the owning spectrum renderer
 	AudioSpectrumRenderer *spectrum;
 
-	/// @brief Allocate and fill a data block
-	/// @param i Index of the block to produce data for
-	/// @return Newly allocated and filled block
-	///
-	/// The filling is delegated to the spectrum renderer
-	BlockType ProduceBlock(size_t i)
-	{
-		auto res = new float[((size_t)1)<<spectrum->derivation_size];
-		spectrum->FillBlock(i, res);
-		return BlockType(res);
-	}
-
 	/// @brief Calculate the in-memory size of a spec
 	/// @return The size in bytes of a spectrum cache block
 	size_t GetBlockSize() const
@@ -75,6 +72,9 @@ struct AudioSpectrumCacheBlockFactory {
 };
 
 /// @brief Cache for audio spectrum frequency-power data
+///
+/// Blocks are never produced by the cache itself; they are calculated in the
+/// background and stored with Insert.
 class AudioSpectrumCache
 : public DataBlockCache<float, 10, AudioSpectrumCacheBlockFactory> {
 public:
@@ -84,6 +84,90 @@ public:
 	}
 };
 
+/// @brief State shared between a spectrum renderer and its background tasks
+///
+/// A new one is created whenever the provider or resolution changes, so that
+/// results calculated for the old settings can be recognised and dropped.
+struct AudioSpectrumJobs {
+	/// Renderer to deliver results to; only touched on the main thread
+	AudioSpectrumRenderer *renderer;
+	/// Provider to read audio from
+	agi::AudioProvider *provider;
+	size_t derivation_size;
+	size_t derivation_dist;
+
+	/// Set when the renderer no longer wants the results, at which point the
+	/// provider may be about to be destroyed
+	std::atomic<bool> cancelled{false};
+
+	std::mutex lock;
+	/// Signalled when the last running task finishes
+	std::condition_variable idle;
+	/// Number of tasks currently using the provider
+	int running = 0;
+	/// Idle calculators; each running task takes one so that FFT plans and
+	/// scratch buffers are never shared between threads
+	std::vector<std::unique_ptr<agi::AudioSpectrumCalculator>> calculators;
+
+	AudioSpectrumJobs(AudioSpectrumRenderer *renderer, agi::AudioProvider *provider, size_t derivation_size, size_t derivation_dist)
+	: renderer(renderer)
+	, provider(provider)
+	, derivation_size(derivation_size)
+	, derivation_dist(derivation_dist)
+	{
+	}
+
+	/// Stop delivering results and wait for all running tasks to stop using the provider
+	void Cancel()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		cancelled = true;
+		idle.wait(guard, [&] { return running == 0; });
+	}
+
+	/// Calculate a set of blocks; called on a background thread
+	void Run(std::shared_ptr<AudioSpectrumJobs> const& self, std::vector<size_t> const& indices)
+	{
+		std::unique_ptr<agi::AudioSpectrumCalculator> calc;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (cancelled) return;
+			++running;
+			if (!calculators.empty())
+			{
+				calc = std::move(calculators.back());
+				calculators.pop_back();
+			}
+		}
+
+		if (!calc)
+			calc = agi::make_unique<agi::AudioSpectrumCalculator>(derivation_size);
+
+		auto results = std::make_shared<std::vector<std::pair<size_t, std::unique_ptr<float[]>>>>();
+		results->reserve(indices.size());
+		for (size_t block_index : indices)
+		{
+			if (cancelled) break;
+			std::unique_ptr<float[]> block(new float[calc->GetBlockSize()]);
+			int64_t first_sample = (((int64_t)block_index) << derivation_dist) - ((int64_t)1 << derivation_size);
+			calc->Calculate(*provider, first_sample, block.get());
+			results->emplace_back(block_index, std::move(block));
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			calculators.push_back(std::move(calc));
+			--running;
+		}
+		idle.notify_all();
+
+		agi::dispatch::Main().Async([=] {
+			if (!self->cancelled)
+				self->renderer->ReceiveBlocks(*results);
+		});
+	}
+};
+
 AudioSpectrumRenderer::AudioSpectrumRenderer(std::string const& color_scheme_name)
 {
 	colors.reserve(AudioStyle_MAX);
@@ -100,39 +184,19 @@ AudioSpectrumRenderer::~AudioSpectrumRenderer()
 
 void AudioSpectrumRenderer::RecreateCache()
 {
-#ifdef WITH_FFTW3
-	if (dft_plan)
+	if (jobs)
 	{
-		fftw_destroy_plan(dft_plan);
-		fftw_free(dft_input);
-		fftw_free(dft_output);
-		dft_plan = nullptr;
-		dft_input = nullptr;
-		dft_output = nullptr;
+		jobs->Cancel();
+		jobs.reset();
 	}
-#endif
+	pending.clear();
+	cache.reset();
 
 	if (provider)
 	{
 		size_t block_count = (size_t)((provider->GetNumSamples() + ((size_t)1<<derivation_dist) - 1) >> derivation_dist);
 		cache = agi::make_unique<AudioSpectrumCache>(block_count, this);
-
-#ifdef WITH_FFTW3
-		dft_input = fftw_alloc_real(2<<derivation_size);
-		dft_output = fftw_alloc_complex(2<<derivation_size);
-		dft_plan = fftw_plan_dft_r2c_1d(
-			2<<derivation_size,
-			dft_input,
-			dft_output,
-			FFTW_MEASURE);
-#else
-		// Allocate scratch for 6x the derivation size:
-		// 2x for the input sample data
-		// 2x for the real part of the output
-		// 2x for the imaginary part of the output
-		fft_scratch.resize(6 << derivation_size);
-#endif
-		audio_scratch.resize(2 << derivation_size);
+		jobs = std::make_shared<AudioSpectrumJobs>(this, provider, derivation_size, derivation_dist);
 	}
 }
 
@@ -143,76 +207,50 @@ void AudioSpectrumRenderer::OnSetProvider()
 
 void AudioSpectrumRenderer::SetResolution(size_t _derivation_size, size_t _derivation_dist)
 {
-	if (derivation_dist != _derivation_dist)
+	if (derivation_dist != _derivation_dist || derivation_size != _derivation_size)
 	{
 		derivation_dist = _derivation_dist;
-		if (cache)
-			cache->Age(0);
-	}
-
-	if (derivation_size != _derivation_size)
-	{
 		derivation_size = _derivation_size;
 		RecreateCache();
 	}
 }
 
-template<class T>
-void AudioSpectrumRenderer::ConvertToFloat(size_t count, T *dest) {
-	for (size_t si = 0; si < count; ++si)
-	{
-		dest[si] = (T)(audio_scratch[si]) / 32768.0;
-	}
-}
-
-void AudioSpectrumRenderer::FillBlock(size_t block_index, float *block)
+void AudioSpectrumRenderer::RequestBlocks(std::vector<size_t> const& blocks)
 {
-	assert(cache);
-	assert(block);
-
-	int64_t first_sample = (((int64_t)block_index) << derivation_dist) - ((int64_t)1 << derivation_size);
-	provider->GetAudio(&audio_scratch[0], first_sample, 2 << derivation_size);
+	std::vector<size_t> batch;
+	batch.reserve(blocks_per_job);
 
-#ifdef WITH_FFTW3
-	ConvertToFloat(2 << derivation_size, dft_input);
+	auto queue = [&] {
+		if (batch.empty()) return;
+		auto state = jobs;
+		agi::dispatch::Background().Async([=] { state->Run(state, batch); });
+		batch.clear();
+	};
 
-	fftw_execute(dft_plan);
-
-	double scale_factor = 9 / sqrt(2 << (derivation_size + 1));
-
-	fftw_complex *o = dft_output;
-	for (size_t si = (size_t)1<<derivation_size; si > 0; --si)
+	for (size_t block_index : blocks)
 	{
-		*block++ = log10( sqrt(o[0][0] * o[0][0] + o[0][1] * o[0][1]) * scale_factor + 1 );
-		o++;
+		if (!pending.insert(block_index).second) continue;
+		batch.push_back(block_index);
+		if (batch.size() == blocks_per_job)
+			queue();
 	}
-#else
-	ConvertToFloat(2 << derivation_size, &fft_scratch[0]);
-
-	float *fft_input = &fft_scratch[0];
-	float *fft_real = &fft_scratch[0] + (2 << derivation_size);
-	float *fft_imag = &fft_scratch[0] + (4 << derivation_size);
-
-	FFT fft;
-	fft.Transform(2<<derivation_size, fft_input, fft_real, fft_imag);
-
-	float scale_factor = 9 / sqrt(2 * (float)(2<<derivation_size));
+	queue();
+}
 
-	for (size_t si = 1<<derivation_size; si > 0; --si)
+void AudioSpectrumRenderer::ReceiveBlocks(std::vector<std::pair<size_t, std::unique_ptr<float[]>>>& blocks)
+{
+	for (auto& block : blocks)
 	{
-		// With x in range [0;1], log10(x*9+1) will also be in range [0;1],
-		// although the FFT output can apparently get greater magnitudes than 1
-		// despite the input being limited to [-1;+1).
-		*block++ = log10( sqrt(*fft_real * *fft_real + *fft_imag * *fft_imag) * scale_factor + 1 );
-		fft_real++; fft_imag++;
+		pending.erase(block.first);
+		cache->Insert(block.first, std::move(block.second));
 	}
-#endif
+	AnnounceDataReady();
 }
 
-void AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
+bool AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
 {
 	if (!cache)
-		return;
+		return true;
 
 	assert(bmp.IsOk());
 	assert(bmp.GetDepth() == 24);
@@ -235,18 +273,37 @@ void AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 	int minband = 0;
 	int maxband = 1 << derivation_size;
 
+	const double samples_per_column = pixel_ms * provider->GetSampleRate() / 1000;
+	const size_t block_count = (size_t)((provider->GetNumSamples() + ((size_t)1<<derivation_dist) - 1) >> derivation_dist);
+	auto column_block = [&](int ax) {
+		return (size_t)(ax * samples_per_column) >> derivation_dist;
+	};
+
+	std::vector<size_t> missing;
+
 	// ax = absolute x, absolute to the virtual spectrum bitmap
 	for (int ax = start; ax < end; ++ax)
 	{
 		// Derived audio data
-		size_t block_index = (size_t)(ax * pixel_ms * provider->GetSampleRate() / 1000) >> derivation_dist;
-		float *power = &cache->Get(block_index);
+		size_t block_index = column_block(ax);
+		float *power = cache->TryGet(block_index);
 
 		// Prepare bitmap writing
 		unsigned char *px = imgdata + (imgheight-1) * stride + (ax - start) * 3;
 
+		if (!power)
+		{
+			// Not calculated yet, so draw silence until it is
+			if (missing.empty() || missing.back() != block_index)
+				missing.push_back(block_index);
+			for (int y = 0; y < imgheight; ++y)
+			{
+				pal->map(0, px);
+				px -= stride;
+			}
+		}
 		// Scale up or down vertically?
-		if (imgheight > 1<<derivation_size)
+		else if (imgheight > 1<<derivation_size)
 		{
 			// Interpolate
 			for (int y = 0; y < imgheight; ++y)
@@ -278,9 +335,31 @@ void AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 		}
 	}
 
+	const bool complete = missing.empty();
+
+	// Calculate the blocks just past the rendered range in the direction the
+	// display is moving, so that they're ready by the time they're needed
+	const bool backwards = start < last_start;
+	last_start = start;
+	for (int i = 0; i < prefetch_columns; ++i)
+	{
+		int ax = backwards ? start - 1 - i : end + i;
+		if (ax < 0) break;
+		size_t block_index = column_block(ax);
+		if (block_index >= block_count) break;
+		if (!missing.empty() && missing.back() == block_index) continue;
+		if (!cache->TryGet(block_index))
+			missing.push_back(block_index);
+	}
+
+	if (!missing.empty())
+		RequestBlocks(missing);
+
 	wxBitmap tmpbmp(img);
 	wxMemoryDC targetdc(bmp);
 	targetdc.DrawBitmap(tmpbmp, 0, 0);
+
+	return complete;
 }
 
 void AudioSpectrumRenderer::RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style)
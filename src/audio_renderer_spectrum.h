@@ -35,25 +35,28 @@
 
 #include <cstdint>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "audio_renderer.h"
 
-#ifdef WITH_FFTW3
-#include <fftw3.h>
-#endif
-
 class AudioColorScheme;
 class AudioSpectrumCache;
 struct AudioSpectrumCacheBlockFactory;
+struct AudioSpectrumJobs;
 
 /// @class AudioSpectrumRenderer
 /// @brief Render frequency-power spectrum graphs for audio data.
 ///
 /// Renders frequency-power spectrum graphs of PCM audio data using a derivation function
 /// such as the fast fourier transform.
+///
+/// The frequency-power data is calculated on the background thread pool. Columns
+/// whose data is not ready yet are drawn as silence, and AnnounceDataReady is
+/// triggered once more data has arrived so that they can be redrawn.
 class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	friend struct AudioSpectrumCacheBlockFactory;
+	friend struct AudioSpectrumJobs;
 
 	/// Internal cache management for the spectrum
 	std::unique_ptr<AudioSpectrumCache> cache;
@@ -79,31 +82,25 @@ class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	/// e.g. new audio provider or new resolution.
 	void RecreateCache();
 
-	/// @brief Fill a block with frequency-power data for a time range
-	/// @param      block_index Index of the block to fill data for
-	/// @param[out] block       Address to write the data to
-	void FillBlock(size_t block_index, float *block);
-
-	/// @brief Convert audio data to float range [-1;+1)
-	/// @param count Samples to convert
-	/// @param dest Buffer to fill
-	template<class T>
-	void ConvertToFloat(size_t count, T *dest);
-
-#ifdef WITH_FFTW3
-	/// FFTW plan data
-	fftw_plan dft_plan = nullptr;
-	/// Pre-allocated input array for FFTW
-	double *dft_input = nullptr;
-	/// Pre-allocated output array for FFTW
-	fftw_complex *dft_output = nullptr;
-#else
-	/// Pre-allocated scratch area for doing FFT derivations
-	std::vector<float> fft_scratch;
-#endif
-
-	/// Pre-allocated scratch area for storing raw audio data
-	std::vector<int16_t> audio_scratch;
+	/// Background calculation state for the current provider and resolution
+	std::shared_ptr<AudioSpectrumJobs> jobs;
+
+	/// Blocks which have been queued for calculation but not received yet
+	std::unordered_set<size_t> pending;
+
+	/// First column rendered by the previous call to Render, used to guess
+	/// which direction the user is scrolling in
+	int last_start = 0;
+
+	/// @brief Queue blocks for calculation on the background thread pool
+	/// @param blocks Indices of the blocks to calculate
+	///
+	/// Blocks which are already pending are skipped.
+	void RequestBlocks(std::vector<size_t> const& blocks);
+
+	/// @brief Store blocks calculated in the background
+	/// @param blocks Calculated blocks and their indices
+	void ReceiveBlocks(std::vector<std::pair<size_t, std::unique_ptr<float[]>>>& blocks);
 
 public:
 	/// @brief Constructor
@@ -117,7 +114,8 @@ public:
 	/// @param bmp   [in,out] Bitmap to render into, also carries length information
 	/// @param start First column of pixel data in display to render
 	/// @param style Style to render audio in
-	void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
+	/// @return false if some of the columns have not been calculated yet
+	bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
 
 	/// @brief Render blank area
 	void RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style) override;
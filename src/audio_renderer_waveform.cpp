@@ -32,6 +32,7 @@
 #include "audio_colorscheme.h"
 #include "options.h"
 
+#include <libaegisub/audio/peaks.h>
 #include <libaegisub/audio/provider.h>
 
 #include <algorithm>
@@ -55,7 +56,7 @@ AudioWaveformRenderer::AudioWaveformRenderer(std::string const& color_scheme_nam
 
 AudioWaveformRenderer::~AudioWaveformRenderer() { }
 
-void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
+bool AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
 {
 	wxMemoryDC dc(bmp);
 	wxRect rect(wxPoint(0, 0), bmp.GetSize());
@@ -70,14 +71,6 @@ void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 	dc.SetPen(*wxTRANSPARENT_PEN);
 	dc.DrawRectangle(rect);
 
-	// Make sure we've got a buffer to fill with audio data
-	if (!audio_buffer)
-	{
-		// Buffer for one pixel strip of audio
-		size_t buffer_needed = pixel_samples * provider->GetChannels() * provider->GetBytesPerSample();
-		audio_buffer.reset(new char[buffer_needed]);
-	}
-
 	double cur_sample = start * pixel_samples;
 
 	assert(provider->GetBytesPerSample() == 2);
@@ -86,33 +79,60 @@ void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 	wxPen pen_peaks(wxPen(pal->get(0.4f)));
 	wxPen pen_avgs(wxPen(pal->get(0.7f)));
 
+	// When zoomed out far enough, use the provider's precomputed peaks rather
+	// than scanning every sample under each column
+	auto peaks = provider->GetPeaks();
+	const int peak_level = peaks ? agi::AudioPeaks::LevelFor(pixel_samples) : -1;
+
 	for (int x = 0; x < rect.width; ++x)
 	{
-		provider->GetAudio(audio_buffer.get(), (int64_t)cur_sample, (int64_t)pixel_samples);
-		cur_sample += pixel_samples;
-
 		int peak_min = 0, peak_max = 0;
 		int64_t avg_min_accum = 0, avg_max_accum = 0;
-		auto aud = reinterpret_cast<const int16_t *>(audio_buffer.get());
-		for (int si = pixel_samples; si > 0; --si, ++aud)
+		double avg_samples = pixel_samples;
+
+		agi::AudioPeaks::Range range;
+		if (peak_level >= 0 && peaks->Get(peak_level, (int64_t)cur_sample, (int64_t)(cur_sample + pixel_samples), range))
 		{
-			if (*aud > 0)
+			peak_min = range.min;
+			peak_max = range.max;
+			avg_min_accum = range.neg_sum;
+			avg_max_accum = range.pos_sum;
+			avg_samples = range.samples;
+		}
+		else
+		{
+			// Make sure we've got a buffer to fill with audio data
+			if (!audio_buffer)
 			{
-				peak_max = std::max(peak_max, (int)*aud);
-				avg_max_accum += *aud;
+				// Buffer for one pixel strip of audio
+				size_t buffer_needed = pixel_samples * provider->GetChannels() * provider->GetBytesPerSample();
+				audio_buffer.reset(new char[buffer_needed]);
 			}
-			else
+
+			provider->GetAudio(audio_buffer.get(), (int64_t)cur_sample, (int64_t)pixel_samples);
+
+			auto aud = reinterpret_cast<const int16_t *>(audio_buffer.get());
+			for (int si = pixel_samples; si > 0; --si, ++aud)
 			{
-				peak_min = std::min(peak_min, (int)*aud);
-				avg_min_accum += *aud;
+				if (*aud > 0)
+				{
+					peak_max = std::max(peak_max, (int)*aud);
+					avg_max_accum += *aud;
+				}
+				else
+				{
+					peak_min = std::min(peak_min, (int)*aud);
+					avg_min_accum += *aud;
+				}
 			}
 		}
+		cur_sample += pixel_samples;
 
 		// midpoint is half height
 		peak_min = std::max((int)(peak_min * amplitude_scale * midpoint) / 0x8000, -midpoint);
 		peak_max = std::min((int)(peak_max * amplitude_scale * midpoint) / 0x8000, midpoint);
-		int avg_min = std::max((int)(avg_min_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, -midpoint);
-		int avg_max = std::min((int)(avg_max_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, midpoint);
+		int avg_min = std::max((int)(avg_min_accum * amplitude_scale * midpoint / avg_samples) / 0x8000, -midpoint);
+		int avg_max = std::min((int)(avg_max_accum * amplitude_scale * midpoint / avg_samples) / 0x8000, midpoint);
 
 		dc.SetPen(pen_peaks);
 		dc.DrawLine(x, midpoint - peak_max, x, midpoint - peak_min);
@@ -129,6 +149,16 @@ void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 		dc.SetPen(pen_peaks);
 
 	dc.DrawLine(0, midpoint, rect.width, midpoint);
+	return true;
+}
+
+int64_t AudioWaveformRenderer::GetRenderableSamples() const
+{
+	int64_t decoded = AudioRendererBitmapProvider::GetRenderableSamples();
+	auto peaks = provider ? provider->GetPeaks() : nullptr;
+	if (!peaks || agi::AudioPeaks::LevelFor(pixel_ms * provider->GetSampleRate() / 1000.0) < 0)
+		return decoded;
+	return std::max(decoded, peaks->GetAvailableSamples());
 }
 
 void AudioWaveformRenderer::RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style)
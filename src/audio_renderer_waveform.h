@@ -61,11 +61,18 @@ public:
 	/// @param bmp   [in,out] Bitmap to render into, also carries length information
 	/// @param start First column of pixel data in display to render
 	/// @param style Style to render audio in
-	void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
+	bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
 
 	/// @brief Render blank area
 	void RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style) override;
 
+	/// @brief Get the number of samples which can be rendered
+	///
+	/// When zoomed out far enough to render from the provider's peak summary,
+	/// this includes audio which has not been decoded yet but whose peaks
+	/// were loaded from the peak cache.
+	int64_t GetRenderableSamples() const override;
+
 	/// @brief Cleans up the cache
 	/// @param max_size Maximum size in bytes for the cache
 	///
@@ -105,6 +105,7 @@ namespace Automation4 {
 
 		int LuaParseKaraokeData(lua_State *L);
 		int LuaGetScriptResolution(lua_State *L);
+		int LuaGetOverlaps(lua_State *L);
 
 		void LuaSetUndoPoint(lua_State *L);
 
@@ -42,6 +42,7 @@
 #include "compat.h"
 
 #include <libaegisub/exception.h>
+#include <libaegisub/interval_index.h>
 #include <libaegisub/log.h>
 #include <libaegisub/lua/utils.h>
 #include <libaegisub/make_unique.h>
@@ -50,6 +51,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <cassert>
 #include <memory>
+#include <unordered_map>
 
 namespace {
 	using namespace agi::lua;
@@ -128,6 +130,21 @@ namespace {
 	const T *check_cast_constptr(const U *value) {
 		return typeid(const T) == typeid(*value) ? static_cast<const T *>(value) : nullptr;
 	}
+
+	/// Push a table of {i, j} tables for pairs of 0-based line indices
+	void push_overlaps(lua_State *L, std::vector<std::pair<size_t, size_t>> const& pairs)
+	{
+		lua_createtable(L, pairs.size(), 0);
+		int idx = 1;
+		for (auto const& pair : pairs) {
+			lua_createtable(L, 2, 0);
+			push_value(L, pair.first + 1);
+			lua_rawseti(L, -2, 1);
+			push_value(L, pair.second + 1);
+			lua_rawseti(L, -2, 2);
+			lua_rawseti(L, -2, idx++);
+		}
+	}
 }
 
 namespace Automation4 {
@@ -362,6 +379,8 @@ namespace Automation4 {
 					lua_pushcclosure(L, closure_wrapper_v<&LuaAssFile::ObjectAppend, false>, 1);
 				else if (strcmp(idx, "script_resolution") == 0)
 					lua_pushcclosure(L, closure_wrapper<&LuaAssFile::LuaGetScriptResolution>, 1);
+				else if (strcmp(idx, "overlaps") == 0)
+					lua_pushcclosure(L, closure_wrapper<&LuaAssFile::LuaGetOverlaps>, 1);
 				else {
 					// idiot
 					lua_pop(L, 1);
@@ -667,6 +686,67 @@ namespace Automation4 {
 		return 2;
 	}
 
+	int LuaAssFile::LuaGetOverlaps(lua_State *L)
+	{
+		std::vector<std::pair<size_t, size_t>> pairs;
+
+		// Until the script changes something, the lines are the file's own
+		// and the file's time index can be used rather than building one
+		if (lua_isnoneornil(L, 1) && !modification_type && pending_commits.empty()) {
+			std::unordered_map<const AssDialogue *, size_t> line_index;
+			size_t i = ass->Info.size() + ass->Styles.size();
+			for (auto const& line : ass->Events)
+				line_index[&line] = i++;
+
+			for (auto const& pair : ass->OverlappingPairs()) {
+				size_t a = line_index[pair.first], b = line_index[pair.second];
+				if (pair.second->Start < pair.first->Start || (pair.second->Start == pair.first->Start && b < a))
+					std::swap(a, b);
+				pairs.emplace_back(a, b);
+			}
+			sort(pairs.begin(), pairs.end());
+			push_overlaps(L, pairs);
+			return 1;
+		}
+
+		// Either the lines in the table passed or every dialogue line
+		std::vector<size_t> ids;
+		if (!lua_isnoneornil(L, 1)) {
+			argcheck(L, lua_istable(L, 1), 1, "Table of line indices expected");
+			lua_pushvalue(L, 1);
+			lua_for_each(L, [&] {
+				size_t n = check_uint(L, -1);
+				argcheck(L, n > 0 && n <= lines.size(), 1, "Out of range line index");
+				ids.push_back(n - 1);
+			});
+			sort(ids.begin(), ids.end());
+			ids.erase(unique(ids.begin(), ids.end()), ids.end());
+		}
+		else {
+			for (size_t i = 0; i < lines.size(); ++i)
+				ids.push_back(i);
+		}
+
+		// Lines with the same start time are ordered by index in the index
+		std::vector<agi::interval_index<size_t>::interval> intervals;
+		for (size_t i : ids) {
+			if (lines[i] && lines[i]->Group() == AssEntryGroup::DIALOGUE) {
+				auto dia = static_cast<const AssDialogue *>(lines[i]);
+				intervals.push_back({dia->Start, dia->End, i});
+			}
+		}
+
+		agi::interval_index<size_t> index;
+		index.assign(std::move(intervals));
+
+		index.for_each_overlapping_pair([&](agi::interval_index<size_t>::interval const& a, agi::interval_index<size_t>::interval const& b) {
+			pairs.emplace_back(a.value, b.value);
+		});
+		sort(pairs.begin(), pairs.end());
+		push_overlaps(L, pairs);
+		return 1;
+	}
+
 	void LuaAssFile::LuaSetUndoPoint(lua_State *L)
 	{
 		if (!can_set_undo)
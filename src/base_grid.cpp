@@ -45,12 +45,16 @@
 #include "subs_controller.h"
 #include "video_controller.h"
 
+#include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/util.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 
-#include <wx/dcbuffer.h>
+#include <wx/dcclient.h>
+#include <wx/dcmemory.h>
 #include <wx/menu.h>
 #include <wx/scrolbar.h>
 #include <wx/sizer.h>
@@ -66,6 +70,7 @@ BaseGrid::BaseGrid(wxWindow* parent, agi::Context *context)
 , context(context)
 , columns(GetGridColumns())
 , columns_visible(OPT_GET("Subtitle/Grid/Column")->GetListBool())
+, line_stats(agi::make_unique<GridLineStats>())
 , seek_listener(context->videoController->AddSeekListener(&BaseGrid::OnSeek, this))
 {
 	scrollBar->SetScrollbar(0,10,100,10);
@@ -83,6 +88,7 @@ BaseGrid::BaseGrid(wxWindow* parent, agi::Context *context)
 			columns[i]->SetVisible(false);
 	}
 
+	line_stats->Commit(*context->ass, AssFile::COMMIT_NEW, nullptr);
 	UpdateStyle();
 	OnHighlightVisibleChange(*OPT_GET("Subtitle/Grid/Highlight Subtitles in Frame"));
 
@@ -108,7 +114,13 @@ BaseGrid::BaseGrid(wxWindow* parent, agi::Context *context)
 		OPT_SUB("Colour/Subtitle Grid/Standard", &BaseGrid::UpdateStyle, this),
 
 		OPT_SUB("Subtitle/Grid/Highlight Subtitles in Frame", &BaseGrid::OnHighlightVisibleChange, this),
-		OPT_SUB("Subtitle/Grid/Hide Overrides", [&](agi::OptionValue const&) { Refresh(false); }),
+		OPT_SUB("Subtitle/Grid/Hide Overrides", [&](agi::OptionValue const&) { ++row_cache_generation; Refresh(false); }),
+		OPT_SUB("Subtitle/Grid/Hide Overrides Char", [&](agi::OptionValue const&) { ++row_cache_generation; Refresh(false); }),
+
+		// Frame numbers shown in the time columns and used to highlight the
+		// lines on the current frame depend on the video and timecodes
+		context->project->AddVideoProviderListener([&](AsyncVideoProvider *) { ++row_cache_generation; Refresh(false); }),
+		context->project->AddTimecodesListener([&](agi::vfr::Framerate const&) { ++row_cache_generation; Refresh(false); }),
 	});
 
 	Bind(wxEVT_CONTEXT_MENU, &BaseGrid::OnContextMenu, this);
@@ -126,7 +138,10 @@ BEGIN_EVENT_TABLE(BaseGrid,wxWindow)
 	EVT_MENU_RANGE(MENU_SHOW_COL,MENU_SHOW_COL+15,BaseGrid::OnShowColMenu)
 END_EVENT_TABLE()
 
-void BaseGrid::OnSubtitlesCommit(int type) {
+void BaseGrid::OnSubtitlesCommit(int type, const AssDialogue *single_line) {
+	line_stats->Commit(*context->ass, type, single_line);
+	InvalidateRows(type, single_line);
+
 	if (type == AssFile::COMMIT_NEW || type & AssFile::COMMIT_ORDER || type & AssFile::COMMIT_DIAG_ADDREM)
 		UpdateMaps();
 
@@ -158,10 +173,12 @@ void BaseGrid::OnShowColMenu(wxCommandEvent &event) {
 }
 
 void BaseGrid::OnHighlightVisibleChange(agi::OptionValue const& opt) {
-	if (opt.GetBool())
+	highlight_visible = opt.GetBool();
+	if (highlight_visible)
 		seek_listener.Unblock();
 	else
 		seek_listener.Block();
+	Refresh(false);
 }
 
 void BaseGrid::UpdateStyle() {
@@ -186,6 +203,12 @@ void BaseGrid::UpdateStyle() {
 	row_colors.SelectedComment.SetColour(to_wx(OPT_GET("Colour/Subtitle Grid/Background/Selected Comment")->GetColor()));
 	row_colors.LeftCol.SetColour(to_wx(OPT_GET("Colour/Subtitle Grid/Left Column")->GetColor()));
 
+	text_colors.Standard = to_wx(OPT_GET("Colour/Subtitle Grid/Standard")->GetColor());
+	text_colors.Selection = to_wx(OPT_GET("Colour/Subtitle Grid/Selection")->GetColor());
+	text_colors.Collision = to_wx(OPT_GET("Colour/Subtitle Grid/Collision")->GetColor());
+	text_colors.Lines = to_wx(OPT_GET("Colour/Subtitle Grid/Lines")->GetColor());
+	text_colors.ActiveBorder = to_wx(OPT_GET("Colour/Subtitle Grid/Active Border")->GetColor());
+
 	SetColumnWidths();
 
 	AdjustScrollbar();
@@ -197,6 +220,7 @@ void BaseGrid::UpdateMaps() {
 
 	for (auto& curdiag : context->ass->Events)
 		index_line_map.push_back(&curdiag);
+	row_cache.resize(index_line_map.size());
 
 	SetColumnWidths();
 	AdjustScrollbar();
@@ -250,7 +274,7 @@ void BaseGrid::OnSeek() {
 
 	auto it = begin(visible_rows);
 	for (int i : boost::irange(yPos, yPos + lines)) {
-		if (IsDisplayed(index_line_map[i])) {
+		if (IsDisplayed(i)) {
 			if (it == end(visible_rows) || *it != i) {
 				Refresh(false);
 				return;
@@ -262,17 +286,104 @@ void BaseGrid::OnSeek() {
 		Refresh(false);
 }
 
-void BaseGrid::OnPaint(wxPaintEvent &) {
+BaseGrid::RowCache const& BaseGrid::GetRowCache(int row) {
+	auto& cache = row_cache[row];
+	if (cache.generation == row_cache_generation)
+		return cache;
+
+	AssDialogue *line = index_line_map[row];
+	if (context->project->VideoProvider()) {
+		cache.start_frame = context->project->Timecodes().FrameAtTime(line->Start, agi::vfr::START);
+		cache.end_frame = context->project->Timecodes().FrameAtTime(line->End, agi::vfr::END);
+	}
+	else
+		cache.start_frame = cache.end_frame = -1;
+
+	cache.values.resize(columns.size());
+	for (size_t i : agi::util::range(columns.size())) {
+		if (columns[i]->Width())
+			cache.values[i] = columns[i]->Value(line, context);
+		else
+			cache.values[i].clear();
+	}
+
+	cache.generation = row_cache_generation;
+	return cache;
+}
+
+void BaseGrid::InvalidateRows(int type, const AssDialogue *single_line) {
+	if (type == AssFile::COMMIT_NEW || type & (AssFile::COMMIT_ORDER | AssFile::COMMIT_DIAG_ADDREM))
+		++row_cache_generation;
+	else if (!(type & AssFile::COMMIT_DIAG_FULL))
+		return;
+	else if (single_line && static_cast<size_t>(single_line->Row) < row_cache.size())
+		row_cache[single_line->Row].generation = 0;
+	else
+		++row_cache_generation;
+}
+
+void BaseGrid::Refresh(bool eraseBackground, const wxRect *rect) {
+	if (rect)
+		dirty_region.Union(*rect);
+	else {
+		wxSize size = GetClientSize();
+		dirty_region.Union(0, 0, size.GetWidth(), size.GetHeight());
+	}
+	wxWindow::Refresh(eraseBackground, rect);
+}
+
+void BaseGrid::ScrollRows(int old_pos) {
+	int w = 0;
+	int h = 0;
+	GetClientSize(&w, &h);
+
+	// Rows start below the header and its bottom line
+	wxRect rows(0, lineHeight + 1, w, h - lineHeight - 1);
+	int shift = (old_pos - yPos) * lineHeight;
+
+	// Anything already waiting to be redrawn would have to be shifted too,
+	// so just redraw everything in that case
+	if (!grid_bitmap.IsOk() || !dirty_region.IsEmpty() || std::abs(shift) >= rows.height) {
+		Refresh(false);
+		return;
+	}
+
+	if (!scroll_bitmap.IsOk() || scroll_bitmap.GetSize() != grid_bitmap.GetSize()
+		|| scroll_bitmap.GetScaleFactor() != grid_bitmap.GetScaleFactor())
+		scroll_bitmap.CreateScaled(grid_bitmap.GetScaledWidth(), grid_bitmap.GetScaledHeight(), -1, grid_bitmap.GetScaleFactor());
+
+	{
+		wxMemoryDC src(grid_bitmap);
+		wxMemoryDC dst(scroll_bitmap);
+		dst.Blit(0, 0, w, rows.y, &src, 0, 0);
+		if (shift > 0) {
+			dst.Blit(0, rows.y + shift, w, rows.height - shift, &src, 0, rows.y);
+			dirty_region.Union(0, rows.y, w, shift);
+		}
+		else {
+			dst.Blit(0, rows.y, w, rows.height + shift, &src, 0, rows.y - shift);
+			dirty_region.Union(0, rows.GetBottom() + shift + 1, w, -shift);
+		}
+	}
+	std::swap(grid_bitmap, scroll_bitmap);
+
+	// The first row is also redrawn as its top edge is the header's bottom
+	// line, which the active line border is drawn over
+	dirty_region.Union(0, lineHeight, w, lineHeight + 1);
+	paint_stats.rows_scrolled += (rows.height - std::abs(shift)) / lineHeight;
+	wxWindow::Refresh(false);
+}
+
+size_t BaseGrid::DrawRect(wxDC &dc, wxRect const& rect) {
 	// Find which columns need to be repainted
 	std::vector<char> paint_columns;
 	paint_columns.resize(columns.size(), false);
 	bool any = false;
-	for (wxRegionIterator region(GetUpdateRegion()); region; ++region) {
-		wxRect updrect = region.GetRect();
+	{
 		int x = 0;
 		for (size_t i : agi::util::range(columns.size())) {
 			int width = columns[i]->Width();
-			if (width && updrect.x < x + width && updrect.x + updrect.width > x) {
+			if (width && rect.x < x + width && rect.x + rect.width > x) {
 				paint_columns[i] = true;
 				any = true;
 			}
@@ -280,31 +391,25 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 		}
 	}
 
-	if (!any) return;
+	if (!any) return 0;
 
 	int w = 0;
 	int h = 0;
 	GetClientSize(&w,&h);
 	w -= scrollBar->GetSize().GetWidth();
 
-	wxAutoBufferedPaintDC dc(this);
-	dc.SetFont(font);
+	dc.SetClippingRegion(rect);
 
-	dc.SetBackground(row_colors.Default);
-	dc.Clear();
+	dc.SetPen(*wxTRANSPARENT_PEN);
+	dc.SetBrush(row_colors.Default);
+	dc.DrawRectangle(rect);
 
 	// Draw labels
-	dc.SetPen(*wxTRANSPARENT_PEN);
 	dc.SetBrush(row_colors.LeftCol);
 	dc.DrawRectangle(0, lineHeight, columns[0]->Width(), h-lineHeight);
 
-	// Row colors
-	wxColour text_standard(to_wx(OPT_GET("Colour/Subtitle Grid/Standard")->GetColor()));
-	wxColour text_selection(to_wx(OPT_GET("Colour/Subtitle Grid/Selection")->GetColor()));
-	wxColour text_collision(to_wx(OPT_GET("Colour/Subtitle Grid/Collision")->GetColor()));
-
 	// First grid row
-	wxPen grid_pen(to_wx(OPT_GET("Colour/Subtitle Grid/Lines")->GetColor()));
+	wxPen grid_pen(text_colors.Lines);
 	dc.SetPen(grid_pen);
 	dc.DrawLine(0, 0, w, 0);
 	dc.SetPen(*wxTRANSPARENT_PEN);
@@ -320,8 +425,8 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 	};
 
 	// Paint header
-	{
-		dc.SetTextForeground(text_standard);
+	if (rect.y <= lineHeight) {
+		dc.SetTextForeground(text_colors.Standard);
 		dc.SetBrush(row_colors.Header);
 		dc.DrawRectangle(0, 0, w, lineHeight);
 
@@ -336,18 +441,27 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 		dc.DrawLine(0, lineHeight, w, lineHeight);
 	}
 
-	// Paint the rows
+	// Paint the rows which overlap the rect; row i covers from
+	// (i + 1) * lineHeight to the grid line at (i + 2) * lineHeight
 	const int drawPerScreen = h/lineHeight + 1;
 	const int nDraw = mid(0, drawPerScreen, GetRows() - yPos);
+	const int firstDraw = std::max(0, rect.y / lineHeight - 2);
+	const int lastDraw = std::min(nDraw, rect.GetBottom() / lineHeight);
 	const int grid_x = columns[0]->Width();
 
 	const auto active_line = context->selectionController->GetActiveLine();
 	auto const& selection = context->selectionController->GetSelectedSet();
-	visible_rows.clear();
 
-	for (int i : agi::util::range(nDraw)) {
+	// Lines which overlap the active line are drawn in the collision colour
+	std::vector<AssDialogue *> collisions;
+	if (active_line)
+		collisions = context->ass->OverlappingLines(active_line);
+	auto by_row = [](const AssDialogue *lft, const AssDialogue *rgt) { return lft->Row < rgt->Row; };
+
+	for (int i = firstDraw; i < lastDraw; ++i) {
 		wxBrush color = row_colors.Default;
 		AssDialogue *curDiag = index_line_map[i + yPos];
+		auto const& cache = GetRowCache(i + yPos);
 
 		bool inSel = !!selection.count(curDiag);
 		if (inSel && curDiag->Comment)
@@ -356,12 +470,8 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 			color = row_colors.Selection;
 		else if (curDiag->Comment)
 			color = row_colors.Comment;
-
-		if (OPT_GET("Subtitle/Grid/Highlight Subtitles in Frame")->GetBool() && IsDisplayed(curDiag)) {
-			if (color == row_colors.Default)
-				color = row_colors.Visible;
-			visible_rows.push_back(i + yPos);
-		}
+		else if (highlight_visible && IsDisplayed(i + yPos))
+			color = row_colors.Visible;
 		dc.SetBrush(color);
 
 		// Draw row background color
@@ -370,19 +480,19 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 			dc.DrawRectangle(grid_x, (i + 1) * lineHeight + 1, w, lineHeight);
 		}
 
-		if (active_line != curDiag && curDiag->CollidesWith(active_line))
-			dc.SetTextForeground(text_collision);
+		if (std::binary_search(collisions.begin(), collisions.end(), curDiag, by_row))
+			dc.SetTextForeground(text_colors.Collision);
 		else if (inSel)
-			dc.SetTextForeground(text_selection);
+			dc.SetTextForeground(text_colors.Selection);
 		else
-			dc.SetTextForeground(text_standard);
+			dc.SetTextForeground(text_colors.Standard);
 
 		// Draw text
 		int x = 0;
 		int y = (i + 1) * lineHeight;
 		for (size_t j : agi::util::range(columns.size())) {
 			if (paint_columns[j])
-				columns[j]->Paint(dc, x, y, curDiag, context);
+				columns[j]->Paint(dc, x, y, curDiag, cache.values[j], context);
 			x += columns[j]->Width();
 		}
 
@@ -407,10 +517,66 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 	}
 
 	if (active_line && active_line->Row >= yPos && active_line->Row < yPos + nDraw) {
-		dc.SetPen(wxPen(to_wx(OPT_GET("Colour/Subtitle Grid/Active Border")->GetColor())));
+		dc.SetPen(wxPen(text_colors.ActiveBorder));
 		dc.SetBrush(*wxTRANSPARENT_BRUSH);
 		dc.DrawRectangle(0, (active_line->Row - yPos + 1) * lineHeight, w, lineHeight + 1);
 	}
+
+	dc.DestroyClippingRegion();
+	return std::max(0, lastDraw - firstDraw);
+}
+
+void BaseGrid::OnPaint(wxPaintEvent &) {
+	auto start = std::chrono::steady_clock::now();
+
+	int w = 0;
+	int h = 0;
+	GetClientSize(&w,&h);
+
+	wxPaintDC dc(this);
+	if (w <= 0 || h <= 0) return;
+
+	// The client size is in logical pixels, so the bitmap needs to match the
+	// display's scale factor to not be blurry on high DPI displays
+	double scale = GetContentScaleFactor();
+	if (!grid_bitmap.IsOk() || grid_bitmap.GetScaleFactor() != scale
+		|| grid_bitmap.GetScaledWidth() != w || grid_bitmap.GetScaledHeight() != h) {
+		grid_bitmap.CreateScaled(w, h, -1, scale);
+		dirty_region.Union(0, 0, w, h);
+	}
+
+	wxMemoryDC grid_dc(grid_bitmap);
+	if (!dirty_region.IsEmpty()) {
+		grid_dc.SetFont(font);
+		for (wxRegionIterator region(dirty_region); region; ++region)
+			paint_stats.rows_drawn += DrawRect(grid_dc, region.GetRect());
+		dirty_region.Clear();
+	}
+
+	for (wxRegionIterator region(GetUpdateRegion()); region; ++region) {
+		wxRect r = region.GetRect();
+		dc.Blit(r.x, r.y, r.width, r.height, &grid_dc, r.x, r.y);
+	}
+
+	// Remember which rows are on the current frame so that seeking only has
+	// to repaint if they change
+	visible_rows.clear();
+	if (highlight_visible) {
+		const int nDraw = mid(0, h / lineHeight + 1, GetRows() - yPos);
+		for (int i : agi::util::range(nDraw)) {
+			if (IsDisplayed(i + yPos))
+				visible_rows.push_back(i + yPos);
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	paint_stats.paint_ms += elapsed.count();
+	if (++paint_stats.paints % 500 == 0) {
+		LOG_D("grid/paint") << paint_stats.paints << " paints in "
+			<< (size_t)paint_stats.paint_ms << " ms, "
+			<< paint_stats.rows_drawn << " rows drawn, "
+			<< paint_stats.rows_scrolled << " rows scrolled";
+	}
 }
 
 void BaseGrid::OnSize(wxSizeEvent &) {
@@ -421,8 +587,9 @@ void BaseGrid::OnSize(wxSizeEvent &) {
 void BaseGrid::OnScroll(wxScrollEvent &event) {
 	int newPos = event.GetPosition();
 	if (yPos != newPos) {
+		int old_pos = yPos;
 		context->ass->Properties.scroll_position = yPos = newPos;
-		Refresh(false);
+		ScrollRows(old_pos);
 	}
 }
 
@@ -557,9 +724,10 @@ void BaseGrid::OnContextMenu(wxContextMenuEvent &evt) {
 void BaseGrid::ScrollTo(int y) {
 	int nextY = mid(0, y, GetRows() - 1);
 	if (yPos != nextY) {
+		int old_pos = yPos;
 		context->ass->Properties.scroll_position = yPos = nextY;
 		scrollBar->SetThumbPosition(yPos);
-		Refresh(false);
+		ScrollRows(old_pos);
 	}
 }
 
@@ -605,7 +773,11 @@ void BaseGrid::SetColumnWidths() {
 	width_helper->SetDC(&dc);
 
 	for (auto const& column : columns) {
-		column->UpdateWidth(context, *width_helper);
+		// Cached rows only have values for the columns which were visible
+		bool was_visible = column->Width() != 0;
+		column->UpdateWidth(context, *line_stats, *width_helper);
+		if (was_visible != (column->Width() != 0))
+			++row_cache_generation;
 		if (column->Width() && column->RefreshOnTextChange())
 			text_refresh_rects.emplace_back(x, 0, column->Width(), h);
 		x += column->Width();
@@ -618,11 +790,11 @@ AssDialogue *BaseGrid::GetDialogue(int n) const {
 	return index_line_map[n];
 }
 
-bool BaseGrid::IsDisplayed(const AssDialogue *line) const {
-	if (!context->project->VideoProvider()) return false;
+bool BaseGrid::IsDisplayed(int row) {
+	auto const& cache = GetRowCache(row);
+	if (cache.start_frame < 0) return false;
 	int frame = context->videoController->GetFrameN();
-	return context->project->Timecodes().FrameAtTime(line->Start, agi::vfr::START) <= frame
-		&& context->project->Timecodes().FrameAtTime(line->End, agi::vfr::END) >= frame;
+	return cache.start_frame <= frame && cache.end_frame >= frame;
 }
 
 void BaseGrid::OnCharHook(wxKeyEvent &event) {
@@ -718,6 +890,7 @@ void BaseGrid::SetByFrame(bool state) {
 	byFrame = state;
 	for (auto& column : columns)
 		column->SetByFrame(byFrame);
+	++row_cache_generation;
 	SetColumnWidths();
 	Refresh(false);
 }
@@ -32,6 +32,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <wx/bitmap.h>
 #include <wx/window.h>
 
 namespace agi {
@@ -40,6 +41,7 @@ namespace agi {
 }
 class AssDialogue;
 class GridColumn;
+class GridLineStats;
 class WidthHelper;
 
 class BaseGrid final : public wxWindow {
@@ -63,11 +65,46 @@ class BaseGrid final : public wxWindow {
 
 	/// Rows which are visible on the current video frame
 	std::vector<int> visible_rows;
+	/// Should rows visible on the current video frame be highlighted?
+	bool highlight_visible = false;
+
+	/// Values needed to paint a row which are kept between paints
+	struct RowCache {
+		/// Value of row_cache_generation when this was filled in
+		size_t generation = 0;
+		/// Frames the line starts and ends on, or -1 if there's no video
+		int start_frame = -1;
+		int end_frame = -1;
+		/// Value of each column, or empty for hidden columns
+		std::vector<wxString> values;
+	};
+	/// Cached values for each row, which are filled in when the row is
+	/// first painted
+	std::vector<RowCache> row_cache;
+	/// Incremented to invalidate every entry in row_cache
+	size_t row_cache_generation = 1;
+
+	/// The rendered grid, which is shifted rather than redrawn when scrolling
+	wxBitmap grid_bitmap;
+	/// Scratch bitmap the rendered grid is shifted into
+	wxBitmap scroll_bitmap;
+	/// Parts of grid_bitmap which need to be redrawn before the next paint
+	wxRegion dirty_region;
+
+	/// Counters for how much work painting the grid does
+	struct {
+		size_t paints = 0;
+		size_t rows_drawn = 0;
+		size_t rows_scrolled = 0;
+		double paint_ms = 0;
+	} paint_stats;
 
 	agi::Context *context; ///< Associated project context
 
 	std::vector<std::unique_ptr<GridColumn>> columns;
 	std::vector<bool> columns_visible;
+	/// Values of the lines which the column widths depend on
+	std::unique_ptr<GridLineStats> line_stats;
 
 	std::vector<wxRect> text_refresh_rects;
 
@@ -82,6 +119,15 @@ class BaseGrid final : public wxWindow {
 		wxBrush LeftCol;
 	} row_colors;
 
+	/// Cached colours used for row text and grid lines
+	struct {
+		wxColour Standard;
+		wxColour Selection;
+		wxColour Collision;
+		wxColour Lines;
+		wxColour ActiveBorder;
+	} text_colors;
+
 	std::vector<AssDialogue*> index_line_map;  ///< Row number -> dialogue line
 
 	/// Connection for video seek event. Stored explicitly so that it can be
@@ -100,14 +146,25 @@ class BaseGrid final : public wxWindow {
 	void OnScroll(wxScrollEvent &event);
 	void OnShowColMenu(wxCommandEvent &event);
 	void OnSize(wxSizeEvent &event);
-	void OnSubtitlesCommit(int type);
+	void OnSubtitlesCommit(int type, const AssDialogue *single_line);
 	void OnActiveLineChanged(AssDialogue *);
 	void OnSeek();
 
 	void AdjustScrollbar();
 	void SetColumnWidths();
 
-	bool IsDisplayed(const AssDialogue *line) const;
+	/// Get the cached values for a row, filling them in if needed
+	RowCache const& GetRowCache(int row);
+	/// Discard the cached values for the rows changed by a commit
+	void InvalidateRows(int type, const AssDialogue *single_line);
+	/// Draw the part of the grid in rect
+	/// @return Number of rows drawn
+	size_t DrawRect(wxDC &dc, wxRect const& rect);
+	/// Shift the rendered grid after scrolling from old_pos to yPos, so
+	/// that only the newly exposed rows have to be drawn
+	void ScrollRows(int old_pos);
+
+	bool IsDisplayed(int row);
 
 	void UpdateMaps();
 	void UpdateStyle();
@@ -129,5 +186,7 @@ public:
 	void SetByFrame(bool state);
 	void ScrollTo(int y);
 
+	void Refresh(bool eraseBackground = true, const wxRect *rect = nullptr) override;
+
 	DECLARE_EVENT_TABLE()
 };
@@ -94,6 +94,32 @@ class DataBlockCache {
 		age.erase(mb.position);
 	}
 
+	/// @brief Get the slot for a block, marking its macroblock as most recently used
+	/// @param i Index of the block
+	typename BlockFactoryT::BlockType& Touch(size_t i)
+	{
+		size_t mbi = i >> MacroblockExponent;
+		assert(mbi < data.size());
+
+		auto &mb = data[mbi];
+
+		// Move this macroblock to the front of the age list
+		if (mb.blocks.empty())
+		{
+			mb.blocks.resize(macroblock_size);
+			age.push_front(&mb);
+		}
+		else if (mb.position != begin(age))
+			age.splice(begin(age), age, mb.position);
+
+		mb.position = age.begin();
+
+		size_t block_index = i & macroblock_index_mask;
+		assert(block_index < mb.blocks.size());
+
+		return mb.blocks[block_index];
+	}
+
 public:
 	/// @brief Constructor
 	/// @param block_count Total number of blocks the cache will manage
@@ -165,31 +191,13 @@ public:
 	/// It is legal to pass 0 (null) for created, in this case nothing is returned in it.
 	BlockT& Get(size_t i, bool *created = nullptr)
 	{
-		size_t mbi = i >> MacroblockExponent;
-		assert(mbi < data.size());
-
-		auto &mb = data[mbi];
-
-		// Move this macroblock to the front of the age list
-		if (mb.blocks.empty())
-		{
-			mb.blocks.resize(macroblock_size);
-			age.push_front(&mb);
-		}
-		else if (mb.position != begin(age))
-			age.splice(begin(age), age, mb.position);
-
-		mb.position = age.begin();
-
-		size_t block_index = i & macroblock_index_mask;
-		assert(block_index < mb.blocks.size());
-
-		BlockT *b = mb.blocks[block_index].get();
+		auto& slot = Touch(i);
+		BlockT *b = slot.get();
 
 		if (!b)
 		{
-			mb.blocks[block_index] = factory.ProduceBlock(i);
-			b = mb.blocks[block_index].get();
+			slot = factory.ProduceBlock(i);
+			b = slot.get();
 			assert(b != nullptr);
 			size += factory.GetBlockSize();
 
@@ -200,4 +208,34 @@ public:
 
 		return *b;
 	}
+
+	/// @brief Obtain a data block from the cache only if it is already present
+	/// @param i Index of the block to retrieve
+	/// @return A pointer to the block in cache, or nullptr if it has not been produced
+	///
+	/// Used by owners which produce blocks asynchronously and store them with Insert.
+	/// A miss does not allocate the block's macroblock or change its age.
+	BlockT *TryGet(size_t i)
+	{
+		size_t mbi = i >> MacroblockExponent;
+		assert(mbi < data.size());
+
+		auto &mb = data[mbi];
+		if (mb.blocks.empty() || !mb.blocks[i & macroblock_index_mask])
+			return nullptr;
+
+		return Touch(i).get();
+	}
+
+	/// @brief Store a block produced outside of the cache
+	/// @param i     Index of the block to store
+	/// @param block The block; replaces any existing block with the same index
+	void Insert(size_t i, typename BlockFactoryT::BlockType block)
+	{
+		assert(block != nullptr);
+		auto& slot = Touch(i);
+		if (!slot)
+			size += factory.GetBlockSize();
+		slot = std::move(block);
+	}
 };
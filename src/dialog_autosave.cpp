@@ -141,6 +141,12 @@ void DialogAutosave::Populate(std::map<wxString, AutosaveFile> &files_map, std::
 		if (!date.IsValid())
 			date = wxFileName(directory, fn).GetModificationTime();
 
+		// Autosaves with a journal include the changes made up until the
+		// journal was last written to
+		wxFileName journal(directory, fn + ".journal");
+		if (journal.FileExists())
+			date = journal.GetModificationTime();
+
 		auto it = files_map.find(name);
 		if (it == files_map.end())
 			it = files_map.insert({name, AutosaveFile{name}}).first;
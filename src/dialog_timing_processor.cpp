@@ -40,13 +40,12 @@
 #include "selection_controller.h"
 #include "utils.h"
 
-#include <libaegisub/address_of_adaptor.h>
 #include <libaegisub/ass/time.h>
+#include <libaegisub/ass/timing_processor.h>
 
 #include <algorithm>
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/algorithm.hpp>
-#include <boost/range/algorithm_ext/push_back.hpp>
 #include <functional>
 #include <vector>
 #include <wx/button.h>
@@ -334,12 +333,18 @@ std::vector<AssDialogue*> DialogTimingProcessor::SortDialogues() {
 	std::vector<AssDialogue*> sorted;
 
 	auto valid_line = [&](const AssDialogue *d) { return !d->Comment && styles.count(d->Style); };
-	if (onlySelection->IsChecked())
+	if (onlySelection->IsChecked()) {
+		// Only the selected lines need to be sorted
 		boost::copy(c->selectionController->GetSelectedSet() | filtered(valid_line),
 		    back_inserter(sorted));
+		boost::sort(sorted, [](const AssDialogue *a, const AssDialogue *b) {
+			return a->Start < b->Start;
+		});
+	}
 	else {
-		sorted.reserve(c->ass->Events.size());
-		boost::push_back(sorted, c->ass->Events | agi::address_of | filtered(valid_line));
+		// The file's time index is already in order of start time
+		sorted = c->ass->LinesByStart();
+		sorted.erase(boost::remove_if(sorted, [&](const AssDialogue *d) { return !valid_line(d); }), sorted.end());
 	}
 
 	// Check if rows are valid
@@ -354,9 +359,6 @@ std::vector<AssDialogue*> DialogTimingProcessor::SortDialogues() {
 		}
 	}
 
-	boost::sort(sorted, [](const AssDialogue *a, const AssDialogue *b) {
-		return a->Start < b->Start;
-	});
 	return sorted;
 }
 
@@ -368,53 +370,20 @@ static int get_closest_kf(std::vector<int> const& kf, int frame) {
 	return (pos == begin(kf) || *pos - frame < frame - *(pos - 1)) ? *pos : *(pos - 1);
 }
 
-template<class Iter, class Field>
-static int safe_time(Iter begin, Iter end, AssDialogue *comp, int initial, Field field, int const& (*cmp)(int const&, int const&)) {
-	// Compare to every previous line (yay for O(n^2)!) to see if it's OK to add lead-in
-	for (; begin != end; ++begin) {
-		// If the line doesn't already collide with this line, extend it only
-		// to the edge of the line
-		if (!comp->CollidesWith(*begin))
-			initial = cmp(initial, (*begin)->*field);
-	}
-	return initial;
-}
-
 void DialogTimingProcessor::Process() {
 	std::vector<AssDialogue*> sorted = SortDialogues();
 	if (sorted.empty()) return;
 
 	// Add lead-in/out
-	if (hasLeadIn->IsChecked() && leadIn) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->Start = safe_time(sorted.rend() - i, sorted.rend(),
-				sorted[i], sorted[i]->Start - leadIn,
-				&AssDialogue::End, &std::max<int>);
-	}
+	if (hasLeadIn->IsChecked() && leadIn)
+		agi::ass::AddLeadIn(sorted, leadIn);
 
-	if (hasLeadOut->IsChecked() && leadOut) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->End = safe_time(sorted.begin() + i + 1, sorted.end(),
-				sorted[i], sorted[i]->End + leadOut,
-				&AssDialogue::Start, &std::min<int>);
-	}
+	if (hasLeadOut->IsChecked() && leadOut)
+		agi::ass::AddLeadOut(sorted, leadOut);
 
 	// Make adjacent
-	if (adjsEnable->IsChecked()) {
-		double bias = adjacentBias->GetValue() / 100.0;
-
-		for (size_t i = 1; i < sorted.size(); ++i) {
-			AssDialogue *prev = sorted[i - 1];
-			AssDialogue *cur = sorted[i];
-
-			int dist = cur->Start - prev->End;
-			if ((dist < 0 && -dist <= adjOverlap) || (dist > 0 && dist <= adjGap)) {
-				int setPos = prev->End + int(dist * bias);
-				cur->Start = setPos;
-				prev->End = setPos;
-			}
-		}
-	}
+	if (adjsEnable->IsChecked())
+		agi::ass::MakeAdjacent(sorted, adjGap, adjOverlap, adjacentBias->GetValue() / 100.0);
 
 	// Keyframe snapping
 	if (keysEnable->IsChecked()) {
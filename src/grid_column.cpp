@@ -75,22 +75,115 @@ int WidthHelper::operator()(const wchar_t *str) {
 	return dc->GetTextExtent(str).GetWidth();
 }
 
-void GridColumn::UpdateWidth(const agi::Context *c, WidthHelper &helper) {
+namespace {
+template<typename Counts, typename Value>
+void count(Counts& counts, Value const& value, bool add) {
+	if (add)
+		++counts[value];
+	else {
+		auto it = counts.find(value);
+		if (it != counts.end() && --it->second == 0)
+			counts.erase(it);
+	}
+}
+
+int max_value(std::map<int, size_t> const& counts) {
+	return counts.empty() ? 0 : std::max(0, counts.rbegin()->first);
+}
+}
+
+void GridLineStats::Count(LineValues const& values, bool add) {
+	count(layers, values.layer, add);
+	count(starts, values.start, add);
+	count(ends, values.end, add);
+	for (size_t i = 0; i < margins.size(); ++i)
+		count(margins[i], values.margin[i], add);
+	count(styles, values.style, add);
+	count(actors, values.actor, add);
+	count(effects, values.effect, add);
+}
+
+void GridLineStats::Update(AssDialogue const& line) {
+	LineValues values{line.Layer, line.Start, line.End, line.Margin,
+		line.Style, line.Actor, line.Effect, generation};
+
+	auto it = lines.find(&line);
+	if (it == lines.end()) {
+		Count(values, true);
+		lines.emplace(&line, values);
+		return;
+	}
+
+	auto& old = it->second;
+	old.generation = generation;
+	if (old.layer == values.layer && old.start == values.start && old.end == values.end
+		&& old.margin == values.margin && old.style == values.style
+		&& old.actor == values.actor && old.effect == values.effect)
+		return;
+
+	Count(old, false);
+	Count(values, true);
+	old = values;
+}
+
+void GridLineStats::Commit(AssFile const& file, int type, const AssDialogue *single_line) {
+	if (type == AssFile::COMMIT_NEW) {
+		lines.clear();
+		layers.clear();
+		starts.clear();
+		ends.clear();
+		for (auto& margin : margins)
+			margin.clear();
+		styles.clear();
+		actors.clear();
+		effects.clear();
+		lines.reserve(file.Events.size());
+	}
+	else if (!(type & (AssFile::COMMIT_DIAG_ADDREM | AssFile::COMMIT_DIAG_META | AssFile::COMMIT_DIAG_TIME)))
+		return;
+	else if (single_line && !(type & AssFile::COMMIT_DIAG_ADDREM)) {
+		Update(*single_line);
+		return;
+	}
+
+	// Compare every line to the values it had before, then drop the lines
+	// which weren't seen as they've been removed. This only has to touch the
+	// counts for the lines which actually changed.
+	++generation;
+	for (auto const& line : file.Events)
+		Update(line);
+
+	if (lines.size() == file.Events.size()) return;
+	for (auto it = lines.begin(); it != lines.end(); ) {
+		if (it->second.generation == generation)
+			++it;
+		else {
+			Count(it->second, false);
+			it = lines.erase(it);
+		}
+	}
+}
+
+int GridLineStats::MaxLayer() const { return max_value(layers); }
+int GridLineStats::MaxStart() const { return max_value(starts); }
+int GridLineStats::MaxEnd() const { return max_value(ends); }
+int GridLineStats::MaxMargin(int index) const { return max_value(margins[index]); }
+
+void GridColumn::UpdateWidth(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) {
 	if (!visible) {
 		width = 0;
 		return;
 	}
 
-	width = Width(c, helper);
+	width = Width(c, stats, helper);
 	if (width) // 10 is an arbitrary amount of padding
 		width = 10 + std::max(width, helper(Header()));
 }
 
-void GridColumn::Paint(wxDC &dc, int x, int y, const AssDialogue *d, const agi::Context *c) const {
-	wxString str = Value(d, c);
+void GridColumn::Paint(wxDC &dc, int x, int y, const AssDialogue *, wxString const& value, const agi::Context *) const {
 	if (Centered())
-		x += (width - 6 - dc.GetTextExtent(str).GetWidth()) / 2;
-	dc.DrawText(str, x + 4, y + 2);
+		x += (width - 6 - dc.GetTextExtent(value).GetWidth()) / 2;
+	dc.DrawText(value, x + 4, y + 2);
 }
 
 namespace {
@@ -110,21 +203,11 @@ struct GridColumnLineNumber final : GridColumn {
 		return std::to_wstring(d->Row + 1);
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
 		return helper(Value(&c->ass->Events.back()));
 	}
 };
 
-template<typename T>
-T max_value(T AssDialogueBase::*field, EntryList<AssDialogue> const& lines) {
-	T value = 0;
-	for (AssDialogue const& line : lines) {
-		if (line.*field > value)
-			value = line.*field;
-	}
-	return value;
-}
-
 struct GridColumnLayer final : GridColumn {
 	COLUMN_HEADER(_("L"))
 	COLUMN_DESCRIPTION(_("Layer"))
@@ -134,8 +217,8 @@ struct GridColumnLayer final : GridColumn {
 		return d->Layer ? wxString(std::to_wstring(d->Layer)) : wxString();
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
-		int max_layer = max_value(&AssDialogue::Layer, c->ass->Events);
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
+		int max_layer = stats.MaxLayer();
 		return max_layer == 0 ? 0 : helper(std::to_wstring(max_layer));
 	}
 };
@@ -157,10 +240,10 @@ struct GridColumnStartTime final : GridColumnTime {
 		return to_wx(d->Start.GetAssFormatted());
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
 		if (!by_frame)
 			return helper(wxS("0:00:00.00"));
-		int frame = c->videoController->FrameAtTime(max_value(&AssDialogue::Start, c->ass->Events), agi::vfr::START);
+		int frame = c->videoController->FrameAtTime(stats.MaxStart(), agi::vfr::START);
 		return helper(std::to_wstring(frame));
 	}
 };
@@ -175,21 +258,20 @@ struct GridColumnEndTime final : GridColumnTime {
 		return to_wx(d->End.GetAssFormatted());
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
 		if (!by_frame)
 			return helper(wxS("0:00:00.00"));
-		int frame = c->videoController->FrameAtTime(max_value(&AssDialogue::End, c->ass->Events), agi::vfr::END);
+		int frame = c->videoController->FrameAtTime(stats.MaxEnd(), agi::vfr::END);
 		return helper(std::to_wstring(frame));
 	}
 };
 
-template<typename T>
-int max_width(T AssDialogueBase::*field, EntryList<AssDialogue> const& lines, WidthHelper &helper) {
+template<typename Counts>
+int max_width(Counts const& values, WidthHelper &helper) {
 	int w = 0;
-	for (AssDialogue const& line : lines) {
-		auto const& v = line.*field;
-		if (v.get().empty()) continue;
-		int width = helper(v);
+	for (auto const& v : values) {
+		if (v.first.get().empty()) continue;
+		int width = helper(v.first);
 		if (width > w)
 			w = width;
 	}
@@ -205,8 +287,8 @@ struct GridColumnStyle final : GridColumn {
 		return to_wx(d->Style);
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
-		return max_width(&AssDialogue::Style, c->ass->Events, helper);
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
+		return max_width(stats.Styles(), helper);
 	}
 };
 
@@ -219,8 +301,8 @@ struct GridColumnEffect final : GridColumn {
 		return to_wx(d->Effect);
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
-		return max_width(&AssDialogue::Effect, c->ass->Events, helper);
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
+		return max_width(stats.Effects(), helper);
 	}
 };
 
@@ -233,8 +315,8 @@ struct GridColumnActor final : GridColumn {
 		return to_wx(d->Actor);
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
-		return max_width(&AssDialogue::Actor, c->ass->Events, helper);
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
+		return max_width(stats.Actors(), helper);
 	}
 };
 
@@ -248,12 +330,8 @@ struct GridColumnMargin : GridColumn {
 		return d->Margin[index] ? wxString(std::to_wstring(d->Margin[index])) : wxString();
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
-		int max = 0;
-		for (AssDialogue const& line : c->ass->Events) {
-			if (line.Margin[index] > max)
-				max = line.Margin[index];
-		}
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
+		int max = stats.MaxMargin(index);
 		return max == 0 ? 0 : helper(std::to_wstring(max));
 	}
 };
@@ -302,9 +380,8 @@ public:
 
 	int CPS(const AssDialogue *d) const {
 		int duration = d->End - d->Start;
-		auto const& text = d->Text.get();
 
-		if (duration <= 100 || text.size() > static_cast<size_t>(duration))
+		if (duration <= 100 || d->Text.get().size() > static_cast<size_t>(duration))
 			return -1;
 
 		int ignore = agi::IGNORE_BLOCKS;
@@ -313,14 +390,14 @@ public:
 		if (ignore_punctuation->GetBool())
 			ignore |= agi::IGNORE_PUNCTUATION;
 
-		return agi::CharacterCount(text, ignore) * 1000 / duration;
+		return d->CharacterCount(ignore) * 1000 / duration;
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
 		return helper(wxS("999"));
 	}
 
-	void Paint(wxDC &dc, int x, int y, const AssDialogue *d, const agi::Context *) const override {
+	void Paint(wxDC &dc, int x, int y, const AssDialogue *d, wxString const&, const agi::Context *) const override {
 		int cps = CPS(d);
 		if (cps < 0 || cps > 100) return;
 
@@ -394,7 +471,7 @@ public:
 		return str;
 	}
 
-	int Width(const agi::Context *c, WidthHelper &helper) const override {
+	int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const override {
 		return 5000;
 	}
 };
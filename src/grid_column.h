@@ -16,12 +16,15 @@
 
 #include "flyweight_hash.h"
 
+#include <array>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
 class AssDialogue;
+class AssFile;
 class wxDC;
 class wxString;
 namespace agi { struct Context; }
@@ -49,13 +52,67 @@ public:
 	int operator()(const wchar_t *str);
 };
 
+/// @class GridLineStats
+/// @brief Counts of the values of the line fields which column widths depend on
+///
+/// The widths of most columns depend on the largest value of a field over
+/// every line. Rather than scanning every line each time the widths are
+/// updated, the number of lines with each value is kept and updated from
+/// the lines changed by each commit.
+class GridLineStats {
+	typedef std::unordered_map<boost::flyweight<std::string>, size_t> StringCounts;
+
+	struct LineValues {
+		int layer;
+		int start;
+		int end;
+		std::array<int, 3> margin;
+		boost::flyweight<std::string> style;
+		boost::flyweight<std::string> actor;
+		boost::flyweight<std::string> effect;
+		/// Value of generation when the line was last checked
+		size_t generation;
+	};
+
+	/// Values of each line when it was last checked. The lines are only used
+	/// as keys, as removed lines have already been deleted when commits are
+	/// announced.
+	std::unordered_map<const AssDialogue *, LineValues> lines;
+	size_t generation = 0;
+
+	std::map<int, size_t> layers;
+	std::map<int, size_t> starts;
+	std::map<int, size_t> ends;
+	std::array<std::map<int, size_t>, 3> margins;
+	StringCounts styles;
+	StringCounts actors;
+	StringCounts effects;
+
+	void Count(LineValues const& values, bool add);
+	void Update(AssDialogue const& line);
+
+public:
+	/// Update the counts after a commit
+	/// @param file File which was committed
+	/// @param type AssFile::CommitType of the commit
+	/// @param single_line Line which was changed, if only one line was
+	void Commit(AssFile const& file, int type, const AssDialogue *single_line);
+
+	int MaxLayer() const;
+	int MaxStart() const;
+	int MaxEnd() const;
+	int MaxMargin(int index) const;
+	StringCounts const& Styles() const { return styles; }
+	StringCounts const& Actors() const { return actors; }
+	StringCounts const& Effects() const { return effects; }
+};
+
 class GridColumn {
 protected:
 	int width = 0;
 	bool visible = true;
 
-	virtual int Width(const agi::Context *c, WidthHelper &helper) const = 0;
-	virtual wxString Value(const AssDialogue *d, const agi::Context *c) const = 0;
+	virtual int Width(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper) const = 0;
 
 public:
 	virtual ~GridColumn() = default;
@@ -66,12 +123,15 @@ public:
 
 	virtual wxString const& Header() const = 0;
 	virtual wxString const& Description() const = 0;
-	virtual void Paint(wxDC &dc, int x, int y, const AssDialogue *d, const agi::Context *c) const;
+	virtual wxString Value(const AssDialogue *d, const agi::Context *c) const = 0;
+	/// Paint the column for a line
+	/// @param value Value(d, c), which the grid keeps between paints
+	virtual void Paint(wxDC &dc, int x, int y, const AssDialogue *d, wxString const& value, const agi::Context *c) const;
 
 	int Width() const { return width; }
 	bool Visible() const { return visible; }
 
-	virtual void UpdateWidth(const agi::Context *c, WidthHelper &helper);
+	virtual void UpdateWidth(const agi::Context *c, GridLineStats const& stats, WidthHelper &helper);
 	virtual void SetByFrame(bool /* by_frame */) { }
 	void SetVisible(bool new_value) { visible = new_value; }
 };
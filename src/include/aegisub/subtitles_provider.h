@@ -39,14 +39,52 @@
 #include <vector>
 
 class AssFile;
+struct AssDialogueBase;
 struct VideoFrame;
 
 class SubtitlesProvider {
+public:
+	/// An event to add in an incremental update
+	struct NewEvent {
+		const AssDialogueBase *line;
+		/// Position of the line among the events passed to the renderer
+		int read_order;
+	};
+
+private:
 	std::vector<char> buffer;
+	/// Everything but the events from the last full load, used to detect
+	/// when only events have changed
+	std::vector<char> loaded_header;
+	/// Copies of the events the renderer currently has loaded, in order
+	struct LoadedEvents;
+	std::unique_ptr<LoadedEvents> loaded;
+	/// Set once UpdateEvents has reported that it isn't supported
+	bool full_reload_only = false;
+
+	/// Try to bring the loaded events up to date without a full reload
+	bool UpdateLoadedEvents(AssFile *subs, int time);
+
 	virtual void LoadSubtitles(const char *data, size_t len)=0;
 
+	/// @brief Update the events of the loaded script in place
+	/// @param removed     Sorted indices of the events to remove, counting the
+	///                    events in the order they were loaded or added
+	/// @param read_orders New position of each event which isn't removed
+	/// @param added       Events to append after removing the old ones
+	/// @return false if the renderer doesn't support incremental updates
+	virtual bool UpdateEvents(std::vector<size_t> const& removed, std::vector<int> const& read_orders, std::vector<NewEvent> const& added) { return false; }
+
 public:
-	virtual ~SubtitlesProvider() = default;
+	SubtitlesProvider();
+	virtual ~SubtitlesProvider();
+
+	/// @brief Load a subtitle file
+	/// @param subs File to load
+	/// @param time If not negative, only load the lines visible at this time
+	///
+	/// If only events have changed since the previous call, the changed
+	/// events are updated in place rather than reloading the entire file.
 	void LoadSubtitles(AssFile *subs, int time = -1);
 	virtual void DrawSubtitles(VideoFrame &dst, double time)=0;
 	virtual void Reinitialize() { }
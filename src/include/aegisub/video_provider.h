@@ -78,6 +78,12 @@ public:
 	/// @return Returns true if caching is desired, false otherwise.
 	virtual bool WantsCaching() const { return false; }
 
+	/// @brief Does this provider keep recently decoded frames in memory?
+	///
+	/// If so, decoding a frame before it is requested makes the later request
+	/// for it cheap.
+	virtual bool IsCaching() const { return false; }
+
 	/// Should the video properties in the script be set to this video's property if they already have values?
 	virtual bool ShouldSetVideoProperties() const { return true; }
 
@@ -37,6 +37,7 @@
 #include "command/command.h"
 #include "include/aegisub/hotkey.h"
 
+#include "ass_dialogue.h"
 #include "auto4_base.h"
 #include "auto4_lua_factory.h"
 #include "compat.h"
@@ -337,7 +338,7 @@ bool AegisubApp::OnInit() {
 #endif
 
 	StartupLog("Clean old autosave files");
-	CleanCache(config::path->Decode(OPT_GET("Path/Auto/Save")->GetString()), "*.AUTOSAVE.ass", 100, 1000);
+	CleanCache(config::path->Decode(OPT_GET("Path/Auto/Save")->GetString()), "*.AUTOSAVE.ass", 100, 1000, ".journal");
 
 	StartupLog("Initialization complete");
 	return true;
@@ -362,6 +363,13 @@ int AegisubApp::OnExit() {
 
 	AssExportFilterChain::Clear();
 
+	auto text_stats = AssDialogue::GetTextCacheStats();
+	LOG_I("ass/text_cache")
+		<< "hits: " << text_stats.hits
+		<< " misses: " << text_stats.misses
+		<< " evictions: " << text_stats.evictions
+		<< " peak size: " << (text_stats.peak_size >> 20) << " MB";
+
 	// Keep this last!
 	delete agi::log::log;
 	crash_writer::Cleanup();
@@ -376,6 +376,7 @@ void Advanced_Audio(wxTreebook *book, Preferences *parent) {
 	wxArrayString ct_choice(3, ct_arr);
 	p->OptionChoice(cache, _("Cache type"), ct_choice, "Audio/Cache/Type");
 	p->OptionBrowse(cache, _("Path"), "Audio/Cache/HD/Location");
+	p->OptionAdd(cache, _("Remember waveforms between sessions"), "Audio/Cache/Peaks/Enabled");
 
 	auto spectrum = p->PageSizer(_("Spectrum"));
 
@@ -241,9 +241,10 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 	if (!progress)
 		progress = new DialogProgress(context->parent);
 
+	std::unique_ptr<agi::AudioProvider> new_provider;
 	try {
 		try {
-			audio_provider = GetAudioProvider(path, *context->path, progress);
+			new_provider = GetAudioProvider(path, *context->path, progress);
 		}
 		catch (agi::UserCancelException const&) { return; }
 		catch (...) {
@@ -269,6 +270,9 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 		return ShowError(e.GetMessage());
 	}
 
+	// Keep the old provider alive until everything has switched to the new
+	// one, as the audio display may still be reading from it in the background
+	audio_provider.swap(new_provider);
 	SetPath(audio_file, "?audio", "Audio", path);
 	AnnounceAudioProviderModified(audio_provider.get());
 }
@@ -305,7 +309,7 @@ bool Project::DoLoadVideo(agi::fs::path const& path) {
 	AnnounceVideoProviderModified(video_provider.get());
 
 	UpdateVideoProperties(context->ass.get(), video_provider.get(), context->parent);
-	video_provider->LoadSubtitles(context->ass.get());
+	video_provider->LoadSubtitles(context->subsController->Snapshot());
 
 	timecodes = video_provider->GetFPS();
 	keyframes = video_provider->GetKeyFrames();
@@ -24,6 +24,7 @@
 #include "text_selection_controller.h"
 
 #include <libaegisub/exception.h>
+#include <libaegisub/parallel_batches.h>
 #include <libaegisub/util.h>
 
 #include <boost/locale/conversion.hpp>
@@ -52,18 +53,16 @@ std::string const& get_normalized(const AssDialogue *diag, decltype(&AssDialogue
 	return value.get();
 }
 
-typedef std::function<MatchState (const AssDialogue*, size_t)> matcher;
+/// Matcher for the normalized value of a field
+typedef std::function<MatchState (std::string const&, size_t)> matcher;
 
 class noop_accessor {
-	boost::flyweight<std::string> AssDialogueBase::*field;
 	size_t start = 0;
 
 public:
-	noop_accessor(SearchReplaceSettings::Field f) : field(get_dialogue_field(f)) { }
-
-	std::string get(const AssDialogue *d, size_t s) {
+	std::string get(std::string const& str, size_t s) {
 		start = s;
-		return get_normalized(d, field).substr(s);
+		return str.substr(s);
 	}
 
 	MatchState make_match_state(size_t s, size_t e, boost::u32regex *r = nullptr) {
@@ -72,14 +71,11 @@ public:
 };
 
 class skip_tags_accessor {
-	boost::flyweight<std::string> AssDialogueBase::*field;
 	agi::util::tagless_find_helper helper;
 
 public:
-	skip_tags_accessor(SearchReplaceSettings::Field f) : field(get_dialogue_field(f)) { }
-
-	std::string get(const AssDialogue *d, size_t s) {
-		return helper.strip_tags(get_normalized(d, field), s);
+	std::string get(std::string const& str, size_t s) {
+		return helper.strip_tags(str, s);
 	}
 
 	MatchState make_match_state(size_t s, size_t e, boost::u32regex *r = nullptr) {
@@ -97,9 +93,9 @@ matcher get_matcher(SearchReplaceSettings const& settings, Accessor&& a) {
 
 		auto regex = boost::make_u32regex(settings.find, flags);
 
-		return [=](const AssDialogue *diag, size_t start) mutable -> MatchState {
+		return [=](std::string const& text, size_t start) mutable -> MatchState {
 			boost::smatch result;
-			auto const& str = a.get(diag, start);
+			auto const& str = a.get(text, start);
 			if (!u32regex_search(str, result, regex, start > 0 ? boost::match_not_bol : boost::match_default))
 				return bad_match;
 			return a.make_match_state(result.position(), result.position() + result.length(), &regex);
@@ -113,8 +109,8 @@ matcher get_matcher(SearchReplaceSettings const& settings, Accessor&& a) {
 	if (!settings.match_case)
 		look_for = boost::locale::fold_case(look_for);
 
-	return [=](const AssDialogue *diag, size_t start) mutable -> MatchState {
-		const auto str = a.get(diag, start);
+	return [=](std::string const& text, size_t start) mutable -> MatchState {
+		const auto str = a.get(text, start);
 		if (full_match_only && str.size() != look_for.size())
 			return bad_match;
 
@@ -128,6 +124,68 @@ matcher get_matcher(SearchReplaceSettings const& settings, Accessor&& a) {
 	};
 }
 
+matcher get_matcher(SearchReplaceSettings const& settings) {
+	if (settings.skip_tags)
+		return get_matcher(settings, skip_tags_accessor());
+	return get_matcher(settings, noop_accessor());
+}
+
+/// Number of lines ReplaceAll searches in each background job
+const size_t replace_block_size = 500;
+
+struct replace_input {
+	/// The value of the field being searched, or its normalized form if that
+	/// is already known
+	const std::string *text;
+	bool normalized;
+};
+
+struct replace_output {
+	/// The normalized value of the field, if it wasn't already known
+	std::string normalized;
+	/// The new value of the field, if count is nonzero
+	std::string replaced;
+	/// Number of matches which were replaced
+	size_t count = 0;
+};
+
+/// Do the replacements for a block of lines, with a matcher of its own so
+/// that nothing is shared with the other threads
+std::vector<replace_output> replace_block(SearchReplaceSettings const& settings, std::vector<replace_input> const& block) {
+	auto matches = get_matcher(settings);
+	std::vector<replace_output> results(block.size());
+
+	for (size_t i = 0; i < block.size(); ++i) {
+		auto& result = results[i];
+		if (!block[i].normalized)
+			result.normalized = boost::locale::normalize(*block[i].text);
+		auto const& text = block[i].normalized ? *block[i].text : result.normalized;
+
+		if (settings.use_regex) {
+			if (MatchState ms = matches(text, 0)) {
+				result.count = std::distance(
+					boost::u32regex_iterator<std::string::const_iterator>(begin(text), end(text), *ms.re),
+					boost::u32regex_iterator<std::string::const_iterator>());
+				result.replaced = u32regex_replace(text, *ms.re, settings.replace_with);
+			}
+			continue;
+		}
+
+		std::string value = text;
+		size_t pos = 0;
+		while (MatchState ms = matches(value, pos)) {
+			++result.count;
+			value = value.substr(0, ms.start) + settings.replace_with + value.substr(ms.end);
+			pos = ms.start + settings.replace_with.size();
+			value = boost::locale::normalize(value);
+		}
+		if (result.count)
+			result.replaced = std::move(value);
+	}
+
+	return results;
+}
+
 template<typename Iterator, typename Container>
 Iterator circular_next(Iterator it, Container& c) {
 	++it;
@@ -139,9 +197,11 @@ Iterator circular_next(Iterator it, Container& c) {
 }
 
 std::function<MatchState (const AssDialogue*, size_t)> SearchReplaceEngine::GetMatcher(SearchReplaceSettings const& settings) {
-	if (settings.skip_tags)
-		return get_matcher(settings, skip_tags_accessor(settings.field));
-	return get_matcher(settings, noop_accessor(settings.field));
+	auto field = get_dialogue_field(settings.field);
+	auto matches = get_matcher(settings);
+	return [=](const AssDialogue *diag, size_t start) {
+		return matches(get_normalized(diag, field), start);
+	};
 }
 
 SearchReplaceEngine::SearchReplaceEngine(agi::Context *c)
@@ -238,36 +298,69 @@ bool SearchReplaceEngine::ReplaceAll() {
 	if (!initialized)
 		return false;
 
-	size_t count = 0;
-
-	auto matches = GetMatcher(settings);
+	// Compile the regex here so that a bad one is reported before anything
+	// is started
+	get_matcher(settings);
 
+	auto field = get_dialogue_field(settings.field);
 	auto const& sel = context->selectionController->GetSelectedSet();
 	bool selection_only = settings.limit_to == SearchReplaceSettings::Limit::SELECTED;
 
+	std::vector<AssDialogue *> lines;
 	for (auto& diag : context->ass->Events) {
 		if (selection_only && !sel.count(&diag)) continue;
 		if (settings.ignore_comments && diag.Comment) continue;
+		lines.push_back(&diag);
+	}
 
-		if (settings.use_regex) {
-			if (MatchState ms = matches(&diag, 0)) {
-				auto& diag_field = diag.*get_dialogue_field(settings.field);
-				std::string const& text = diag_field.get();
-				count += std::distance(
-					boost::u32regex_iterator<std::string::const_iterator>(begin(text), end(text), *ms.re),
-					boost::u32regex_iterator<std::string::const_iterator>());
-				diag_field = u32regex_replace(text, *ms.re, settings.replace_with);
-			}
-			continue;
+	// The lines are searched in blocks on the background queue while this
+	// thread waits, so nothing modifies them until all of the blocks are done
+	auto block_settings = settings;
+	agi::parallel_batches<std::vector<replace_input>, std::vector<replace_output>> blocks(
+		[=](std::vector<replace_input>& block) { return replace_block(block_settings, block); }, 1);
+
+	std::vector<replace_input> block;
+	for (auto diag : lines) {
+		auto const& text = (diag->*field).get();
+		auto it = normalized_cache.find(&text);
+		if (it != normalized_cache.end())
+			block.push_back(replace_input{&it->second.second, true});
+		else
+			block.push_back(replace_input{&text, false});
+
+		if (block.size() == replace_block_size) {
+			blocks.add(std::move(block));
+			block.clear();
 		}
+	}
+	blocks.add(std::move(block));
 
-		size_t pos = 0;
-		while (MatchState ms = matches(&diag, pos)) {
-			++count;
-			Replace(&diag, ms);
-			pos = ms.end;
+	std::vector<replace_output> results;
+	results.reserve(lines.size());
+	blocks.finish([&](std::vector<replace_output> output) {
+		std::move(output.begin(), output.end(), std::back_inserter(results));
+	});
+
+	// Keep the normalized text of the lines which didn't change for the next
+	// search, dropping everything which is no longer in the file
+	decltype(normalized_cache) cache;
+	size_t count = 0;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		auto& value = lines[i]->*field;
+		auto& result = results[i];
+		if (result.count) {
+			count += result.count;
+			value = result.replaced;
+			continue;
 		}
+
+		auto it = normalized_cache.find(&value.get());
+		if (it != normalized_cache.end())
+			cache.insert(*it);
+		else
+			cache.emplace(&value.get(), std::make_pair(value, std::move(result.normalized)));
 	}
+	normalized_cache = std::move(cache);
 
 	if (count > 0) {
 		context->ass->Commit(_("replace"), AssFile::COMMIT_DIAG_TEXT);
@@ -15,8 +15,11 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include <functional>
+#include <boost/flyweight.hpp>
 #include <boost/regex/icu.hpp>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 namespace agi { struct Context; }
 class AssDialogue;
@@ -59,6 +62,13 @@ class SearchReplaceEngine {
 	bool initialized = false;
 	SearchReplaceSettings settings;
 
+	/// Normalized forms of the field values seen by the last ReplaceAll,
+	/// keyed by the address of the interned value. Each entry holds a
+	/// reference to the value so that the address can't be reused for a
+	/// different string, which means that lines whose text has changed
+	/// simply miss the cache.
+	std::unordered_map<const std::string *, std::pair<boost::flyweight<std::string>, std::string>> normalized_cache;
+
 	bool FindReplace(bool replace);
 	void Replace(AssDialogue *line, MatchState &ms);
 
@@ -20,6 +20,7 @@
 #include "ass_dialogue.h"
 #include "ass_file.h"
 #include "ass_info.h"
+#include "ass_parser.h"
 #include "ass_style.h"
 #include "compat.h"
 #include "command/command.h"
@@ -30,14 +31,24 @@
 #include "project.h"
 #include "selection_controller.h"
 #include "subtitle_format.h"
+#include "subtitle_format_ass.h"
 #include "text_selection_controller.h"
 
+#include <libaegisub/ass/journal.h>
 #include <libaegisub/dispatch.h>
 #include <libaegisub/format_path.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/io.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/split.h>
 #include <libaegisub/util.h>
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <wx/msgdlg.h>
 
 namespace {
@@ -50,78 +61,328 @@ namespace {
 	}
 }
 
+namespace {
+/// Number of lines in each separately shared block of an undo state
+const size_t undo_chunk_size = 256;
+
+typedef AssFileSnapshot::EventChunk EventChunk;
+
+/// Get the AssFile::CommitType flags for the differences between two lines
+int line_changes(AssDialogueBase const& a, AssDialogueBase const& b) {
+	int type = 0;
+	if (a.Comment != b.Comment || a.Layer != b.Layer || a.Margin != b.Margin || a.Style != b.Style
+		|| a.Actor != b.Actor || a.Effect != b.Effect || a.ExtradataIds != b.ExtradataIds)
+		type |= AssFile::COMMIT_DIAG_META;
+	if (a.Start.GetExactTime() != b.Start.GetExactTime() || a.End.GetExactTime() != b.End.GetExactTime())
+		type |= AssFile::COMMIT_DIAG_TIME;
+	if (a.Text != b.Text)
+		type |= AssFile::COMMIT_DIAG_TEXT;
+	return type;
+}
+
+bool same_line(AssDialogueBase const& a, AssDialogueBase const& b) {
+	return a.Id == b.Id && !line_changes(a, b);
+}
+
+bool same_attachment(AssAttachment const& a, AssAttachment const& b) {
+	// The data is a flyweight, so identical data has the same address
+	return &a.GetEntryData() == &b.GetEntryData() && a.GetFileName(true) == b.GetFileName(true);
+}
+
+bool same_extradata(ExtradataEntry const& a, ExtradataEntry const& b) {
+	return a.id == b.id && a.key == b.key && a.value == b.value;
+}
+
+/// Do two ranges have the same length and equal elements? The entry lists
+/// don't know their size, so this can't just check the sizes up front.
+template<typename Range1, typename Range2, typename Equal>
+bool same_contents(Range1 const& a, Range2 const& b, Equal eq) {
+	auto it_a = a.begin();
+	auto it_b = b.begin();
+	for (; it_a != a.end() && it_b != b.end(); ++it_a, ++it_b) {
+		if (!eq(*it_a, *it_b))
+			return false;
+	}
+	return it_a == a.end() && it_b == b.end();
+}
+
+/// Reuse prev if it has the same contents as cur, otherwise make a copy of cur
+template<typename T, typename Equal>
+std::shared_ptr<const std::vector<T>> share(std::shared_ptr<const std::vector<T>> const& prev, std::vector<T> cur, Equal eq, size_t& size) {
+	if (prev && same_contents(*prev, cur, eq))
+		return prev;
+	size += sizeof(std::vector<T>) + cur.size() * sizeof(T);
+	return std::make_shared<const std::vector<T>>(std::move(cur));
+}
+}
+
+/// @class SubsController::UndoInfo
+/// @brief A snapshot of the file for the undo stack
+///
+/// The file is stored as an AssFileSnapshot, and parts which are unchanged
+/// from the previous state are shared with it rather than copied. Lines are
+/// stored in fixed-size chunks of shared lines, so that a commit which
+/// changes a few lines only has to copy the chunks containing them.
 struct SubsController::UndoInfo {
 	wxString undo_description;
 	int commit_id;
 
-	std::vector<std::pair<std::string, std::string>> script_info;
-	std::vector<AssStyle> styles;
-	std::vector<AssDialogueBase> events;
-	std::vector<AssAttachment> attachments;
-	std::vector<ExtradataEntry> extradata;
+	std::shared_ptr<const AssFileSnapshot> file;
+
+	/// Approximate number of bytes allocated for this state which are not
+	/// shared with the state it was built from
+	size_t unshared_size = 0;
 
 	mutable std::vector<int> selection;
 	int active_line_id = 0;
 	int pos = 0, sel_start = 0, sel_end = 0;
 
-	UndoInfo(const agi::Context *c, wxString const& d, int commit_id)
+	UndoInfo(const agi::Context *c, wxString const& d, int commit_id, const UndoInfo *prev, int type, const AssDialogue *single_line)
 	: undo_description(d)
 	, commit_id(commit_id)
-	, attachments(c->ass->Attachments)
-	, extradata(c->ass->Extradata)
 	{
-		script_info.reserve(c->ass->Info.size());
-		for (auto const& info : c->ass->Info)
-			script_info.emplace_back(info.Key(), info.Value());
-
-		styles.reserve(c->ass->Styles.size());
-		styles.assign(c->ass->Styles.begin(), c->ass->Styles.end());
-
-		events.reserve(c->ass->Events.size());
-		events.assign(c->ass->Events.begin(), c->ass->Events.end());
+		auto const& file = *c->ass;
+		auto prev_file = prev ? prev->file.get() : nullptr;
+		auto snapshot = std::make_shared<AssFileSnapshot>();
+
+		std::vector<std::pair<std::string, std::string>> info;
+		info.reserve(file.Info.size());
+		for (auto const& line : file.Info)
+			info.emplace_back(line.Key(), line.Value());
+		snapshot->script_info = share(prev_file ? prev_file->script_info : nullptr, std::move(info),
+			std::equal_to<std::pair<std::string, std::string>>(), unshared_size);
+
+		snapshot->styles = share(prev_file ? prev_file->styles : nullptr, std::vector<AssStyle>(file.Styles.begin(), file.Styles.end()),
+			[](AssStyle const& a, AssStyle const& b) { return a.GetEntryData() == b.GetEntryData(); }, unshared_size);
+
+		snapshot->attachments = share(prev_file ? prev_file->attachments : nullptr, file.Attachments, same_attachment, unshared_size);
+		snapshot->extradata = share(prev_file ? prev_file->extradata : nullptr, file.Extradata, same_extradata, unshared_size);
+		snapshot->next_extradata_id = file.next_extradata_id;
+
+		const bool lines_moved = type == AssFile::COMMIT_NEW || (type & (AssFile::COMMIT_DIAG_ADDREM | AssFile::COMMIT_ORDER));
+		if (prev_file && !lines_moved && single_line && single_line->Row >= 0) {
+			// Share everything but the chunk containing the one changed line
+			snapshot->events = prev_file->events;
+			if (!ReplaceLine(snapshot->events, *single_line)) {
+				LOG_W("subs/undo") << "Changed line " << single_line->Id << " is not in the previous state; copying the whole file";
+				snapshot->events.clear();
+				ShareEvents(prev_file, file, snapshot->events);
+			}
+			else
+				unshared_size += snapshot->events.capacity() * sizeof(EventChunk::value_type);
+		}
+		else
+			ShareEvents(prev_file, file, snapshot->events);
+		this->file = std::move(snapshot);
 
 		UpdateActiveLine(c);
 		UpdateSelection(c);
 		UpdateTextSelection(c);
 	}
 
+	/// Build the chunks of lines, reusing the lines and chunks of prev where
+	/// they are unchanged
+	void ShareEvents(const AssFileSnapshot *prev, AssFile const& file, std::vector<std::shared_ptr<const EventChunk>>& events) {
+		// Lookup table for lines of prev which aren't where they were before,
+		// only built if needed
+		std::unordered_map<int, std::shared_ptr<const AssDialogueBase> const*> prev_by_id;
+		auto find_moved = [&](AssDialogue const& line) -> std::shared_ptr<const AssDialogueBase> const* {
+			if (!prev) return nullptr;
+			if (prev_by_id.empty()) {
+				for (auto const& chunk : prev->events) {
+					for (auto const& prev_line : *chunk)
+						prev_by_id[prev_line->Id] = &prev_line;
+				}
+			}
+			auto it = prev_by_id.find(line.Id);
+			return it != prev_by_id.end() && same_line(*it->second->get(), line) ? it->second : nullptr;
+		};
+
+		auto it = file.Events.begin(), end = file.Events.end();
+		for (size_t i = 0; it != end; ++i) {
+			auto prev_chunk = prev && i < prev->events.size() ? prev->events[i].get() : nullptr;
+
+			EventChunk chunk;
+			chunk.reserve(undo_chunk_size);
+			bool unchanged = !!prev_chunk;
+			for (; it != end && chunk.size() < undo_chunk_size; ++it) {
+				size_t j = chunk.size();
+				if (prev_chunk && j < prev_chunk->size() && same_line(*(*prev_chunk)[j], *it))
+					chunk.push_back((*prev_chunk)[j]);
+				else {
+					unchanged = false;
+					if (auto moved = find_moved(*it))
+						chunk.push_back(*moved);
+					else {
+						chunk.push_back(std::make_shared<const AssDialogueBase>(*it));
+						unshared_size += sizeof(AssDialogueBase);
+					}
+				}
+			}
+
+			if (unchanged && chunk.size() == prev_chunk->size())
+				events.push_back(prev->events[i]);
+			else {
+				events.push_back(std::make_shared<const EventChunk>(std::move(chunk)));
+				unshared_size += sizeof(EventChunk) + undo_chunk_size * sizeof(EventChunk::value_type);
+			}
+		}
+		unshared_size += events.capacity() * sizeof(events[0]);
+	}
+
+	/// Replace the copy of a line with a new version, copying this state's
+	/// snapshot so that anything still reading the old one is unaffected
+	/// @return false if the line is not in this state
+	bool ReplaceLine(AssDialogue const& line) {
+		auto snapshot = std::make_shared<AssFileSnapshot>(*file);
+		if (!ReplaceLine(snapshot->events, line)) return false;
+		file = std::move(snapshot);
+		return true;
+	}
+
+	/// Replace the copy of a line with a new version, copying its chunk
+	/// @return false if the line is not in events
+	bool ReplaceLine(std::vector<std::shared_ptr<const EventChunk>>& events, AssDialogue const& line) {
+		size_t chunk_index = line.Row / undo_chunk_size;
+		size_t line_index = line.Row % undo_chunk_size;
+		if (chunk_index >= events.size() || line_index >= events[chunk_index]->size()
+			|| (*events[chunk_index])[line_index]->Id != line.Id)
+		{
+			// Row is out of date, so look for the line
+			for (chunk_index = 0; chunk_index < events.size(); ++chunk_index) {
+				auto const& chunk = *events[chunk_index];
+				auto it = find_if(begin(chunk), end(chunk), [&](std::shared_ptr<const AssDialogueBase> const& l) { return l->Id == line.Id; });
+				if (it != end(chunk)) {
+					line_index = it - begin(chunk);
+					break;
+				}
+			}
+			if (chunk_index == events.size()) return false;
+		}
+
+		auto chunk = std::make_shared<EventChunk>(*events[chunk_index]);
+		(*chunk)[line_index] = std::make_shared<const AssDialogueBase>(line);
+		events[chunk_index] = std::move(chunk);
+		unshared_size += sizeof(EventChunk) + undo_chunk_size * sizeof(EventChunk::value_type) + sizeof(AssDialogueBase);
+		return true;
+	}
+
+	/// @brief Make the file match this state
+	///
+	/// Only the parts of the file which differ from this state are changed,
+	/// and lines which still exist keep their AssDialogue objects, so that
+	/// the commit can announce just what changed rather than COMMIT_NEW.
 	void Apply(agi::Context *c) const {
-		// Keep old dialogue lines alive until after the commit is complete
+		auto& file = *c->ass;
+		int type = 0;
+
+		auto const& script_info = this->file->script_info;
+		auto const& styles = this->file->styles;
+		auto const& attachments = this->file->attachments;
+		auto const& extradata = this->file->extradata;
+
+		if (!same_contents(file.Info, *script_info,
+			[](AssInfo const& a, std::pair<std::string, std::string> const& b) { return a.Key() == b.first && a.Value() == b.second; }))
+		{
+			file.Info.clear();
+			for (auto const& info : *script_info)
+				file.Info.emplace_back(info.first, info.second);
+			type |= AssFile::COMMIT_SCRIPTINFO;
+		}
+
+		if (!same_contents(file.Styles, *styles,
+			[](AssStyle const& a, AssStyle const& b) { return a.GetEntryData() == b.GetEntryData(); }))
+		{
+			file.Styles.clear_and_dispose([](AssStyle *e) { delete e; });
+			for (auto const& style : *styles)
+				file.Styles.push_back(*new AssStyle(style));
+			type |= AssFile::COMMIT_STYLES;
+		}
+
+		if (!same_contents(file.Attachments, *attachments, same_attachment)) {
+			file.Attachments = *attachments;
+			type |= AssFile::COMMIT_ATTACHMENT;
+		}
+
+		if (!same_contents(file.Extradata, *extradata, same_extradata)) {
+			file.Extradata = *extradata;
+			type |= AssFile::COMMIT_EXTRADATA;
+		}
+
+		// Keep removed dialogue lines alive until after the commit is complete
 		// since a bunch of stuff holds references to them
 		AssFile old;
-		old.Events.swap(c->ass->Events);
-		c->ass->Info.clear();
-		c->ass->Attachments.clear();
-		c->ass->Styles.clear();
-		c->ass->Extradata.clear();
+		type |= ApplyEvents(file.Events, old.Events);
 
 		sort(begin(selection), end(selection));
-
 		AssDialogue *active_line = nullptr;
 		Selection new_sel;
-
-		for (auto const& info : script_info)
-			c->ass->Info.push_back(*new AssInfo(info.first, info.second));
-		for (auto const& style : styles)
-			c->ass->Styles.push_back(*new AssStyle(style));
-		c->ass->Attachments = attachments;
-		for (auto const& event : events) {
-			auto copy = new AssDialogue(event);
-			c->ass->Events.push_back(*copy);
-			if (copy->Id == active_line_id)
-				active_line = copy;
-			if (binary_search(begin(selection), end(selection), copy->Id))
-				new_sel.insert(copy);
+		for (auto& line : file.Events) {
+			if (line.Id == active_line_id)
+				active_line = &line;
+			if (binary_search(begin(selection), end(selection), line.Id))
+				new_sel.insert(&line);
 		}
-		c->ass->Extradata = extradata;
 
-		c->ass->Commit("", AssFile::COMMIT_NEW);
+		// COMMIT_NEW is zero, so an empty change can't be committed
+		if (type)
+			file.Commit("", type);
 		c->selectionController->SetSelectionAndActive(std::move(new_sel), active_line);
 
 		c->textSelectionController->SetInsertionPoint(pos);
 		c->textSelectionController->SetSelection(sel_start, sel_end);
 	}
 
+	/// @brief Update the lines of a file to match this state
+	/// @param[in,out] lines   Lines of the file
+	/// @param[out]    removed Lines which are not in this state
+	/// @return The AssFile::CommitType flags for the changes made
+	int ApplyEvents(EntryList<AssDialogue>& lines, EntryList<AssDialogue>& removed) const {
+		int type = 0;
+		auto const& events = file->events;
+
+		std::unordered_map<int, std::pair<AssDialogue *, size_t>> live;
+		size_t i = 0;
+		for (auto& line : lines)
+			live[line.Id] = std::make_pair(&line, i++);
+
+		EntryList<AssDialogue> new_lines;
+		size_t last_pos = 0;
+		int row = 0;
+		for (auto const& chunk : events) {
+			for (auto const& event : *chunk) {
+				AssDialogue *line;
+				auto it = live.find(event->Id);
+				if (it == live.end()) {
+					line = new AssDialogue(*event);
+					type |= AssFile::COMMIT_DIAG_ADDREM;
+				}
+				else {
+					line = it->second.first;
+					if (it->second.second < last_pos)
+						type |= AssFile::COMMIT_ORDER;
+					last_pos = it->second.second;
+
+					int changes = line_changes(*line, *event);
+					if (changes)
+						static_cast<AssDialogueBase&>(*line) = *event;
+					type |= changes;
+					lines.erase(lines.iterator_to(*line));
+					live.erase(it);
+				}
+				line->Row = row++;
+				new_lines.push_back(*line);
+			}
+		}
+
+		// Anything left over was added after this state
+		if (!lines.empty())
+			type |= AssFile::COMMIT_DIAG_ADDREM;
+		removed.splice(removed.end(), lines);
+		lines.swap(new_lines);
+		return type;
+	}
+
 	void UpdateActiveLine(const agi::Context *c) {
 		auto line = c->selectionController->GetActiveLine();
 		if (line)
@@ -143,6 +404,284 @@ struct SubsController::UndoInfo {
 	}
 };
 
+namespace {
+/// Names of the non-dialogue sections written to autosave journals
+const char *section_names[] = {"info", "styles", "attachments", "extradata"};
+
+/// @brief Apply the commits in an autosave journal to its snapshot
+/// @param file    The snapshot the journal was written for
+/// @param journal Path to the journal
+///
+/// Each commit is checked and its lines are parsed before any of it is
+/// applied, and replay stops at the first commit which can't be applied,
+/// keeping the ones before it.
+void replay_journal(AssFile& file, agi::fs::path const& journal) {
+	std::vector<int> ids;
+	std::vector<agi::ass::JournalCommit> commits;
+	if (!agi::ass::ReadJournal(*agi::io::Open(journal), ids, commits)) {
+		LOG_E("subs/autosave") << "Ignoring " << journal << ": not an autosave journal";
+		return;
+	}
+
+	// Ids in the journal are the ones the lines had when the snapshot was
+	// written, which are not the ones they have now
+	std::unordered_map<int, AssDialogue *> lines;
+	{
+		auto line = file.Events.begin();
+		auto id = ids.begin();
+		for (; id != ids.end() && line != file.Events.end(); ++id, ++line)
+			lines[*id] = &*line;
+		if (line != file.Events.end() || id != ids.end()) {
+			LOG_E("subs/autosave") << "Ignoring " << journal << ": it does not match the snapshot";
+			return;
+		}
+	}
+	std::unordered_set<int> live(ids.begin(), ids.end());
+
+	size_t applied = 0;
+	for (auto const& commit : commits) {
+		if (!agi::ass::CheckJournalCommit(live, commit)) {
+			LOG_E("subs/autosave") << "Stopped replaying " << journal << ": commit refers to unknown lines";
+			break;
+		}
+
+		std::vector<std::unique_ptr<AssDialogue>> new_lines;
+		// Replaced sections are parsed into a scratch file and swapped in
+		AssFile sections;
+		std::vector<std::string> replaced;
+		try {
+			AssParser parser(&sections, 1);
+			for (auto const& r : commit) {
+				switch (r.type) {
+				case agi::ass::JournalRecord::Type::Line:
+					new_lines.push_back(agi::make_unique<AssDialogue>(r.data));
+					break;
+				case agi::ass::JournalRecord::Type::Section:
+					if (!std::count(std::begin(section_names), std::end(section_names), r.data)
+						|| std::count(replaced.begin(), replaced.end(), r.data))
+						throw agi::InvalidInputException("Unknown or repeated section " + r.data);
+					replaced.push_back(r.data);
+					break;
+				case agi::ass::JournalRecord::Type::SectionLine:
+					parser.AddLine(r.data);
+					break;
+				case agi::ass::JournalRecord::Type::Remove:
+					break;
+				}
+			}
+			// Finishes any attachment at the end of a section
+			parser.AddLine("");
+			parser.Finish();
+		}
+		catch (agi::Exception const& e) {
+			LOG_E("subs/autosave") << "Stopped replaying " << journal << ": " << e.GetMessage();
+			break;
+		}
+		catch (std::exception const& e) {
+			LOG_E("subs/autosave") << "Stopped replaying " << journal << ": " << e.what();
+			break;
+		}
+
+		// Nothing below can fail now that the commit has been checked
+		for (auto const& name : replaced) {
+			if (name == "info")
+				file.Info.swap(sections.Info);
+			else if (name == "styles")
+				file.Styles.swap(sections.Styles);
+			else if (name == "attachments")
+				file.Attachments.swap(sections.Attachments);
+			else if (name == "extradata") {
+				file.Extradata.swap(sections.Extradata);
+				file.next_extradata_id = std::max(file.next_extradata_id, sections.next_extradata_id);
+			}
+		}
+
+		auto new_line = new_lines.begin();
+		for (auto const& r : commit) {
+			if (r.type != agi::ass::JournalRecord::Type::Line && r.type != agi::ass::JournalRecord::Type::Remove)
+				continue;
+			auto& line = lines[r.id];
+			delete line;
+			line = nullptr;
+			if (r.type == agi::ass::JournalRecord::Type::Remove) continue;
+
+			line = new_line++->release();
+			if (r.after == 0)
+				file.Events.push_front(*line);
+			else
+				file.Events.insert(++file.Events.iterator_to(*lines[r.after]), *line);
+		}
+		++applied;
+	}
+
+	int row = 0;
+	for (auto& line : file.Events)
+		line.Row = row++;
+	LOG_I("subs/autosave") << "Replayed " << applied << " of " << commits.size() << " commits from " << journal;
+}
+}
+
+/// @class SubsController::AutosaveJournal
+/// @brief The changes to the file since the last autosave snapshot
+///
+/// The journal is an append-only text file next to the snapshot, in the
+/// format described in libaegisub/ass/journal.h. Dialogue lines are
+/// journaled individually, while the other parts of the file are rewritten
+/// as a whole section when they change.
+struct SubsController::AutosaveJournal {
+	agi::fs::path path;
+
+	// The parts of the undo state the journal was last brought up to date with
+	std::shared_ptr<const std::vector<std::pair<std::string, std::string>>> script_info;
+	std::shared_ptr<const std::vector<AssStyle>> styles;
+	std::shared_ptr<const std::vector<AssAttachment>> attachments;
+	std::shared_ptr<const std::vector<ExtradataEntry>> extradata;
+	std::vector<std::shared_ptr<const EventChunk>> events;
+
+	struct line_info {
+		const AssDialogueBase *line;
+		int prev_id;
+	};
+	/// The last journaled version of each line and the line before it
+	std::unordered_map<int, line_info> lines;
+
+	/// Number of records written since the snapshot
+	size_t records = 0;
+
+	AutosaveJournal(agi::fs::path path, UndoInfo const& state)
+	: path(std::move(path))
+	, script_info(state.file->script_info)
+	, styles(state.file->styles)
+	, attachments(state.file->attachments)
+	, extradata(state.file->extradata)
+	, events(state.file->events)
+	{
+		int prev_id = 0;
+		for (auto const& chunk : events) {
+			for (auto const& line : *chunk) {
+				lines[line->Id] = line_info{line.get(), prev_id};
+				prev_id = line->Id;
+			}
+		}
+	}
+
+	/// Contents of a new journal file for the snapshot
+	std::string Header() const {
+		std::vector<int> ids;
+		for (auto const& chunk : events) {
+			for (auto const& line : *chunk)
+				ids.push_back(line->Id);
+		}
+		return agi::ass::JournalHeader(ids);
+	}
+
+	/// @brief Bring the journal up to date with a state
+	/// @return The records for the changes, or an empty string if there are none
+	std::string Update(UndoInfo const& state) {
+		auto const& file = *state.file;
+		std::string out;
+		auto add_section = [&](const char *name, std::vector<std::string> const& lines) {
+			agi::ass::JournalSection(out, name, lines);
+			records += lines.size() + 1;
+		};
+
+		// The other parts of the file are small and rarely change, so they're
+		// journaled by writing out the whole part when anything in it changes
+		if (script_info != file.script_info) {
+			std::vector<std::string> lines{"[Script Info]"};
+			for (auto const& info : *file.script_info)
+				lines.push_back(info.first + ": " + info.second);
+			add_section("info", lines);
+			script_info = file.script_info;
+		}
+
+		if (styles != file.styles) {
+			std::vector<std::string> lines{"[V4+ Styles]"};
+			for (auto const& style : *file.styles)
+				lines.push_back(style.GetEntryData());
+			add_section("styles", lines);
+			styles = file.styles;
+		}
+
+		if (attachments != file.attachments) {
+			std::vector<std::string> lines;
+			const AssAttachment *prev = nullptr;
+			for (auto const& attachment : *file.attachments) {
+				if (!prev || prev->Group() != attachment.Group())
+					lines.push_back(attachment.GroupHeader());
+				for (auto line : agi::Split(attachment.GetEntryData(), '\n')) {
+					auto trimmed = agi::Trim(line);
+					if (!trimmed.empty())
+						lines.push_back(agi::str(trimmed));
+				}
+				prev = &attachment;
+			}
+			add_section("attachments", lines);
+			attachments = file.attachments;
+		}
+
+		if (extradata != file.extradata) {
+			std::vector<std::string> lines{"[Aegisub Extradata]"};
+			for (auto const& entry : *file.extradata)
+				lines.push_back(ExtradataEntryData(entry));
+			add_section("extradata", lines);
+			extradata = file.extradata;
+		}
+
+		auto const& new_events = file.events;
+		auto add_line = [&](AssDialogueBase const& line, int prev_id) {
+			agi::ass::JournalAddLine(out, line.Id, prev_id, AssDialogue(line).GetEntryData());
+			++records;
+		};
+
+		std::vector<bool> old_chunk_kept(events.size());
+		std::unordered_set<int> seen;
+		int prev_id = 0;
+		for (size_t i = 0; i < new_events.size(); ++i) {
+			auto const& chunk = *new_events[i];
+			if (chunk.empty()) continue;
+
+			// Chunks which are shared with the last journaled state only need
+			// to be looked at if the line before them has changed
+			if (i < events.size() && events[i] == new_events[i]) {
+				auto it = lines.find(chunk.front()->Id);
+				if (it != lines.end() && it->second.prev_id == prev_id) {
+					old_chunk_kept[i] = true;
+					prev_id = chunk.back()->Id;
+					continue;
+				}
+			}
+
+			for (auto const& line : chunk) {
+				seen.insert(line->Id);
+				auto it = lines.find(line->Id);
+				if (it == lines.end() || it->second.prev_id != prev_id
+					|| (it->second.line != line.get() && !same_line(*it->second.line, *line)))
+				{
+					add_line(*line, prev_id);
+				}
+				lines[line->Id] = line_info{line.get(), prev_id};
+				prev_id = line->Id;
+			}
+		}
+
+		for (size_t i = 0; i < events.size(); ++i) {
+			if (old_chunk_kept[i]) continue;
+			for (auto const& line : *events[i]) {
+				if (seen.count(line->Id)) continue;
+				agi::ass::JournalRemoveLine(out, line->Id);
+				lines.erase(line->Id);
+				++records;
+			}
+		}
+
+		events = new_events;
+		if (!out.empty())
+			agi::ass::JournalEndCommit(out);
+		return out;
+	}
+};
+
 SubsController::SubsController(agi::Context *context)
 : context(context)
 , undo_connection(context->ass->AddUndoManager(&SubsController::OnCommit, this))
@@ -170,6 +709,11 @@ ProjectProperties SubsController::Load(agi::fs::path const& filename, std::strin
 
 	SubtitleFormat::GetReader(filename, charset)->ReadFile(&temp, filename, context->project->Timecodes(), charset);
 
+	auto journal_path = filename;
+	journal_path += ".journal";
+	if (agi::fs::FileExists(journal_path))
+		replay_journal(temp, journal_path);
+
 	context->ass->swap(temp);
 	auto props = context->ass->Properties;
 
@@ -178,6 +722,7 @@ ProjectProperties SubsController::Load(agi::fs::path const& filename, std::strin
 	// Push the initial state of the file onto the undo stack
 	undo_stack.clear();
 	redo_stack.clear();
+	journal.reset();
 	autosaved_commit_id = saved_commit_id = commit_id + 1;
 	context->ass->Commit("", AssFile::COMMIT_NEW);
 
@@ -214,6 +759,15 @@ void SubsController::Save(agi::fs::path const& filename, std::string const& enco
 		context->ass->CleanExtradata();
 		writer->WriteFile(context->ass.get(), filename, 0, encoding);
 		FileSave();
+
+		// A journal left next to the file would be replayed onto the wrong
+		// lines the next time it's opened
+		auto journal_path = filename;
+		journal_path += ".journal";
+		if (journal && journal->path == journal_path)
+			journal.reset();
+		if (agi::fs::FileExists(journal_path))
+			agi::fs::Remove(journal_path);
 	}
 	catch (...) {
 		autosaved_commit_id = old_autosaved_commit_id;
@@ -227,6 +781,7 @@ void SubsController::Save(agi::fs::path const& filename, std::string const& enco
 void SubsController::Close() {
 	undo_stack.clear();
 	redo_stack.clear();
+	journal.reset();
 	autosaved_commit_id = saved_commit_id = commit_id + 1;
 	filename.clear();
 	AssFile blank;
@@ -253,8 +808,45 @@ int SubsController::TryToClose(bool allow_cancel) const {
 }
 
 void SubsController::AutoSave() {
-	if (commit_id == autosaved_commit_id)
+	if (!journal) {
+		if (commit_id != autosaved_commit_id)
+			WriteAutosaveSnapshot();
 		return;
+	}
+
+	// Replaying a journal much longer than the file is slower than just
+	// loading a new snapshot
+	if (journal->records > std::max<size_t>(1000, journal->lines.size() / 4))
+		WriteAutosaveSnapshot();
+}
+
+void SubsController::UpdateJournal() {
+	// Snapshots are only ever written by the autosave timer, so until the
+	// first one there's nothing to journal against
+	if (undo_stack.empty() || !journal || !OPT_GET("App/Auto/Save")->GetBool())
+		return;
+
+	autosaved_commit_id = commit_id;
+	auto records = journal->Update(undo_stack.back());
+	if (records.empty()) return;
+
+	auto path = journal->path;
+	auto frame = context->frame;
+	autosave_queue->Async([path, records, frame] {
+		try {
+			agi::fs::Append(path, records);
+		}
+		catch (agi::Exception const& err) {
+			wxString msg = to_wx("Exception when attempting to autosave file: " + err.GetMessage());
+			agi::dispatch::Main().Async([frame, msg] {
+				frame->StatusTimeout(msg);
+			});
+		}
+	});
+}
+
+void SubsController::WriteAutosaveSnapshot() {
+	if (undo_stack.empty()) return;
 
 	auto directory = context->path->Decode(OPT_GET("Path/Auto/Save")->GetString());
 	if (directory.empty())
@@ -264,18 +856,33 @@ void SubsController::AutoSave() {
 	if (name.empty())
 		name = "Untitled";
 
+	auto path = directory / agi::format("%s.%s.AUTOSAVE.ass", name.string(),
+	                                    agi::util::strftime("%Y-%m-%d-%H-%M-%S"));
+	auto journal_path = path;
+	journal_path += ".journal";
+
+	auto const& state = undo_stack.back();
+	journal = agi::make_unique<AutosaveJournal>(journal_path, state);
 	autosaved_commit_id = commit_id;
+
+	// The undo state is immutable, so the file can be built from it on the
+	// autosave queue rather than copying the live file here
+	auto snapshot = state.file;
+	auto properties = context->ass->Properties;
+	auto header = journal->Header();
 	auto frame = context->frame;
-	auto subs_copy = new AssFile(*context->ass);
-	autosave_queue->Async([subs_copy, name, directory, frame] {
+	autosave_queue->Async([=] {
 		wxString msg;
-		std::unique_ptr<AssFile> subs(subs_copy);
 
 		try {
+			AssFile subs(*snapshot);
+			subs.Properties = properties;
+
 			agi::fs::CreateDirectory(directory);
-			auto path = directory /  agi::format("%s.%s.AUTOSAVE.ass", name.string(),
-			                                     agi::util::strftime("%Y-%m-%d-%H-%M-%S"));
-			SubtitleFormat::GetWriter(path)->WriteFile(subs.get(), path, 0);
+			SubtitleFormat::GetWriter(path)->WriteFile(&subs, path, 0);
+			if (agi::fs::FileExists(journal_path))
+				agi::fs::Remove(journal_path);
+			agi::fs::Append(journal_path, header);
 			msg = fmt_tl("File backup saved as \"%s\".", path);
 		}
 		catch (const agi::Exception& err) {
@@ -313,20 +920,19 @@ void SubsController::OnCommit(AssFileCommit c) {
 	commit_id = next_commit_id++;
 	// Allow coalescing only if it's the last change and the file has not been
 	// saved since the last change
+	bool amend = false;
 	if (commit_id == *c.commit_id+1 && redo_stack.empty() && saved_commit_id+1 != commit_id) {
 		// If only one line changed just modify it instead of copying the file
 		if (c.single_line && c.single_line->Group() == AssEntryGroup::DIALOGUE) {
-			for (auto& diag : undo_stack.back().events) {
-				if (diag.Id == c.single_line->Id) {
-					diag = *c.single_line;
-					break;
-				}
+			if (undo_stack.back().ReplaceLine(*c.single_line)) {
+				*c.commit_id = commit_id;
+				UpdateJournal();
+				return;
 			}
-			*c.commit_id = commit_id;
-			return;
+			LOG_W("subs/undo") << "Changed line " << c.single_line->Id << " is not in the undo state; amending with a full state";
 		}
 
-		undo_stack.pop_back();
+		amend = true;
 	}
 
 	// Make sure the file has at least one style and one dialogue line
@@ -339,7 +945,14 @@ void SubsController::OnCommit(AssFileCommit c) {
 
 	redo_stack.clear();
 
-	undo_stack.emplace_back(context, c.message, commit_id);
+	undo_stack.emplace_back(context, c.message, commit_id,
+		undo_stack.empty() ? nullptr : &undo_stack.back(), c.type, c.single_line);
+	LOG_D("subs/undo") << "commit " << commit_id << ": " << undo_stack.back().unshared_size << " bytes not shared with the previous state";
+
+	// Replace the state being amended, now that the new state has been able
+	// to share everything it can with it
+	if (amend)
+		undo_stack.erase(std::prev(undo_stack.end(), 2));
 
 	int depth = std::max<int>(OPT_GET("Limits/Undo Levels")->GetInt(), 2);
 	while ((int)undo_stack.size() > depth)
@@ -349,6 +962,7 @@ void SubsController::OnCommit(AssFileCommit c) {
 		Save(filename);
 
 	*c.commit_id = commit_id;
+	UpdateJournal();
 }
 
 void SubsController::OnActiveLineChanged() {
@@ -375,6 +989,7 @@ void SubsController::Undo() {
 	text_selection_connection.Block();
 	undo_stack.back().Apply(context);
 	text_selection_connection.Unblock();
+	UpdateJournal();
 }
 
 void SubsController::Redo() {
@@ -386,6 +1001,7 @@ void SubsController::Redo() {
 	text_selection_connection.Block();
 	undo_stack.back().Apply(context);
 	text_selection_connection.Unblock();
+	UpdateJournal();
 }
 
 wxString SubsController::GetUndoDescription() const {
@@ -396,6 +1012,10 @@ wxString SubsController::GetRedoDescription() const {
 	return IsRedoStackEmpty() ? "" : redo_stack.back().undo_description;
 }
 
+std::shared_ptr<const AssFileSnapshot> SubsController::Snapshot() const {
+	return undo_stack.empty() ? nullptr : undo_stack.back().file;
+}
+
 agi::fs::path SubsController::Filename() const {
 	if (!filename.empty()) return filename;
 
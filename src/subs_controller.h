@@ -29,6 +29,7 @@ namespace agi {
 	struct Context;
 }
 struct AssFileCommit;
+struct AssFileSnapshot;
 struct ProjectProperties;
 
 class SubsController {
@@ -59,6 +60,11 @@ class SubsController {
 	/// Queue which autosaves are performed on
 	std::unique_ptr<agi::dispatch::Queue> autosave_queue;
 
+	struct AutosaveJournal;
+	/// Changes made since the last autosave snapshot, or null if there
+	/// isn't a snapshot of the current file
+	std::unique_ptr<AutosaveJournal> journal;
+
 	/// A new file has been opened (filename)
 	agi::signal::Signal<agi::fs::path> FileOpen;
 	/// The file has been saved
@@ -70,8 +76,14 @@ class SubsController {
 	/// Set the filename, updating things like the MRU and last used path
 	void SetFileName(agi::fs::path const& file);
 
-	/// Autosave the file if there have been any chances since the last autosave
+	/// Write an autosave snapshot if the file has changed since it was last
+	/// saved, or fold the autosave journal into a new one if it has grown large
 	void AutoSave();
+	/// Append the changes in the current undo state to the autosave journal
+	void UpdateJournal();
+	/// Write the current undo state as a new autosave snapshot on the
+	/// autosave queue and start a new journal for it
+	void WriteAutosaveSnapshot();
 
 	void OnCommit(AssFileCommit c);
 	void OnActiveLineChanged();
@@ -135,4 +147,10 @@ public:
 	wxString GetUndoDescription() const;
 	/// Get the description of the first redoable change
 	wxString GetRedoDescription() const;
+
+	/// @brief Get an immutable copy of the file as of the last commit
+	///
+	/// This is O(1), and the snapshot can be read from any thread, so it
+	/// should be used instead of copying the AssFile for background work.
+	std::shared_ptr<const AssFileSnapshot> Snapshot() const;
 };
@@ -30,6 +30,7 @@
 
 #include <libaegisub/ass/uuencode.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/parallel_batches.h>
 
 DEFINE_EXCEPTION(AssParseError, SubtitleFormatParseError);
 
@@ -40,6 +41,7 @@ void AssSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename,
 	AssParser parser(target, version);
 	while (file.HasMoreLines())
 		parser.AddLine(file.ReadLineFromFile());
+	parser.Finish();
 }
 
 #ifdef _WIN32
@@ -48,6 +50,25 @@ void AssSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename,
 #define LINEBREAK "\n"
 #endif
 
+std::string ExtradataEntryData(ExtradataEntry const& edi) {
+	std::string line = "Data: ";
+	line += std::to_string(edi.id);
+	line += ",";
+	line += inline_string_encode(edi.key);
+	line += ",";
+	std::string encoded_data = inline_string_encode(edi.value);
+	if (4*edi.value.size() < 3*encoded_data.size()) {
+		// the inline_string encoding grew the data by more than uuencoding would
+		// so base64 encode it instead
+		line += "u"; // marker for uuencoding
+		line += agi::ass::UUEncode(edi.value.c_str(), edi.value.c_str() + edi.value.size(), false);
+	} else {
+		line += "e"; // marker for inline_string encoding (escaping)
+		line += encoded_data;
+	}
+	return line;
+}
+
 namespace {
 const char *format(AssEntryGroup group) {
 	if (group == AssEntryGroup::DIALOGUE)
@@ -87,6 +108,36 @@ struct Writer {
 		}
 	}
 
+	void Write(EntryList<AssDialogue> const& lines) {
+		if (lines.empty()) return;
+
+		file.WriteLineToFile("");
+		file.WriteLineToFile(lines.front().GroupHeader());
+		file.WriteLineToFile(format(AssEntryGroup::DIALOGUE), false);
+		group = AssEntryGroup::DIALOGUE;
+
+		// Format blocks of lines on the background threads, writing each
+		// block as soon as it and the ones before it are ready
+		typedef std::pair<EntryList<AssDialogue>::const_iterator, EntryList<AssDialogue>::const_iterator> block;
+		agi::parallel_batches<block, std::string> blocks([](block& lines) {
+			std::string str;
+			str.reserve(256 * 100);
+			for (auto it = lines.first; it != lines.second; ++it) {
+				it->AppendEntryData(str);
+				str += LINEBREAK;
+			}
+			return str;
+		}, 1);
+
+		auto it = lines.begin();
+		while (it != lines.end()) {
+			auto start = it;
+			for (size_t i = 0; i < 256 && it != lines.end(); ++i) ++it;
+			blocks.add(block(start, it));
+		}
+		blocks.finish([&](std::string const& str) { file.WriteLineToFile(str, false); });
+	}
+
 	void Write(ProjectProperties const& properties) {
 		file.WriteLineToFile("");
 		file.WriteLineToFile("[Aegisub Project Garbage]");
@@ -129,24 +180,8 @@ struct Writer {
 		group = AssEntryGroup::EXTRADATA;
 		file.WriteLineToFile("");
 		file.WriteLineToFile("[Aegisub Extradata]");
-		for (auto const& edi : extradata) {
-			std::string line = "Data: ";
-			line += std::to_string(edi.id);
-			line += ",";
-			line += inline_string_encode(edi.key);
-			line += ",";
-			std::string encoded_data = inline_string_encode(edi.value);
-			if (4*edi.value.size() < 3*encoded_data.size()) {
-				// the inline_string encoding grew the data by more than uuencoding would
-				// so base64 encode it instead
-				line += "u"; // marker for uuencoding
-				line += agi::ass::UUEncode(edi.value.c_str(), edi.value.c_str() + edi.value.size(), false);
-			} else {
-				line += "e"; // marker for inline_string encoding (escaping)
-				line += encoded_data;
-			}
-			file.WriteLineToFile(line);
-		}
+		for (auto const& edi : extradata)
+			file.WriteLineToFile(ExtradataEntryData(edi));
 	}
 };
 }
@@ -159,6 +194,7 @@ void AssSubtitleFormat::WriteFile(const AssFile *src, agi::fs::path const& filen
 	writer.Write(src->Attachments);
 	writer.Write(src->Events);
 	writer.WriteExtradata(src->Extradata);
+	writer.file.Finish();
 }
 
 void AssSubtitleFormat::ExportFile(const AssFile *src, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& encoding) const {
@@ -167,4 +203,5 @@ void AssSubtitleFormat::ExportFile(const AssFile *src, agi::fs::path const& file
 	writer.Write(src->Styles);
 	writer.Write(src->Attachments);
 	writer.Write(src->Events);
+	writer.file.Finish();
 }
@@ -16,6 +16,8 @@
 
 #include "subtitle_format.h"
 
+struct ExtradataEntry;
+
 class AssSubtitleFormat final : public SubtitleFormat {
 public:
 	AssSubtitleFormat() : SubtitleFormat("Advanced SubStation Alpha") { }
@@ -32,3 +34,6 @@ public:
 	// Does not write [Aegisub Project Garbage] and [Aegisub Extradata] sections when exporting
 	void ExportFile(const AssFile *src, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& encoding) const override;
 };
+
+/// Format an extradata entry as a line of an [Aegisub Extradata] section
+std::string ExtradataEntryData(ExtradataEntry const& entry);
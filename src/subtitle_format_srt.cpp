@@ -448,6 +448,7 @@ void SRTSubtitleFormat::WriteFile(const AssFile *src, agi::fs::path const& filen
 		file.WriteLineToFile(ConvertTags(&current));
 		file.WriteLineToFile("");
 	}
+	file.Finish();
 }
 
 bool SRTSubtitleFormat::CanSave(const AssFile *file) const {
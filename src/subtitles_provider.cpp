@@ -26,6 +26,10 @@
 #include "subtitles_provider_csri.h"
 #include "subtitles_provider_libass.h"
 
+#include <libaegisub/make_unique.h>
+
+#include <unordered_map>
+
 namespace {
 	struct factory {
 		std::string name;
@@ -68,6 +72,117 @@ std::unique_ptr<SubtitlesProvider> SubtitlesProviderFactory::GetProvider(agi::Ba
 	throw error;
 }
 
+struct SubtitlesProvider::LoadedEvents {
+	/// Events in the order the renderer has them
+	std::vector<AssDialogueBase> events;
+	/// Index in events of each line ID
+	std::unordered_map<int, size_t> index;
+
+	void Clear() {
+		events.clear();
+		index.clear();
+	}
+
+	void Push(AssDialogueBase const& line) {
+		index[line.Id] = events.size();
+		events.push_back(line);
+	}
+};
+
+SubtitlesProvider::SubtitlesProvider()
+: loaded(agi::make_unique<LoadedEvents>())
+{
+}
+
+SubtitlesProvider::~SubtitlesProvider() { }
+
+static bool renders_same(AssDialogueBase const& a, AssDialogueBase const& b) {
+	return a.Layer == b.Layer
+		&& a.Start == b.Start
+		&& a.End == b.End
+		&& a.Margin == b.Margin
+		&& a.Style == b.Style
+		&& a.Actor == b.Actor
+		&& a.Effect == b.Effect
+		&& a.Text == b.Text;
+}
+
+/// Get the lines to pass to the renderer, in file order
+static std::vector<const AssDialogue *> lines_to_load(AssFile *subs, int time) {
+	std::vector<const AssDialogue *> lines;
+	if (time >= 0) {
+		for (auto line : subs->LinesAt(time)) {
+			if (!line->Comment)
+				lines.push_back(line);
+		}
+	}
+	else {
+		for (auto const& line : subs->Events) {
+			if (!line.Comment)
+				lines.push_back(&line);
+		}
+	}
+	return lines;
+}
+
+bool SubtitlesProvider::UpdateLoadedEvents(AssFile *subs, int time) {
+	auto& events = loaded->events;
+	std::vector<bool> kept(events.size());
+	// Position of each kept event in the new file
+	std::vector<int> new_read_order(events.size());
+	std::vector<NewEvent> added;
+
+	int read_order = 0;
+	for (auto line : lines_to_load(subs, time)) {
+		auto it = loaded->index.find(line->Id);
+		if (it != loaded->index.end() && !kept[it->second] && renders_same(events[it->second], *line)) {
+			kept[it->second] = true;
+			new_read_order[it->second] = read_order;
+		}
+		else
+			added.push_back(NewEvent{line, read_order});
+		++read_order;
+	}
+
+	std::vector<size_t> removed;
+	std::vector<int> read_orders;
+	read_orders.reserve(events.size());
+	for (size_t i = 0; i < kept.size(); ++i) {
+		if (kept[i])
+			read_orders.push_back(new_read_order[i]);
+		else
+			removed.push_back(i);
+	}
+
+	if (removed.empty() && added.empty()) return true;
+
+	// Replacing most of the file isn't any faster than reloading it
+	if (removed.size() + added.size() > events.size()) return false;
+
+	if (!UpdateEvents(removed, read_orders, added)) {
+		full_reload_only = true;
+		return false;
+	}
+
+	// Mirror the changes made to the renderer's events
+	if (!removed.empty()) {
+		size_t out = 0;
+		for (size_t i = 0; i < events.size(); ++i) {
+			if (kept[i])
+				events[out++] = std::move(events[i]);
+		}
+		events.resize(out);
+
+		loaded->index.clear();
+		for (size_t i = 0; i < events.size(); ++i)
+			loaded->index[events[i].Id] = i;
+	}
+	for (auto const& event : added)
+		loaded->Push(*event.line);
+
+	return true;
+}
+
 void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
 	buffer.clear();
 
@@ -99,10 +214,22 @@ void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
 	}
 
 	push_header("[Events]\n");
-	for (auto const& line : subs->Events) {
-		if (!line.Comment && (time < 0 || !(line.Start > time || line.End <= time)))
-			push_line(line.GetEntryData());
+
+	// Edits to lines are by far the most common change, and reparsing the
+	// entire file for them is slow for large files, so update just the
+	// events which changed if the rest of the file is the same as before
+	if (!full_reload_only && buffer == loaded_header && UpdateLoadedEvents(subs, time))
+		return;
+
+	loaded_header.clear();
+	loaded->Clear();
+	auto header_size = buffer.size();
+
+	for (auto line : lines_to_load(subs, time)) {
+		push_line(line->GetEntryData());
+		loaded->Push(*line);
 	}
 
 	LoadSubtitles(&buffer[0], buffer.size());
+	loaded_header.assign(buffer.begin(), buffer.begin() + header_size);
 }
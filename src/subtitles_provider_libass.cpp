@@ -34,6 +34,7 @@
 
 #include "subtitles_provider_libass.h"
 
+#include "ass_dialogue.h"
 #include "compat.h"
 #include "include/aegisub/subtitles_provider.h"
 #include "video_frame.h"
@@ -45,6 +46,7 @@
 #include <libaegisub/make_unique.h>
 #include <libaegisub/util.h>
 
+#include <algorithm>
 #include <atomic>
 #if BOOST_VERSION >= 106900
 #include <boost/gil.hpp>
@@ -129,6 +131,8 @@ public:
 		if (!ass_track) throw agi::InternalError("libass failed to load subtitles.");
 	}
 
+	bool UpdateEvents(std::vector<size_t> const& removed, std::vector<int> const& read_orders, std::vector<NewEvent> const& added) override;
+
 	void DrawSubtitles(VideoFrame &dst, double time) override;
 
 	void Reinitialize() override {
@@ -163,6 +167,88 @@ LibassSubtitlesProvider::~LibassSubtitlesProvider() {
 	if (ass_track) ass_free_track(ass_track);
 }
 
+/// Find a style by name in the same way that libass does when parsing events
+int find_style(ASS_Track *track, std::string name) {
+	// Style names are written with commas replaced
+	std::replace(name.begin(), name.end(), ',', ';');
+	if (!name.empty() && name[0] == '*')
+		name.erase(0, 1);
+
+	for (int i = track->n_styles - 1; i >= 0; --i) {
+		if (track->styles[i].Name && name == track->styles[i].Name)
+			return i;
+	}
+	return track->default_style;
+}
+
+char *copy_string(std::string const& str) {
+	auto ret = static_cast<char *>(malloc(str.size() + 1));
+	memcpy(ret, str.c_str(), str.size() + 1);
+	return ret;
+}
+
+/// Copy a field which can't contain commas, changed in the same way as
+/// AssDialogue::GetEntryData and libass's parser would
+char *copy_field(std::string str) {
+	std::replace(str.begin(), str.end(), ',', ';');
+	auto first = str.find_first_not_of(" \t");
+	if (first == std::string::npos)
+		return copy_string("");
+	return copy_string(str.substr(first, str.find_last_not_of(" \t") + 1 - first));
+}
+
+bool LibassSubtitlesProvider::UpdateEvents(std::vector<size_t> const& removed, std::vector<int> const& read_orders, std::vector<NewEvent> const& added) {
+	if (!ass_track) return false;
+
+	// libass has no API for removing individual events, but the event array
+	// is public and ass_free_event releases everything owned by an event
+	size_t next_removed = 0;
+	int out = 0;
+	for (int i = 0; i < ass_track->n_events; ++i) {
+		if (next_removed < removed.size() && removed[next_removed] == (size_t)i) {
+			ass_free_event(ass_track, i);
+			++next_removed;
+		}
+		else
+			ass_track->events[out++] = ass_track->events[i];
+	}
+	ass_track->n_events = out;
+
+	// Lines may have been inserted before the kept events, so their read
+	// orders need updating to not collide with the new events
+	for (int i = 0; i < out; ++i)
+		ass_track->events[i].ReadOrder = read_orders[i];
+
+	// Build the events directly rather than formatting and reparsing them
+	for (auto const& event : added) {
+		auto const& line = *event.line;
+		int eid = ass_alloc_event(ass_track);
+		ASS_Event *ev = &ass_track->events[eid];
+
+		// Event times are rounded to centiseconds when written as text
+		ev->Start = (int)line.Start;
+		ev->Duration = (int)line.End - (int)line.Start;
+		ev->ReadOrder = event.read_order;
+		ev->Layer = line.Layer;
+		ev->Style = find_style(ass_track, line.Style);
+		ev->MarginL = line.Margin[0];
+		ev->MarginR = line.Margin[1];
+		ev->MarginV = line.Margin[2];
+		ev->Name = copy_field(line.Actor);
+		ev->Effect = copy_field(line.Effect);
+
+		std::string text;
+		text.reserve(line.Text.get().size());
+		for (auto c : line.Text.get()) {
+			if (c != '\n' && c != '\r')
+				text += c;
+		}
+		ev->Text = copy_string(text);
+	}
+
+	return true;
+}
+
 #define _r(c) ((c)>>24)
 #define _g(c) (((c)>>16)&0xFF)
 #define _b(c) (((c)>>8)&0xFF)
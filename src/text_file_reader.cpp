@@ -25,20 +25,39 @@
 
 TextFileReader::TextFileReader(agi::fs::path const& filename, std::string encoding, bool trim)
 : file(agi::make_unique<agi::read_file_mapping>(filename))
-, stream(agi::make_unique<boost::interprocess::ibufferstream>(file->read(), file->size()))
 , trim(trim)
-, iter(agi::line_iterator<std::string>(*stream, encoding))
 {
+	if (agi::is_utf8_compatible(encoding))
+		utf8_iter = agi::buffer_line_iterator(file->read(), file->size());
+	else {
+		stream = agi::make_unique<boost::interprocess::ibufferstream>(file->read(), file->size());
+		iter = agi::line_iterator<std::string>(*stream, encoding);
+	}
 }
 
 TextFileReader::~TextFileReader() {
 }
 
 std::string TextFileReader::ReadLineFromFile() {
-	std::string str = *iter;
-	++iter;
-	if (trim)
-		boost::trim(str);
+	std::string str;
+	if (utf8_iter != agi::buffer_line_iterator()) {
+		auto begin = utf8_iter->begin(), end = utf8_iter->end();
+		++utf8_iter;
+		if (trim) {
+			// Trim the view before copying it; the same characters as
+			// boost::trim in the C locale
+			auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+			while (begin != end && is_space(*begin)) ++begin;
+			while (begin != end && is_space(end[-1])) --end;
+		}
+		str.assign(begin, end);
+	}
+	else {
+		str = *iter;
+		++iter;
+		if (trim)
+			boost::trim(str);
+	}
 	if (boost::starts_with(str, "\xEF\xBB\xBF"))
 		str.erase(0, 3);
 	return str;
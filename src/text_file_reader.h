@@ -29,7 +29,11 @@ class TextFileReader {
 	std::unique_ptr<agi::read_file_mapping> file;
 	std::unique_ptr<std::istream> stream;
 	bool trim;
+	/// Iterator for files which need to be converted to UTF-8
 	agi::line_iterator<std::string> iter;
+	/// Iterator for files which are already UTF-8, which reads lines
+	/// directly from the mapped file
+	agi::buffer_line_iterator utf8_iter;
 
 public:
 	/// @brief Constructor
@@ -44,5 +48,7 @@ public:
 	/// @return The line, possibly trimmed
 	std::string ReadLineFromFile();
 	/// @brief Check if there are any more lines to read
-	bool HasMoreLines() const { return iter != agi::line_iterator<std::string>(); }
+	bool HasMoreLines() const {
+		return iter != agi::line_iterator<std::string>() || utf8_iter != agi::buffer_line_iterator();
+	}
 };
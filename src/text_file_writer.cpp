@@ -29,37 +29,65 @@
 
 #include <boost/algorithm/string/case_conv.hpp>
 
+namespace {
+/// Size of the blocks of text which are converted and written at once
+const size_t flush_size = 4 << 20;
+}
+
 TextFileWriter::TextFileWriter(agi::fs::path const& filename, std::string encoding)
 : file(new agi::io::Save(filename, true))
 {
 	if (encoding.empty())
 		encoding = OPT_GET("App/Save Charset")->GetString();
-	if (encoding != "utf-8" && encoding != "UTF-8") {
+	if (encoding != "utf-8" && encoding != "UTF-8")
 		conv = agi::make_unique<agi::charset::IconvWrapper>("utf-8", encoding.c_str(), true);
-		newline = conv->Convert(newline);
-	}
+
+	buffer.reserve(flush_size);
 
 	try {
 		// Write the BOM
 		WriteLineToFile("\xEF\xBB\xBF", false);
+		Flush();
 	}
 	catch (agi::charset::ConversionFailure&) {
 		// If the BOM could not be converted to the target encoding it isn't needed
+		buffer.clear();
 	}
 }
 
 TextFileWriter::~TextFileWriter() {
-	// Explicit empty destructor required with a unique_ptr to an incomplete class
+	// The file is being abandoned due to an error, so don't replace the
+	// existing file with a partial one
+	if (file)
+		file->Cancel();
 }
 
-void TextFileWriter::WriteLineToFile(std::string const& line, bool addLineBreak) {
+void TextFileWriter::Finish() {
+	Flush();
+	// Close the file here rather than in the destructor so that errors from
+	// moving it into place can be reported
+	delete file.release();
+}
+
+void TextFileWriter::Flush() {
+	if (buffer.empty()) return;
+
 	if (conv) {
-		auto converted = conv->Convert(line);
+		auto converted = conv->Convert(buffer);
 		file->Get().write(converted.data(), converted.size());
 	}
 	else
-		file->Get().write(line.data(), line.size());
+		file->Get().write(buffer.data(), buffer.size());
+	buffer.clear();
+}
 
+void TextFileWriter::WriteLineToFile(std::string const& line, bool addLineBreak) {
+	buffer += line;
 	if (addLineBreak)
-		file->Get().write(newline.data(), newline.size());
+		buffer += newline;
+
+	// Blocks always end on a line boundary, so a character is never split
+	// across two conversions
+	if (buffer.size() >= flush_size)
+		Flush();
 }
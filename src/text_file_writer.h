@@ -29,18 +29,33 @@ namespace agi {
 	namespace io { class Save; }
 }
 
+/// @class TextFileWriter
+/// @brief Write UTF-8 text to a file in the chosen encoding
+///
+/// Lines are collected in a buffer which is converted to the output encoding
+/// and written in large blocks, rather than converting and writing each line
+/// separately. Finish() must be called to write the last block and replace
+/// the target file; a writer destroyed without it leaves the file untouched.
 class TextFileWriter {
 	std::unique_ptr<agi::io::Save> file;
 	std::unique_ptr<agi::charset::IconvWrapper> conv;
+	/// Text which has been written but not yet converted and saved
+	std::string buffer;
 #ifdef _WIN32
-	std::string newline = "\r\n";
+	const char *newline = "\r\n";
 #else
-	std::string newline = "\n";
+	const char *newline = "\n";
 #endif
 
+	/// Convert and write the buffered text
+	void Flush();
+
 public:
 	TextFileWriter(agi::fs::path const& filename, std::string encoding="");
 	~TextFileWriter();
 
 	void WriteLineToFile(std::string const& line, bool addLineBreak=true);
+
+	/// Write the buffered text and move the file into place
+	void Finish();
 };
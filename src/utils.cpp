@@ -155,7 +155,7 @@ void SetClipboard(wxBitmap const& new_data) {
 	}
 }
 
-void CleanCache(agi::fs::path const& directory, std::string const& file_type, uint64_t max_size, uint64_t max_files) {
+void CleanCache(agi::fs::path const& directory, std::string const& file_type, uint64_t max_size, uint64_t max_files, std::string const& companion_suffix) {
 	static std::unique_ptr<agi::dispatch::Queue> queue;
 	if (!queue)
 		queue = agi::dispatch::Create();
@@ -165,13 +165,40 @@ void CleanCache(agi::fs::path const& directory, std::string const& file_type, ui
 		max_files = std::numeric_limits<uint64_t>::max();
 	queue->Async([=]{
 		LOG_D("utils/clean_cache") << "cleaning " << directory/file_type;
+		auto companion = [&](agi::fs::path path) {
+			path += companion_suffix;
+			return path;
+		};
+		auto size = [&](agi::fs::path const& path) {
+			uint64_t size = agi::fs::Size(path);
+			if (!companion_suffix.empty() && agi::fs::FileExists(companion(path)))
+				size += agi::fs::Size(companion(path));
+			return size;
+		};
+
+		if (!companion_suffix.empty()) {
+			for (auto const& file : agi::fs::DirectoryIterator(directory, file_type + companion_suffix)) {
+				agi::fs::path path = directory/file;
+				auto owner = path.string();
+				owner.resize(owner.size() - companion_suffix.size());
+				if (agi::fs::FileExists(owner)) continue;
+				try {
+					agi::fs::Remove(path);
+					LOG_D("utils/clean_cache") << "deleted orphaned " << path;
+				}
+				catch (agi::Exception const& e) {
+					LOG_D("utils/clean_cache") << "failed to delete file " << path << ": " << e.GetMessage();
+				}
+			}
+		}
+
 		uint64_t total_size = 0;
 		using cache_item = std::pair<int64_t, agi::fs::path>;
 		std::vector<cache_item> cachefiles;
 		for (auto const& file : agi::fs::DirectoryIterator(directory, file_type)) {
 			agi::fs::path path = directory/file;
 			cachefiles.push_back({agi::fs::ModifiedTime(path), path});
-			total_size += agi::fs::Size(path);
+			total_size += size(path);
 		}
 
 		if (cachefiles.size() <= max_files && total_size <= max_size) {
@@ -190,17 +217,19 @@ void CleanCache(agi::fs::path const& directory, std::string const& file_type, ui
 			if ((total_size <= max_size && cachefiles.size() - deleted <= max_files) || cachefiles.size() - deleted < 2)
 				break;
 
-			uint64_t size = agi::fs::Size(i.second);
+			uint64_t file_size = size(i.second);
 			try {
 				agi::fs::Remove(i.second);
 				LOG_D("utils/clean_cache") << "deleted " << i.second;
+				if (!companion_suffix.empty() && agi::fs::FileExists(companion(i.second)))
+					agi::fs::Remove(companion(i.second));
 			}
 			catch  (agi::Exception const& e) {
 				LOG_D("utils/clean_cache") << "failed to delete file " << i.second << ": " << e.GetMessage();
 				continue;
 			}
 
-			total_size -= size;
+			total_size -= file_size;
 			++deleted;
 		}
 
@@ -37,6 +37,7 @@
 #include "options.h"
 #include "project.h"
 #include "selection_controller.h"
+#include "subs_controller.h"
 #include "time_range.h"
 #include "async_video_provider.h"
 #include "utils.h"
@@ -77,7 +78,7 @@ void VideoController::OnSubtitlesCommit(int type, const AssDialogue *changed) {
 	}
 
 	if (!changed)
-		provider->LoadSubtitles(context->ass.get());
+		provider->LoadSubtitles(context->subsController->Snapshot());
 	else
 		provider->UpdateSubtitles(context->ass.get(), changed);
 }
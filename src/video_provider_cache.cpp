@@ -19,39 +19,23 @@
 #include "options.h"
 #include "video_frame.h"
 
+#include <libaegisub/log.h>
+#include <libaegisub/lru_cache.h>
 #include <libaegisub/make_unique.h>
 
-#include <list>
-
 namespace {
-/// A video frame and its frame number
-struct CachedFrame {
-	VideoFrame frame;
-	int frame_number;
-
-	CachedFrame(VideoFrame const& frame, int frame_number)
-	: frame(frame), frame_number(frame_number) { }
-
-	CachedFrame(CachedFrame const&) = delete;
-};
-
 /// @class VideoProviderCache
 /// @brief A wrapper around a video provider which provides LRU caching
 class VideoProviderCache final : public VideoProvider {
 	/// The source provider to get frames from
 	std::unique_ptr<VideoProvider> master;
 
-	/// @brief Maximum size of the cache in bytes
-	///
-	/// Note that this is a soft limit. The cache stops allocating new frames
-	/// once it has exceeded the limit, but it never tries to shrink
-	const size_t max_cache_size = OPT_GET("Provider/Video/Cache/Size")->GetInt() << 20; // convert MB to bytes
-
-	/// Cache of video frames with the most recently used ones at the front
-	std::list<CachedFrame> cache;
+	/// Recently used frames, limited to Provider/Video/Cache/Size megabytes
+	agi::lru_cache<int, VideoFrame> cache{(size_t)OPT_GET("Provider/Video/Cache/Size")->GetInt() << 20};
 
 public:
 	VideoProviderCache(std::unique_ptr<VideoProvider> master) : master(std::move(master)) { }
+	~VideoProviderCache();
 
 	void GetFrame(int n, VideoFrame &frame) override;
 
@@ -72,30 +56,26 @@ public:
 	std::string GetRealColorSpace() const override { return master->GetRealColorSpace(); }
 	bool ShouldSetVideoProperties() const override { return master->ShouldSetVideoProperties(); }
 	bool HasAudio() const override                 { return master->HasAudio(); }
+	bool IsCaching() const override                { return true; }
 };
 
-void VideoProviderCache::GetFrame(int n, VideoFrame &out) {
-	size_t total_size = 0;
-
-	for (auto cur = cache.begin(); cur != cache.end(); ++cur) {
-		if (cur->frame_number == n) {
-			cache.splice(cache.begin(), cache, cur); // Move to front
-			out = cache.front().frame;
-			return;
-		}
+VideoProviderCache::~VideoProviderCache() {
+	auto const& stats = cache.get_stats();
+	LOG_I("video/cache")
+		<< "hits: " << stats.hits
+		<< " misses: " << stats.misses
+		<< " evictions: " << stats.evictions
+		<< " peak size: " << (stats.peak_size >> 20) << " of " << (cache.capacity() >> 20) << " MB";
+}
 
-		total_size += cur->frame.data.size();
+void VideoProviderCache::GetFrame(int n, VideoFrame &out) {
+	if (auto frame = cache.get(n)) {
+		out = *frame;
+		return;
 	}
 
 	master->GetFrame(n, out);
-
-	if (total_size >= max_cache_size) {
-		cache.splice(cache.begin(), cache, --cache.end()); // Move last to front
-		cache.front().frame_number = n;
-		cache.front().frame = out;
-	}
-	else
-		cache.emplace_front(out, n);
+	cache.put(n, out, out.data.size());
 }
 }
 
@@ -118,6 +118,9 @@ class YUV4MPEGVideoProvider final : public VideoProvider {
 	int frame_sz;	/// size of each frame in bytes
 	int luma_sz;	/// size of the luma plane of each frame, in bytes
 	int chroma_sz;	/// size of one of the two chroma planes of each frame, in bytes
+	int chroma_w;	/// width of the chroma planes
+	int chroma_x_shift = 0;	/// binary log of the horizontal chroma subsampling
+	int chroma_y_shift = 0;	/// binary log of the vertical chroma subsampling
 
 	Y4M_PixelFormat pixfmt = Y4M_PIXFMT_NONE;		/// colorspace/pixel format
 	Y4M_InterlacingMode imode = Y4M_ILACE_NOTSET;	/// interlacing mode (for the entire stream)
@@ -129,6 +132,10 @@ class YUV4MPEGVideoProvider final : public VideoProvider {
 	agi::vfr::Framerate fps;
 
 	agi::ycbcr_converter conv{agi::ycbcr_matrix::bt601, agi::ycbcr_range::tv};
+	agi::ycbcr_row_converter row_conv{conv};
+
+	/// neutral chroma row used for grayscale video
+	std::vector<uint8_t> blank_chroma;
 
 	/// a list of byte positions detailing where in the file
 	/// each frame header can be found
@@ -186,12 +193,24 @@ YUV4MPEGVideoProvider::YUV4MPEGVideoProvider(agi::fs::path const& filename)
 	case Y4M_PIXFMT_420JPEG:
 	case Y4M_PIXFMT_420MPEG2:
 	case Y4M_PIXFMT_420PALDV:
-		chroma_sz	= (w * h) >> 2; break;
+		chroma_x_shift = chroma_y_shift = 1; break;
+	case Y4M_PIXFMT_411:
+		chroma_x_shift = 2; break;
+	case Y4M_PIXFMT_422:
+		chroma_x_shift = 1; break;
 	default:
-		/// @todo add support for more pixel formats
-		throw VideoOpenError("Unsupported pixel format");
+		break;
+	}
+	chroma_w	= (w + (1 << chroma_x_shift) - 1) >> chroma_x_shift;
+	chroma_sz	= chroma_w * ((h + (1 << chroma_y_shift) - 1) >> chroma_y_shift);
+	if (pixfmt == Y4M_PIXFMT_MONO) {
+		chroma_sz = 0;
+		blank_chroma.assign(w, 128);
 	}
 	frame_sz	= luma_sz + chroma_sz*2;
+	// the alpha plane is skipped
+	if (pixfmt == Y4M_PIXFMT_444ALPHA)
+		frame_sz += luma_sz;
 
 	num_frames = IndexFile(pos);
 	if (num_frames <= 0 || seek_table.empty())
@@ -390,8 +409,6 @@ int YUV4MPEGVideoProvider::IndexFile(uint64_t pos) {
 void YUV4MPEGVideoProvider::GetFrame(int n, VideoFrame &frame) {
 	n = mid(0, n, num_frames - 1);
 
-	int uv_width = w / 2;
-
 	auto src_y = reinterpret_cast<const unsigned char *>(file.read(seek_table[n], luma_sz + chroma_sz * 2));
 	auto src_u = src_y + luma_sz;
 	auto src_v = src_u + chroma_sz;
@@ -399,24 +416,12 @@ void YUV4MPEGVideoProvider::GetFrame(int n, VideoFrame &frame) {
 	unsigned char *dst = &frame.data[0];
 
 	for (int py = 0; py < h; ++py) {
-		for (int px = 0; px < w / 2; ++px) {
-			const uint8_t u = *src_u++;
-			const uint8_t v = *src_v++;
-			for (unsigned int i = 0; i < 2; ++i) {
-				const uint8_t y = *src_y++;
-				auto rgb = conv.ycbcr_to_rgb({{y, u, v}});
-				*dst++ = rgb[2];
-				*dst++ = rgb[1];
-				*dst++ = rgb[0];
-				*dst++ = 0;
-			}
-		}
-
-		// Roll back u/v on even lines
-		if (!(py & 1)) {
-			src_u -= uv_width;
-			src_v -= uv_width;
+		const unsigned char *row_u = blank_chroma.data(), *row_v = blank_chroma.data();
+		if (chroma_sz) {
+			row_u = src_u + (py >> chroma_y_shift) * chroma_w;
+			row_v = src_v + (py >> chroma_y_shift) * chroma_w;
 		}
+		row_conv.convert(src_y + py * w, row_u, row_v, chroma_x_shift, w, dst + py * w * 4);
 	}
 
 	frame.flipped = false;
@@ -116,6 +116,17 @@ bool VisualToolBase::IsDisplayed(AssDialogue *line) const {
 		&& c->videoController->FrameAtTime(line->End, agi::vfr::END) >= frame;
 }
 
+std::vector<AssDialogue *> VisualToolBase::GetDisplayedLines() const {
+	// Any line displayed on this frame has to overlap the times between the
+	// start of the previous and next frames; IsDisplayed then checks exactly
+	int frame = c->videoController->GetFrameN();
+	auto lines = c->ass->LinesInRange(
+		c->videoController->TimeAtFrame(frame - 1, agi::vfr::START),
+		c->videoController->TimeAtFrame(frame + 1, agi::vfr::START));
+	lines.erase(remove_if(begin(lines), end(lines), [&](AssDialogue *line) { return !IsDisplayed(line); }), end(lines));
+	return lines;
+}
+
 void VisualToolBase::Commit(wxString message) {
 	file_changed_connection.Block();
 	if (message.empty())
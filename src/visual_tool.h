@@ -118,6 +118,8 @@ protected:
 	/// @param message Description of changes for undo
 	virtual void Commit(wxString message = wxString());
 	bool IsDisplayed(AssDialogue *line) const;
+	/// Get all lines displayed on the current frame, in file order
+	std::vector<AssDialogue *> GetDisplayedLines() const;
 
 	/// Get the line's position if it's set, or it's default based on style if not
 	Vector2D GetLinePosition(AssDialogue *diag);
@@ -112,10 +112,8 @@ void VisualToolDrag::OnFileChanged() {
 	primary = nullptr;
 	active_feature = nullptr;
 
-	for (auto& diag : c->ass->Events) {
-		if (IsDisplayed(&diag))
-			MakeFeatures(&diag);
-	}
+	for (auto diag : GetDisplayedLines())
+		MakeFeatures(diag);
 
 	UpdateToggleButtons();
 }
@@ -127,25 +125,29 @@ void VisualToolDrag::OnFrameChanged() {
 	auto feat = features.begin();
 	auto end = features.end();
 
-	for (auto& diag : c->ass->Events) {
-		if (IsDisplayed(&diag)) {
-			// Features don't exist and should
-			if (feat == end || feat->line != &diag)
-				MakeFeatures(&diag, feat);
-			// Move past already existing features for the line
-			else
-				while (feat != end && feat->line == &diag) ++feat;
-		}
-		else {
-			// Remove all features for this line (if any)
-			while (feat != end && feat->line == &diag) {
-				if (&*feat == active_feature) active_feature = nullptr;
-				feat->line = nullptr;
-				RemoveSelection(&*feat);
-				feat = features.erase(feat);
-			}
-		}
+	auto remove_feature = [&] {
+		if (&*feat == active_feature) active_feature = nullptr;
+		feat->line = nullptr;
+		RemoveSelection(&*feat);
+		feat = features.erase(feat);
+	};
+
+	// Features are in file order, so walk them alongside the displayed lines
+	for (auto diag : GetDisplayedLines()) {
+		// Remove the features for lines which are no longer displayed
+		while (feat != end && feat->line->Row < diag->Row)
+			remove_feature();
+
+		// Features don't exist and should
+		if (feat == end || feat->line != diag)
+			MakeFeatures(diag, feat);
+		// Move past already existing features for the line
+		else
+			while (feat != end && feat->line == diag) ++feat;
 	}
+
+	while (feat != end)
+		remove_feature();
 }
 
 template<class C, class T> static bool line_not_present(C const& set, T const& it) {
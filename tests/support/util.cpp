@@ -18,6 +18,7 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <random>
 #include <sstream>
 
 namespace util {
@@ -43,4 +44,39 @@ int read_written_rand(const char *path) {
 	return value;
 }
 
+std::vector<agi::InstructionSet> supported_instruction_sets() {
+	std::vector<agi::InstructionSet> ret{agi::InstructionSet::Scalar};
+	for (auto isa : {agi::InstructionSet::SSE2, agi::InstructionSet::AVX2}) {
+		if (isa <= agi::BestInstructionSet())
+			ret.push_back(isa);
+	}
+	return ret;
+}
+
+const char *instruction_set_name(agi::InstructionSet isa) {
+	switch (isa) {
+		case agi::InstructionSet::SSE2: return "SSE2";
+		case agi::InstructionSet::AVX2: return "AVX2";
+		default: return "scalar";
+	}
+}
+
+std::vector<uint8_t> random_bytes(size_t count, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> dist(0, 255);
+	std::vector<uint8_t> ret(count);
+	for (auto& byte : ret)
+		byte = (uint8_t)dist(rng);
+	return ret;
+}
+
+std::vector<float> random_floats(size_t count, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::vector<float> ret(count);
+	for (auto& value : ret)
+		value = dist(rng);
+	return ret;
+}
+
 }
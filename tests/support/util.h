@@ -14,11 +14,25 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
+#include <libaegisub/cpu.h>
+
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace util {
 bool compare(std::string const& file1, std::string const& file2);
 
 int write_rand(const char *path);
 int read_written_rand(const char *path);
+
+/// Every instruction set the CPU running the tests supports
+std::vector<agi::InstructionSet> supported_instruction_sets();
+/// Name of an instruction set for test output
+const char *instruction_set_name(agi::InstructionSet isa);
+
+/// Bytes from a seeded generator, so that failures are reproducible
+std::vector<uint8_t> random_bytes(size_t count, unsigned seed);
+/// Floats in [-1, 1) from a seeded generator
+std::vector<float> random_floats(size_t count, unsigned seed);
 }
@@ -16,6 +16,7 @@
 
 #include <main.h>
 
+#include <libaegisub/audio/peaks.h>
 #include <libaegisub/audio/provider.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/make_unique.h>
@@ -201,7 +202,7 @@ TEST(lagi_audio, volume_should_clamp_rather_than_wrap) {
 }
 
 TEST(lagi_audio, ram_cache) {
-	auto provider = agi::CreateRAMAudioProvider(agi::make_unique<TestAudioProvider<>>());
+	auto provider = agi::CreateRAMAudioProvider(agi::make_unique<TestAudioProvider<>>(), "");
 	EXPECT_EQ(1, provider->GetChannels());
 	EXPECT_EQ(90 * 48000, provider->GetNumSamples());
 	EXPECT_EQ(48000, provider->GetSampleRate());
@@ -218,7 +219,7 @@ TEST(lagi_audio, ram_cache) {
 }
 
 TEST(lagi_audio, hd_cache) {
-	auto provider = agi::CreateHDAudioProvider(agi::make_unique<TestAudioProvider<>>(), agi::Path().Decode("?temp"));
+	auto provider = agi::CreateHDAudioProvider(agi::make_unique<TestAudioProvider<>>(), agi::Path().Decode("?temp"), "");
 	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
 
 	uint16_t buff[512];
@@ -228,6 +229,120 @@ TEST(lagi_audio, hd_cache) {
 		ASSERT_EQ(static_cast<uint16_t>((1 << 22) - 256 + i), buff[i]);
 }
 
+TEST(lagi_audio, peaks_match_samples) {
+	std::vector<int16_t> samples(100000);
+	for (size_t i = 0; i < samples.size(); ++i)
+		samples[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+
+	agi::AudioPeaks peaks(samples.size());
+	// Feed in uneven chunks to exercise the partial block handling
+	for (size_t i = 0; i < samples.size(); i += 1000)
+		peaks.Append(&samples[i], std::min<size_t>(1000, samples.size() - i));
+	ASSERT_EQ((int64_t)samples.size(), peaks.GetAvailableSamples());
+
+	for (int level = 0; level < agi::AudioPeaks::level_count; ++level) {
+		const auto block = agi::AudioPeaks::BlockSize(level);
+		for (int64_t start = 0; start < (int64_t)samples.size(); start += block) {
+			agi::AudioPeaks::Range range;
+			ASSERT_TRUE(peaks.Get(level, start, start + block, range));
+
+			int min = 0, max = 0;
+			int64_t neg = 0, pos = 0;
+			auto end = std::min<int64_t>(start + block, samples.size());
+			for (auto i = start; i < end; ++i) {
+				if (samples[i] > 0) {
+					max = std::max<int>(max, samples[i]);
+					pos += samples[i];
+				}
+				else {
+					min = std::min<int>(min, samples[i]);
+					neg += samples[i];
+				}
+			}
+
+			ASSERT_EQ(min, range.min);
+			ASSERT_EQ(max, range.max);
+			ASSERT_EQ(neg, range.neg_sum);
+			ASSERT_EQ(pos, range.pos_sum);
+			ASSERT_EQ(end - start, range.samples);
+		}
+	}
+}
+
+TEST(lagi_audio, peaks_only_report_completed_blocks) {
+	std::vector<int16_t> samples(1000, 5);
+	agi::AudioPeaks peaks(5000);
+	agi::AudioPeaks::Range range;
+
+	peaks.Append(&samples[0], 300);
+	EXPECT_EQ(256, peaks.GetAvailableSamples());
+	EXPECT_TRUE(peaks.Get(0, 0, 256, range));
+	EXPECT_EQ(5 * 256, range.pos_sum);
+	EXPECT_FALSE(peaks.Get(0, 256, 512, range));
+	EXPECT_FALSE(peaks.Get(1, 0, 4096, range));
+}
+
+TEST(lagi_audio, peaks_level_selection) {
+	EXPECT_EQ(-1, agi::AudioPeaks::LevelFor(100));
+	EXPECT_EQ(0, agi::AudioPeaks::LevelFor(256));
+	EXPECT_EQ(0, agi::AudioPeaks::LevelFor(4095));
+	EXPECT_EQ(1, agi::AudioPeaks::LevelFor(4096));
+	EXPECT_EQ(2, agi::AudioPeaks::LevelFor(1e7));
+}
+
+TEST(lagi_audio, ram_cache_builds_peaks) {
+	auto provider = agi::CreateRAMAudioProvider(agi::make_unique<TestAudioProvider<>>(), "");
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+
+	auto peaks = provider->GetPeaks();
+	ASSERT_NE(nullptr, peaks);
+	EXPECT_EQ(provider->GetNumSamples(), peaks->GetAvailableSamples());
+
+	// Samples are the low 16 bits of their index, so the block starting at
+	// 32768 is entirely negative and ascends from -32768
+	agi::AudioPeaks::Range range;
+	ASSERT_TRUE(peaks->Get(0, 32768, 32768 + 256, range));
+	EXPECT_EQ(-32768, range.min);
+	EXPECT_EQ(0, range.max);
+}
+
+TEST(lagi_audio, peak_cache_round_trip) {
+	agi::fs::path cache_file = "data/peak_cache";
+	if (agi::fs::FileExists(cache_file)) agi::fs::Remove(cache_file);
+
+	agi::AudioPeaks::Range expected;
+	{
+		auto provider = agi::CreateRAMAudioProvider(agi::make_unique<TestAudioProvider<>>(), cache_file);
+		while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+		ASSERT_TRUE(provider->GetPeaks()->Get(1, 40960, 81920, expected));
+	}
+	ASSERT_TRUE(agi::fs::FileExists(cache_file));
+
+	auto peaks = agi::AudioPeaks::Load(cache_file, 90 * 48000);
+	ASSERT_NE(nullptr, peaks.get());
+	EXPECT_EQ(90 * 48000, peaks->GetAvailableSamples());
+
+	agi::AudioPeaks::Range actual;
+	ASSERT_TRUE(peaks->Get(1, 40960, 81920, actual));
+	EXPECT_EQ(expected.min, actual.min);
+	EXPECT_EQ(expected.max, actual.max);
+	EXPECT_EQ(expected.neg_sum, actual.neg_sum);
+	EXPECT_EQ(expected.pos_sum, actual.pos_sum);
+
+	// A cache for audio of a different length must not be used
+	EXPECT_EQ(nullptr, agi::AudioPeaks::Load(cache_file, 90 * 48000 + 1).get());
+}
+
+TEST(lagi_audio, peak_cache_rejects_garbage) {
+	agi::fs::path cache_file = "data/peak_cache_garbage";
+	{
+		bfs::ofstream out(cache_file);
+		out << "this is not a peak file, but it is long enough to have a header";
+	}
+	EXPECT_EQ(nullptr, agi::AudioPeaks::Load(cache_file, 1000).get());
+	EXPECT_EQ(nullptr, agi::AudioPeaks::Load("data/nonexistent_peak_cache", 1000).get());
+}
+
 TEST(lagi_audio, convert_8bit) {
 	auto provider = agi::CreateConvertAudioProvider(agi::make_unique<TestAudioProvider<uint8_t>>());
 
@@ -0,0 +1,243 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+#include <util.h>
+
+#include <libaegisub/audio/fft.h>
+#include <libaegisub/audio/provider.h>
+#include <libaegisub/audio/spectrum.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef WITH_FFTW3
+#include <fftw3.h>
+#endif
+
+namespace {
+const double pi = 3.1415926535897932384626433832795;
+
+/// Mono 16-bit sine wave at a whole number of Hz
+struct SineAudioProvider : agi::AudioProvider {
+	/// One second of the wave, which then repeats
+	std::vector<int16_t> period;
+
+	SineAudioProvider(int frequency, int64_t duration = 10) {
+		channels = 1;
+		sample_rate = 48000;
+		num_samples = duration * sample_rate;
+		decoded_samples = num_samples;
+		bytes_per_sample = 2;
+		float_samples = false;
+
+		period.resize(sample_rate);
+		for (int i = 0; i < sample_rate; ++i)
+			period[i] = (int16_t)(16000 * sin(2 * pi * frequency * i / sample_rate));
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<int16_t *>(buf);
+		for (int64_t end = start + count; start < end; ++start)
+			*out++ = period[start % sample_rate];
+	}
+};
+
+/// Calculate count blocks spaced 256 samples apart, split over the given
+/// number of threads which each have their own calculator
+void calculate_blocks(SineAudioProvider const& provider, size_t derivation_size, size_t count, size_t threads, std::vector<float>& out) {
+	agi::AudioSpectrumCalculator probe(derivation_size);
+	const size_t block_size = probe.GetBlockSize();
+	out.resize(count * block_size);
+
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			agi::AudioSpectrumCalculator calc(derivation_size);
+			for (size_t i = t; i < count; i += threads)
+				calc.Calculate(provider, i * 256, &out[i * block_size]);
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+}
+
+std::vector<float> random_samples(size_t count) {
+	return ::util::random_floats(count, count);
+}
+
+/// Time the given function, returning the average nanoseconds per call
+template<typename Func>
+double time_per_call(size_t iterations, Func&& func) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		func();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+}
+
+TEST(lagi_audio_spectrum, sine_peaks_at_its_band) {
+	// 512 sample derivations at 48 kHz have bands 93.75 Hz wide
+	SineAudioProvider provider(3000);
+	agi::AudioSpectrumCalculator calc(8);
+	ASSERT_EQ(256u, calc.GetBlockSize());
+
+	std::vector<float> block(calc.GetBlockSize());
+	calc.Calculate(provider, 48000, &block[0]);
+	EXPECT_EQ(32, std::max_element(block.begin(), block.end()) - block.begin());
+}
+
+TEST(lagi_audio_spectrum, silence_before_start) {
+	SineAudioProvider provider(3000);
+	agi::AudioSpectrumCalculator calc(8);
+
+	std::vector<float> block(calc.GetBlockSize(), 1.f);
+	calc.Calculate(provider, -10000, &block[0]);
+	for (float value : block)
+		ASSERT_FLOAT_EQ(0.f, value);
+}
+
+TEST(lagi_audio_spectrum, concurrent_calculators_match_serial) {
+	SineAudioProvider provider(1234);
+	std::vector<float> serial, parallel;
+	calculate_blocks(provider, 9, 256, 1, serial);
+	calculate_blocks(provider, 9, 256, 4, parallel);
+	ASSERT_EQ(serial, parallel);
+}
+
+// Blocks per second with one calculator per thread; opt in with
+// --gtest_also_run_disabled_tests
+TEST(lagi_audio_spectrum, DISABLED_throughput) {
+	SineAudioProvider provider(440, 60);
+	const size_t count = 2048;
+
+	std::vector<size_t> thread_counts{1, 2, 4};
+	size_t hardware = std::thread::hardware_concurrency();
+	if (hardware > 4)
+		thread_counts.push_back(hardware);
+
+	std::vector<float> out;
+	for (size_t threads : thread_counts) {
+		auto start = std::chrono::steady_clock::now();
+		calculate_blocks(provider, 10, count, threads, out);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "[          ] " << threads << " thread(s): "
+			<< (size_t)(count / elapsed.count()) << " blocks/s" << std::endl;
+	}
+}
+
+TEST(lagi_audio_spectrum, real_fft_matches_dft) {
+	for (size_t size = 2; size <= 2048; size *= 2) {
+		auto input = random_samples(size);
+
+		// Reference DFT calculated in double precision
+		std::vector<double> expected_r(size / 2), expected_i(size / 2);
+		for (size_t k = 0; k < size / 2; ++k) {
+			for (size_t n = 0; n < size; ++n) {
+				double angle = 2 * pi * (double)(k * n % size) / size;
+				expected_r[k] += input[n] * cos(angle);
+				expected_i[k] -= input[n] * sin(angle);
+			}
+		}
+
+		for (auto isa : ::util::supported_instruction_sets()) {
+			agi::RealFFT fft(size, isa);
+			ASSERT_EQ(isa, fft.GetInstructionSet());
+			std::vector<float> actual_r(size / 2), actual_i(size / 2);
+			fft.Transform(&input[0], &actual_r[0], &actual_i[0]);
+
+			const double tolerance = 1e-6 * size;
+			for (size_t i = 0; i < size / 2; ++i) {
+				ASSERT_NEAR(expected_r[i], actual_r[i], tolerance) << ::util::instruction_set_name(isa) << " size " << size << " bin " << i;
+				ASSERT_NEAR(expected_i[i], actual_i[i], tolerance) << ::util::instruction_set_name(isa) << " size " << size << " bin " << i;
+			}
+		}
+	}
+}
+
+TEST(lagi_audio_spectrum, real_fft_rejects_bad_sizes) {
+	EXPECT_THROW(agi::RealFFT(0), agi::InternalError);
+	EXPECT_THROW(agi::RealFFT(1), agi::InternalError);
+	EXPECT_THROW(agi::RealFFT(768), agi::InternalError);
+}
+
+TEST(lagi_audio_spectrum, power_matches_log10) {
+	const size_t size = 1024;
+	auto real = random_samples(size / 2);
+	auto imag = random_samples(size);
+	for (auto& value : real) value *= 100;
+
+	for (auto isa : ::util::supported_instruction_sets()) {
+		agi::RealFFT fft(size, isa);
+		std::vector<float> power(size / 2);
+		fft.Power(&real[0], &imag[0], 0.25f, &power[0]);
+		for (size_t i = 0; i < size / 2; ++i) {
+			float expected = log10(sqrt(real[i] * real[i] + imag[i] * imag[i]) * 0.25f + 1);
+			ASSERT_NEAR(expected, power[i], 1e-6f) << ::util::instruction_set_name(isa) << " bin " << i;
+		}
+	}
+}
+
+// Compares the previous complex FFT path, RealFFT and (if available) FFTW
+TEST(lagi_audio_spectrum, DISABLED_transform_benchmark) {
+	const size_t iterations = 500;
+
+	for (size_t derivation_size : {8, 9, 10, 11}) {
+		const size_t size = 2 << derivation_size;
+		const float scale = 9 / sqrt(2 * (float)size);
+		auto input = random_samples(size);
+		std::vector<float> re(size), im(size), power(size / 2);
+
+		// The previous path: a complex transform with twiddles recomputed for
+		// each block, followed by a scalar magnitude and log10 pass
+		double ns = time_per_call(iterations, [&] {
+			agi::FFT().Transform(size, &input[0], &re[0], &im[0]);
+			for (size_t i = 0; i < size / 2; ++i)
+				power[i] = log10(sqrt(re[i] * re[i] + im[i] * im[i]) * scale + 1);
+		});
+		std::cout << "[          ] " << size << " samples, complex FFT: " << (size_t)ns << " ns/block" << std::endl;
+
+		for (auto isa : ::util::supported_instruction_sets()) {
+			agi::RealFFT fft(size, isa);
+			ns = time_per_call(iterations, [&] {
+				fft.Transform(&input[0], &re[0], &im[0]);
+				fft.Power(&re[0], &im[0], scale, &power[0]);
+			});
+			std::cout << "[          ] " << size << " samples, real FFT (" << ::util::instruction_set_name(isa) << "): " << (size_t)ns << " ns/block" << std::endl;
+		}
+
+#ifdef WITH_FFTW3
+		double *dft_input = fftw_alloc_real(size);
+		fftw_complex *dft_output = fftw_alloc_complex(size);
+		fftw_plan plan = fftw_plan_dft_r2c_1d(size, dft_input, dft_output, FFTW_MEASURE);
+		std::copy(input.begin(), input.end(), dft_input);
+		ns = time_per_call(iterations, [&] {
+			fftw_execute(plan);
+			for (size_t i = 0; i < size / 2; ++i)
+				power[i] = log10(sqrt(dft_output[i][0] * dft_output[i][0] + dft_output[i][1] * dft_output[i][1]) * scale + 1);
+		});
+		std::cout << "[          ] " << size << " samples, FFTW: " << (size_t)ns << " ns/block" << std::endl;
+		fftw_destroy_plan(plan);
+		fftw_free(dft_input);
+		fftw_free(dft_output);
+#endif
+	}
+}
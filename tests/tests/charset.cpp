@@ -0,0 +1,224 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+#include <util.h>
+
+#include <libaegisub/charset.h>
+#include <libaegisub/fs.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace agi;
+using namespace agi::charset;
+using ::util::supported_instruction_sets;
+
+namespace {
+/// Something resembling a subtitle file, with some non-ASCII text
+std::string subtitle_text(size_t size) {
+	std::string ret;
+	ret.reserve(size + 100);
+	for (int i = 0; ret.size() < size; ++i) {
+		ret += "Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,{\\i1}line ";
+		ret += std::to_string(i);
+		ret += i % 4 ? " text\r\n" : " t\xc3\xa9xt \xe6\x97\xa5\xe6\x9c\xac\r\n";
+	}
+	return ret;
+}
+
+void write_file(std::string const& filename, std::string const& data) {
+	std::ofstream file(filename, std::ios::binary);
+	file << data;
+}
+
+/// The control byte counting which was done before it was vectorized
+size_t count_control_old(std::string const& data) {
+	size_t binaryish = 0;
+	for (size_t i = 0; i < data.size(); ++i) {
+		if ((unsigned char)data[i] < 32 && (data[i] != '\r' && data[i] != '\n' && data[i] != '\t'))
+			++binaryish;
+	}
+	return binaryish;
+}
+}
+
+TEST(lagi_charset, valid_utf8) {
+	for (auto isa : supported_instruction_sets()) {
+		std::string str = "plain ascii";
+		EXPECT_EQ(str.size(), ValidUtf8Prefix(str.data(), str.size(), isa));
+		str = "\xc3\xa9 \xe6\x97\xa5 \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf \xed\x9f\xbf";
+		EXPECT_EQ(str.size(), ValidUtf8Prefix(str.data(), str.size(), isa));
+		EXPECT_EQ(0u, ValidUtf8Prefix(str.data(), 0, isa));
+	}
+}
+
+TEST(lagi_charset, invalid_utf8) {
+	const char *invalid[] = {
+		"\x80",             // Lone continuation byte
+		"\xc0\xaf",         // Overlong slash
+		"\xe0\x80\xaf",     // Overlong slash
+		"\xed\xa0\x80",     // Surrogate
+		"\xf4\x90\x80\x80", // Past U+10FFFF
+		"\xf5\x80\x80\x80", // Past U+10FFFF
+		"\xc3\x28",         // Missing continuation byte
+		"\xff",
+	};
+	for (auto isa : supported_instruction_sets()) {
+		for (auto str : invalid) {
+			// Put the invalid bytes after enough ASCII to cover a vector
+			std::string buf = std::string(40, 'a') + str + "bbb";
+			EXPECT_EQ(40u, ValidUtf8Prefix(buf.data(), buf.size(), isa)) << ::util::instruction_set_name(isa) << " " << str;
+		}
+	}
+}
+
+TEST(lagi_charset, truncated_utf8) {
+	std::string str = "abc\xe6\x97\xa5";
+	for (auto isa : supported_instruction_sets()) {
+		for (size_t len = 4; len < str.size(); ++len)
+			EXPECT_EQ(3u, ValidUtf8Prefix(str.data(), len, isa));
+	}
+}
+
+TEST(lagi_charset, instruction_sets_agree) {
+	std::mt19937 rng(5);
+	std::uniform_int_distribution<int> pos(0, 999);
+	std::uniform_int_distribution<int> byte(0, 255);
+	auto text = subtitle_text(1000);
+
+	for (int i = 0; i < 200; ++i) {
+		// Corrupt a few bytes of the text at random
+		auto buf = text;
+		for (int j = 0; j < i % 4; ++j)
+			buf[pos(rng)] = (char)byte(rng);
+
+		for (size_t len : {(size_t)15, (size_t)33, (size_t)500, buf.size()}) {
+			auto valid = ValidUtf8Prefix(buf.data(), len, InstructionSet::Scalar);
+			auto control = CountControlBytes(buf.data(), len, InstructionSet::Scalar);
+			ASSERT_EQ(count_control_old(buf.substr(0, len)), control);
+			for (auto isa : supported_instruction_sets()) {
+				ASSERT_EQ(valid, ValidUtf8Prefix(buf.data(), len, isa)) << ::util::instruction_set_name(isa) << " " << i;
+				ASSERT_EQ(control, CountControlBytes(buf.data(), len, isa)) << ::util::instruction_set_name(isa) << " " << i;
+			}
+		}
+	}
+}
+
+TEST(lagi_charset, count_control_bytes) {
+	std::string str(10000, '\0');
+	for (size_t i = 0; i < str.size(); ++i)
+		str[i] = "a\t\n\r\x01\x1f \x80"[i % 8];
+	for (auto isa : supported_instruction_sets())
+		EXPECT_EQ(2500u, CountControlBytes(str.data(), str.size(), isa));
+}
+
+TEST(lagi_charset, detect) {
+	write_file("data/charset_utf8.txt", subtitle_text(200000));
+	EXPECT_EQ("utf-8", Detect("data/charset_utf8.txt"));
+
+	write_file("data/charset_bom.txt", "\xef\xbb\xbf" "abc");
+	EXPECT_EQ("utf-8", Detect("data/charset_bom.txt"));
+
+	write_file("data/charset_utf16.txt", std::string("\xff\xfe" "a\0b\0", 6));
+	EXPECT_EQ("utf-16le", Detect("data/charset_utf16.txt"));
+
+	std::string binary(200000, '\0');
+	for (size_t i = 0; i < binary.size(); ++i)
+		binary[i] = (char)(i * 7 % 64);
+	write_file("data/charset_binary.bin", binary);
+	EXPECT_EQ("binary", Detect("data/charset_binary.bin"));
+
+	// Valid UTF-8 which is mostly control characters is still binary
+	write_file("data/charset_zeros.bin", std::string(100000, '\0'));
+	EXPECT_EQ("binary", Detect("data/charset_zeros.bin"));
+
+	// A multibyte character split across the blocks the file is read in
+	auto split = std::string(64 * 1024 - 1, 'a') + "\xe6\x97\xa5" + std::string(100, 'b');
+	write_file("data/charset_split.txt", split);
+	EXPECT_EQ("utf-8", Detect("data/charset_split.txt"));
+
+	for (auto file : {"charset_utf8.txt", "charset_bom.txt", "charset_utf16.txt", "charset_binary.bin", "charset_zeros.bin", "charset_split.txt"})
+		fs::Remove(std::string("data/") + file);
+}
+
+TEST(lagi_charset, detect_legacy) {
+	// Mostly ASCII with a single Latin-1 character well away from the evenly
+	// spaced windows given to uchardet
+	std::string text;
+	while (text.size() < 2 * 1024 * 1024)
+		text += "Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,plain text\r\n";
+	text.insert(1000003, "caf\xe9 ");
+	write_file("data/charset_legacy.txt", text);
+	auto charset = Detect("data/charset_legacy.txt");
+	EXPECT_NE("ascii", charset);
+	EXPECT_NE("binary", charset);
+#ifdef WITH_UCHARDET
+	EXPECT_NE("utf-8", charset);
+#endif
+
+	// Control bytes just under the binary threshold in the block with the
+	// invalid byte, which must only be counted once
+	std::string control(60000, 'a');
+	for (size_t i = 0; i < control.size(); i += 10)
+		control[i] = '\x01';
+	control[30001] = '\xe9';
+	write_file("data/charset_control.txt", control);
+	EXPECT_NE("binary", Detect("data/charset_control.txt"));
+
+	// Binary data after the invalid byte is still caught
+	std::string binary = std::string(100, 'a') + "\xe9" + std::string(100000, '\0');
+	write_file("data/charset_binary_tail.bin", binary);
+	EXPECT_EQ("binary", Detect("data/charset_binary_tail.bin"));
+
+	for (auto file : {"charset_legacy.txt", "charset_control.txt", "charset_binary_tail.bin"})
+		fs::Remove(std::string("data/") + file);
+}
+
+// Not run by default; use --gtest_also_run_disabled_tests --gtest_filter=lagi_charset.DISABLED_benchmark
+TEST(lagi_charset, DISABLED_benchmark) {
+	auto text = subtitle_text(50 * 1024 * 1024);
+
+	auto report = [&](std::string const& name, std::chrono::steady_clock::time_point start) {
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "[          ] 50 MB, " << name << ": " << (size_t)(text.size() / elapsed.count() / (1024 * 1024)) << " MB/s" << std::endl;
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	size_t old_count = count_control_old(text);
+	report("old control byte count", start);
+
+	for (auto isa : supported_instruction_sets()) {
+		std::string name = ::util::instruction_set_name(isa);
+		start = std::chrono::steady_clock::now();
+		ASSERT_EQ(old_count, CountControlBytes(text.data(), text.size(), isa));
+		report(name + " control byte count", start);
+
+		start = std::chrono::steady_clock::now();
+		ASSERT_EQ(text.size(), ValidUtf8Prefix(text.data(), text.size(), isa));
+		report(name + " UTF-8 validation", start);
+	}
+
+	write_file("data/charset_large.txt", text);
+	start = std::chrono::steady_clock::now();
+	EXPECT_EQ("utf-8", Detect("data/charset_large.txt"));
+	report("Detect", start);
+	fs::Remove("data/charset_large.txt");
+}
@@ -87,6 +87,18 @@ TEST(lagi_fs, touch_does_not_modify_contents) {
 	EXPECT_EQ(expected_value, util::read_written_rand("data/tmp"));
 }
 
+TEST(lagi_fs, append) {
+	ASSERT_NO_THROW(Remove("data/append_tmp"));
+	ASSERT_NO_THROW(Append("data/append_tmp", "12345"));
+	ASSERT_NO_THROW(Append("data/append_tmp", "67890"));
+	EXPECT_EQ(10u, Size("data/append_tmp"));
+	Remove("data/append_tmp");
+}
+
+TEST(lagi_fs, append_to_nonexistent_dir) {
+	EXPECT_THROW(Append("data/nonexistent/tmp", "12345"), FileNotFound);
+}
+
 TEST(lagi_fs, rename) {
 	ASSERT_NO_THROW(Touch("data/rename_in"));
 	ASSERT_NO_THROW(Remove("data/rename_out"));
@@ -0,0 +1,168 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/interval_index.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+typedef agi::interval_index<int> index_t;
+
+std::vector<int> overlapping(index_t& index, int start, int end) {
+	std::vector<int> ret;
+	index.for_each_overlapping(start, end, [&](index_t::interval const& i) {
+		ret.push_back(i.value);
+	});
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+typedef std::vector<std::pair<int, int>> pair_list;
+
+pair_list overlapping_pairs(index_t const& index) {
+	pair_list ret;
+	index.for_each_overlapping_pair([&](index_t::interval const& a, index_t::interval const& b) {
+		EXPECT_LE(a.start, b.start);
+		ret.emplace_back(std::min(a.value, b.value), std::max(a.value, b.value));
+	});
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+pair_list brute_force_pairs(std::vector<index_t::interval> const& items) {
+	pair_list ret;
+	for (size_t i = 0; i < items.size(); ++i) {
+		for (size_t j = i + 1; j < items.size(); ++j) {
+			auto const& a = items[i];
+			auto const& b = items[j];
+			if (a.start < b.end && b.start < a.end)
+				ret.emplace_back(std::min(a.value, b.value), std::max(a.value, b.value));
+		}
+	}
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+std::vector<int> brute_force(std::vector<index_t::interval> const& items, int start, int end) {
+	std::vector<int> ret;
+	for (auto const& i : items) {
+		if (i.start <= end && i.end > start)
+			ret.push_back(i.value);
+	}
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+}
+
+TEST(lagi_interval_index, empty) {
+	index_t index;
+	EXPECT_TRUE(overlapping(index, 0, 100).empty());
+}
+
+TEST(lagi_interval_index, point_queries_are_half_open) {
+	index_t index;
+	index.insert(0, 1000, 1);
+	index.insert(1000, 2000, 2);
+
+	EXPECT_EQ(std::vector<int>{1}, overlapping(index, 0, 0));
+	EXPECT_EQ(std::vector<int>{1}, overlapping(index, 999, 999));
+	EXPECT_EQ(std::vector<int>{2}, overlapping(index, 1000, 1000));
+	EXPECT_TRUE(overlapping(index, 2000, 2000).empty());
+	EXPECT_TRUE(overlapping(index, -1, -1).empty());
+}
+
+TEST(lagi_interval_index, visits_in_start_order) {
+	index_t index;
+	index.assign({{500, 3000, 3}, {0, 5000, 1}, {100, 200, 2}, {400, 2000, 4}});
+
+	std::vector<int> starts;
+	index.for_each_overlapping(450, 1000, [&](index_t::interval const& i) { starts.push_back(i.start); });
+	EXPECT_EQ((std::vector<int>{0, 400, 500}), starts);
+}
+
+TEST(lagi_interval_index, erase_if) {
+	index_t index;
+	index.assign({{0, 100, 1}, {50, 150, 2}, {100, 200, 3}});
+	index.erase_if([](index_t::interval const& i) { return i.value == 2; });
+	EXPECT_EQ(2u, index.size());
+	EXPECT_EQ((std::vector<int>{1, 3}), overlapping(index, 99, 100));
+}
+
+TEST(lagi_interval_index, matches_brute_force) {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> start_dist(0, 100000);
+	std::uniform_int_distribution<int> length_dist(0, 5000);
+
+	std::vector<index_t::interval> items;
+	for (int i = 0; i < 2000; ++i) {
+		int start = start_dist(rng);
+		items.push_back({start, start + length_dist(rng), i});
+	}
+
+	index_t index;
+	index.assign(items);
+
+	for (int i = 0; i < 500; ++i) {
+		int start = start_dist(rng);
+		int end = start + length_dist(rng) / 10;
+		ASSERT_EQ(brute_force(items, start, end), overlapping(index, start, end));
+	}
+
+	// Mix of incremental changes
+	for (int i = 0; i < 200; ++i) {
+		int victim = items[rng() % items.size()].value;
+		index.erase_if([=](index_t::interval const& it) { return it.value == victim; });
+		items.erase(std::remove_if(items.begin(), items.end(), [=](index_t::interval const& it) { return it.value == victim; }), items.end());
+
+		int start = start_dist(rng);
+		index_t::interval added{start, start + length_dist(rng), 10000 + i};
+		index.insert(added.start, added.end, added.value);
+		items.push_back(added);
+
+		int t = start_dist(rng);
+		ASSERT_EQ(brute_force(items, t, t), overlapping(index, t, t));
+	}
+}
+
+TEST(lagi_interval_index, overlapping_pairs) {
+	index_t index;
+	index.assign({{0, 1000, 1}, {1000, 2000, 2}, {500, 1500, 3}, {500, 500, 4}, {1500, 3000, 5}, {0, 1000, 6}});
+
+	// Touching intervals don't overlap, and the empty interval 4 overlaps the
+	// ones which started before it but not 3, which starts at the same time
+	EXPECT_EQ((pair_list{{1, 3}, {1, 4}, {1, 6}, {2, 3}, {2, 5}, {3, 6}, {4, 6}}), overlapping_pairs(index));
+}
+
+TEST(lagi_interval_index, overlapping_pairs_match_brute_force) {
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> start_dist(0, 100000);
+	std::uniform_int_distribution<int> length_dist(0, 3000);
+
+	std::vector<index_t::interval> items;
+	for (int i = 0; i < 2000; ++i) {
+		// Round the times so that there are plenty of shared starts and ends
+		int start = start_dist(rng) / 100 * 100;
+		items.push_back({start, start + length_dist(rng) / 100 * 100, i});
+	}
+
+	index_t index;
+	index.assign(items);
+	ASSERT_EQ(brute_force_pairs(items), overlapping_pairs(index));
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/journal.h>
+#include <libaegisub/fs.h>
+#include <libaegisub/io.h>
+
+#include <sstream>
+
+using namespace agi::ass;
+
+namespace {
+const char line_a[] = "Dialogue: 0,0:00:00.00,0:00:05.00,Default,,0,0,0,,a";
+const char line_b[] = "Dialogue: 0,0:00:05.00,0:00:10.00,Default,,0,0,0,,b, with a comma";
+
+bool read(std::string const& journal, std::vector<int>& ids, std::vector<JournalCommit>& commits) {
+	std::stringstream stream(journal);
+	return ReadJournal(stream, ids, commits);
+}
+}
+
+TEST(lagi_journal, round_trip) {
+	std::string journal = JournalHeader({3, 1, 2});
+	JournalAddLine(journal, 4, 1, line_a);
+	JournalRemoveLine(journal, 2);
+	JournalEndCommit(journal);
+	JournalAddLine(journal, 3, 0, line_b);
+	JournalEndCommit(journal);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(journal, ids, commits));
+	EXPECT_EQ((std::vector<int>{3, 1, 2}), ids);
+	ASSERT_EQ(2u, commits.size());
+
+	ASSERT_EQ(2u, commits[0].size());
+	EXPECT_EQ(JournalRecord::Type::Line, commits[0][0].type);
+	EXPECT_EQ(4, commits[0][0].id);
+	EXPECT_EQ(1, commits[0][0].after);
+	EXPECT_EQ(line_a, commits[0][0].data);
+	EXPECT_EQ(JournalRecord::Type::Remove, commits[0][1].type);
+	EXPECT_EQ(2, commits[0][1].id);
+
+	ASSERT_EQ(1u, commits[1].size());
+	EXPECT_EQ(0, commits[1][0].after);
+	EXPECT_EQ(line_b, commits[1][0].data);
+}
+
+TEST(lagi_journal, sections) {
+	std::string journal = JournalHeader({1});
+	JournalSection(journal, "styles", {"[V4+ Styles]", "Style: Default,Arial,20"});
+	JournalSection(journal, "info", {});
+	JournalRemoveLine(journal, 1);
+	JournalEndCommit(journal);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(journal, ids, commits));
+	ASSERT_EQ(1u, commits.size());
+	auto const& commit = commits[0];
+	ASSERT_EQ(5u, commit.size());
+	EXPECT_EQ(JournalRecord::Type::Section, commit[0].type);
+	EXPECT_EQ("styles", commit[0].data);
+	EXPECT_EQ(JournalRecord::Type::SectionLine, commit[1].type);
+	EXPECT_EQ("[V4+ Styles]", commit[1].data);
+	EXPECT_EQ("Style: Default,Arial,20", commit[2].data);
+	EXPECT_EQ(JournalRecord::Type::Section, commit[3].type);
+	EXPECT_EQ("info", commit[3].data);
+	EXPECT_EQ(JournalRecord::Type::Remove, commit[4].type);
+
+	std::unordered_set<int> live{1};
+	EXPECT_TRUE(CheckJournalCommit(live, commit));
+	EXPECT_TRUE(live.empty());
+}
+
+TEST(lagi_journal, section_line_outside_section) {
+	std::string journal = JournalHeader({1});
+	JournalRemoveLine(journal, 1);
+	JournalEndCommit(journal);
+	journal += "R [Script Info]\n";
+	JournalEndCommit(journal);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(journal, ids, commits));
+	EXPECT_EQ(1u, commits.size());
+}
+
+TEST(lagi_journal, empty_snapshot) {
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(JournalHeader({}), ids, commits));
+	EXPECT_TRUE(ids.empty());
+	EXPECT_TRUE(commits.empty());
+}
+
+TEST(lagi_journal, not_a_journal) {
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	EXPECT_FALSE(read("", ids, commits));
+	EXPECT_FALSE(read("[Script Info]\nTitle: a\n", ids, commits));
+	EXPECT_FALSE(read("Aegisub Autosave Journal\n", ids, commits));
+	EXPECT_FALSE(read("Aegisub Autosave Journal\nI 1 2 x\n", ids, commits));
+}
+
+TEST(lagi_journal, incomplete_commit_is_discarded) {
+	std::string journal = JournalHeader({1});
+	JournalAddLine(journal, 1, 0, line_a);
+	JournalEndCommit(journal);
+	JournalAddLine(journal, 1, 0, line_b);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(journal, ids, commits));
+	ASSERT_EQ(1u, commits.size());
+	EXPECT_EQ(line_a, commits[0][0].data);
+}
+
+TEST(lagi_journal, stops_at_malformed_record) {
+	std::string journal = JournalHeader({1});
+	JournalRemoveLine(journal, 1);
+	JournalEndCommit(journal);
+	// A record cut off partway through by a crash, then a later commit
+	journal += "L 2";
+	JournalAddLine(journal, 3, 0, line_a);
+	JournalEndCommit(journal);
+	JournalAddLine(journal, 4, 0, line_b);
+	JournalEndCommit(journal);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(read(journal, ids, commits));
+	ASSERT_EQ(1u, commits.size());
+	EXPECT_EQ(JournalRecord::Type::Remove, commits[0][0].type);
+}
+
+TEST(lagi_journal, check_commit) {
+	std::unordered_set<int> ids{1, 2};
+
+	JournalCommit commit{
+		{JournalRecord::Type::Line, 3, 2, line_a},
+		{JournalRecord::Type::Line, 4, 3, line_b},
+		{JournalRecord::Type::Remove, 1, 0, ""},
+	};
+	ASSERT_TRUE(CheckJournalCommit(ids, commit));
+	EXPECT_EQ((std::unordered_set<int>{2, 3, 4}), ids);
+
+	// Placing a line after one which was removed earlier in the commit fails,
+	// and leaves the ids as they were
+	JournalCommit bad{
+		{JournalRecord::Type::Remove, 2, 0, ""},
+		{JournalRecord::Type::Line, 5, 4, line_a},
+		{JournalRecord::Type::Line, 6, 2, line_a},
+	};
+	EXPECT_FALSE(CheckJournalCommit(ids, bad));
+	EXPECT_EQ((std::unordered_set<int>{2, 3, 4}), ids);
+
+	// A changed line can't be placed after itself
+	JournalCommit self{{JournalRecord::Type::Line, 3, 3, line_a}};
+	EXPECT_FALSE(CheckJournalCommit(ids, self));
+}
+
+TEST(lagi_journal, append_to_file) {
+	agi::fs::Remove("data/journal_tmp");
+	agi::fs::Append("data/journal_tmp", JournalHeader({1, 2}));
+	std::string commit;
+	JournalAddLine(commit, 2, 0, line_a);
+	JournalEndCommit(commit);
+	agi::fs::Append("data/journal_tmp", commit);
+
+	std::vector<int> ids;
+	std::vector<JournalCommit> commits;
+	ASSERT_TRUE(ReadJournal(*agi::io::Open("data/journal_tmp"), ids, commits));
+	EXPECT_EQ(2u, ids.size());
+	ASSERT_EQ(1u, commits.size());
+	EXPECT_EQ(line_a, commits[0][0].data);
+	agi::fs::Remove("data/journal_tmp");
+}
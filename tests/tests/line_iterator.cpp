@@ -44,6 +44,21 @@ void test(std::string const& str, const char *encoding, Values... values) {
 	test_values(iter, values...);
 }
 
+std::vector<std::string> buffer_lines(std::string const& str) {
+	std::vector<std::string> ret;
+	for (auto const& line : agi::buffer_line_iterator(str.data(), str.size()))
+		ret.emplace_back(line.begin(), line.end());
+	return ret;
+}
+
+std::vector<std::string> stream_lines(std::string const& str) {
+	std::stringstream ss(str);
+	std::vector<std::string> ret;
+	for (auto const& line : agi::line_iterator<std::string>(ss))
+		ret.push_back(line);
+	return ret;
+}
+
 template<typename T, typename... Values>
 void expect_eq(const char *str, Values... values) {
 	std::string utf8(str);
@@ -70,3 +85,45 @@ TEST(lagi_line, string) {
 	expect_eq<std::string>(" white space ", " white space ");
 	expect_eq<std::string>("blank\n\nlines\n", "blank", "", "lines", "");
 }
+
+TEST(lagi_line, buffer_matches_stream) {
+	for (auto str : {"", "\n", "a", "a\n", "a\r\n", "line 1\r\nline 2\nline 3", "blank\n\nlines\n", "\r", "a\r\r\n", "\xef\xbb\xbf\xe6\x97\xa5\n"})
+		EXPECT_EQ(stream_lines(str), buffer_lines(str)) << str;
+}
+
+TEST(lagi_line, buffer_does_not_copy) {
+	std::string str = "line 1\nline 2";
+	agi::buffer_line_iterator it(str.data(), str.size()), end;
+	ASSERT_NE(it, end);
+	EXPECT_EQ(str.data(), it->begin());
+	EXPECT_EQ(str.data() + 6, it->end());
+	++it;
+	ASSERT_NE(it, end);
+	EXPECT_EQ(str.data() + 7, it->begin());
+	++it;
+	EXPECT_EQ(it, end);
+}
+
+TEST(lagi_line, utf8_compatible_encodings) {
+	EXPECT_TRUE(agi::is_utf8_compatible("utf-8"));
+	EXPECT_TRUE(agi::is_utf8_compatible("UTF-8"));
+	EXPECT_TRUE(agi::is_utf8_compatible("ASCII"));
+	EXPECT_FALSE(agi::is_utf8_compatible("utf-16"));
+	EXPECT_FALSE(agi::is_utf8_compatible("windows-1252"));
+	EXPECT_FALSE(agi::is_utf8_compatible(""));
+}
+
+TEST(lagi_line, utf8_compatible_matches_buffer) {
+	std::string str;
+	for (int i = 0; i < 1000; ++i)
+		str += "Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,line " + std::to_string(i) + "\r\n";
+
+	auto expected = buffer_lines(str);
+	for (auto encoding : {"utf-8", "ascii"}) {
+		std::stringstream ss(str);
+		std::vector<std::string> lines;
+		for (auto const& line : agi::line_iterator<std::string>(ss, encoding))
+			lines.push_back(line);
+		EXPECT_EQ(expected, lines) << encoding;
+	}
+}
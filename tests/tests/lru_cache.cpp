@@ -0,0 +1,123 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/lru_cache.h>
+
+#include <string>
+#include <vector>
+
+TEST(lagi_lru_cache, get_missing) {
+	agi::lru_cache<int, std::string> cache(100);
+	EXPECT_EQ(nullptr, cache.get(1));
+	EXPECT_EQ(1u, cache.get_stats().misses);
+	EXPECT_EQ(0u, cache.get_stats().hits);
+}
+
+TEST(lagi_lru_cache, put_then_get) {
+	agi::lru_cache<int, std::string> cache(100);
+	cache.put(1, "one", 10);
+	cache.put(2, "two", 10);
+	ASSERT_NE(nullptr, cache.get(1));
+	EXPECT_EQ("one", *cache.get(1));
+	EXPECT_EQ("two", *cache.get(2));
+	EXPECT_EQ(3u, cache.get_stats().hits);
+	EXPECT_EQ(2u, cache.count());
+	EXPECT_EQ(20u, cache.size());
+}
+
+TEST(lagi_lru_cache, evicts_least_recently_used) {
+	agi::lru_cache<int, std::string> cache(30);
+	cache.put(1, "one", 10);
+	cache.put(2, "two", 10);
+	cache.put(3, "three", 10);
+	cache.get(1);
+	cache.put(4, "four", 10);
+
+	EXPECT_EQ(nullptr, cache.get(2));
+	EXPECT_NE(nullptr, cache.get(1));
+	EXPECT_NE(nullptr, cache.get(3));
+	EXPECT_NE(nullptr, cache.get(4));
+	EXPECT_EQ(1u, cache.get_stats().evictions);
+	EXPECT_EQ(30u, cache.size());
+}
+
+TEST(lagi_lru_cache, evicts_until_new_value_fits) {
+	agi::lru_cache<int, std::string> cache(30);
+	cache.put(1, "one", 10);
+	cache.put(2, "two", 10);
+	cache.put(3, "three", 10);
+	cache.put(4, "four", 25);
+
+	EXPECT_EQ(1u, cache.count());
+	EXPECT_EQ(25u, cache.size());
+	EXPECT_EQ(3u, cache.get_stats().evictions);
+	EXPECT_EQ(30u, cache.get_stats().peak_size);
+}
+
+TEST(lagi_lru_cache, keeps_oversized_value) {
+	agi::lru_cache<int, std::string> cache(10);
+	cache.put(1, "one", 5);
+	cache.put(2, "two", 50);
+	EXPECT_EQ(nullptr, cache.get(1));
+	ASSERT_NE(nullptr, cache.get(2));
+	EXPECT_EQ(50u, cache.size());
+
+	agi::lru_cache<int, std::string> empty(0);
+	empty.put(1, "one", 5);
+	EXPECT_NE(nullptr, empty.get(1));
+}
+
+TEST(lagi_lru_cache, replace_existing_key) {
+	agi::lru_cache<int, std::string> cache(30);
+	cache.put(1, "one", 10);
+	cache.put(2, "two", 10);
+	cache.put(1, "uno", 15);
+
+	EXPECT_EQ(2u, cache.count());
+	EXPECT_EQ(25u, cache.size());
+	EXPECT_EQ(0u, cache.get_stats().evictions);
+	EXPECT_EQ("uno", *cache.get(1));
+}
+
+TEST(lagi_lru_cache, recycles_evicted_storage) {
+	agi::lru_cache<int, std::vector<char>> cache(2048);
+	std::vector<char> frame(1024, 'a');
+	cache.put(1, frame, frame.size());
+	cache.put(2, frame, frame.size());
+	const char *first = cache.get(1)->data();
+	cache.get(2);
+
+	// Frame 1 is now least recently used, so frame 3 should reuse its buffer
+	frame.assign(1024, 'b');
+	cache.put(3, frame, frame.size());
+	EXPECT_EQ(nullptr, cache.get(1));
+	ASSERT_NE(nullptr, cache.get(3));
+	EXPECT_EQ(first, cache.get(3)->data());
+	EXPECT_EQ('b', cache.get(3)->front());
+}
+
+TEST(lagi_lru_cache, clear) {
+	agi::lru_cache<int, std::string> cache(30);
+	cache.put(1, "one", 10);
+	cache.get(1);
+	cache.clear();
+	EXPECT_EQ(0u, cache.count());
+	EXPECT_EQ(0u, cache.size());
+	EXPECT_EQ(nullptr, cache.get(1));
+	EXPECT_EQ(1u, cache.get_stats().hits);
+}
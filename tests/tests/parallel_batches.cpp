@@ -0,0 +1,261 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/time.h>
+#include <libaegisub/exception.h>
+#include <libaegisub/line_iterator.h>
+#include <libaegisub/make_unique.h>
+#include <libaegisub/parallel_batches.h>
+#include <libaegisub/split.h>
+
+#include <atomic>
+#include <boost/algorithm/string/predicate.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+DEFINE_EXCEPTION(ParseError, agi::InvalidInputException);
+
+/// The times of a dialogue line
+struct event {
+	bool comment;
+	agi::Time start, end;
+};
+
+/// Parse the times of a line with the same helpers AssDialogue::Parse uses
+event parse_event(std::string& line) {
+	event e;
+	e.comment = boost::starts_with(line, "Comment:");
+	auto str = boost::make_iterator_range(line.data() + line.find(':') + 1, line.data() + line.size());
+	auto pos = agi::Split(str, ',');
+	auto next = [&] {
+		if (pos.eof())
+			throw ParseError("Failed parsing line: " + line);
+		return agi::Trim(*pos++);
+	};
+
+	next();
+	auto start = next();
+	e.start = agi::Time(start.begin(), start.end());
+	auto end = next();
+	e.end = agi::Time(end.begin(), end.end());
+	return e;
+}
+
+std::string synthetic_script(size_t lines) {
+	std::string script =
+		"[Script Info]\n"
+		"ScriptType: v4.00+\n"
+		"\n"
+		"[Events]\n"
+		"Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n";
+	for (size_t i = 0; i < lines; ++i) {
+		script += i % 10 ? "Dialogue: 0," : "Comment: 1,";
+		script += agi::Time(i * 1000).GetAssFormatted();
+		script += ',';
+		script += agi::Time(i * 1000 + 2500).GetAssFormatted();
+		script += ",Default,Actor,0,0,0,,{\\k20}ka{\\k30}ra line ";
+		script += std::to_string(i);
+		script += '\n';
+	}
+	return script;
+}
+
+/// Read a script the same way the ASS loader does, passing each event line
+/// to add_event
+template<typename Func>
+void read_events(std::string const& script, Func&& add_event) {
+	std::stringstream stream(script);
+	bool in_events = false;
+	for (auto const& line : agi::line_iterator<std::string>(stream, "utf-8")) {
+		if (!line.empty() && line[0] == '[')
+			in_events = line == "[Events]";
+		else if (in_events && (boost::starts_with(line, "Dialogue:") || boost::starts_with(line, "Comment:")))
+			add_event(line);
+	}
+}
+
+std::vector<event> load_serial(std::string const& script) {
+	std::vector<event> events;
+	read_events(script, [&](std::string line) { events.push_back(parse_event(line)); });
+	return events;
+}
+
+std::vector<event> load_parallel(std::string const& script) {
+	std::vector<event> events;
+	agi::parallel_batches<std::string, event> batches(parse_event, 2000);
+	read_events(script, [&](std::string const& line) { batches.add(line); });
+	batches.finish([&](event e) { events.push_back(e); });
+	return events;
+}
+}
+
+TEST(lagi_parallel_batches, results_in_order) {
+	agi::parallel_batches<int, int> batches([](int& i) { return i * 2; }, 7);
+	for (int i = 0; i < 1000; ++i)
+		batches.add(i);
+	EXPECT_EQ(142u, batches.outstanding());
+
+	std::vector<int> results;
+	batches.finish([&](int i) { results.push_back(i); });
+	ASSERT_EQ(1000u, results.size());
+	for (int i = 0; i < 1000; ++i)
+		ASSERT_EQ(i * 2, results[i]);
+	EXPECT_EQ(0u, batches.outstanding());
+}
+
+TEST(lagi_parallel_batches, empty) {
+	agi::parallel_batches<int, int> batches([](int& i) { return i; }, 10);
+	size_t count = 0;
+	batches.finish([&](int) { ++count; });
+	EXPECT_EQ(0u, count);
+}
+
+TEST(lagi_parallel_batches, partial_batch_is_finished) {
+	agi::parallel_batches<int, int> batches([](int& i) { return i; }, 10);
+	for (int i = 0; i < 15; ++i)
+		batches.add(i);
+	EXPECT_EQ(1u, batches.outstanding());
+
+	std::vector<int> results;
+	batches.finish([&](int i) { results.push_back(i); });
+	EXPECT_EQ(15u, results.size());
+}
+
+TEST(lagi_parallel_batches, exception_after_earlier_results) {
+	agi::parallel_batches<int, int> batches([](int& i) -> int {
+		if (i == 25) throw std::runtime_error("bad item");
+		return i;
+	}, 10);
+	for (int i = 0; i < 50; ++i)
+		batches.add(i);
+
+	std::vector<int> results;
+	EXPECT_THROW(batches.finish([&](int i) { results.push_back(i); }), std::runtime_error);
+	EXPECT_EQ(20u, results.size());
+}
+
+TEST(lagi_parallel_batches, destroyed_with_outstanding_batches) {
+	for (int i = 0; i < 10; ++i) {
+		agi::parallel_batches<std::string, std::string> batches([](std::string& s) { return s + s; }, 2);
+		for (int j = 0; j < 100; ++j)
+			batches.add(std::to_string(j));
+	}
+}
+
+TEST(lagi_parallel_batches, destructor_waits_for_batches) {
+	std::atomic<int> done(0);
+	{
+		agi::parallel_batches<int, int> batches([&](int& i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			++done;
+			return i;
+		}, 1);
+		for (int i = 0; i < 20; ++i)
+			batches.add(i);
+
+		// Leave finish() after the first result with the rest still running
+		EXPECT_THROW(batches.finish([](int) { throw std::runtime_error("sink failed"); }), std::runtime_error);
+	}
+	EXPECT_EQ(20, done);
+}
+
+TEST(lagi_parallel_batches, loaded_events_match_serial) {
+	auto script = synthetic_script(1234);
+
+	auto serial = load_serial(script);
+	auto parallel = load_parallel(script);
+
+	ASSERT_EQ(1234u, serial.size());
+	ASSERT_EQ(serial.size(), parallel.size());
+	for (size_t i = 0; i < serial.size(); ++i) {
+		ASSERT_EQ(serial[i].comment, parallel[i].comment);
+		ASSERT_EQ(serial[i].start, parallel[i].start);
+		ASSERT_EQ(serial[i].end, parallel[i].end);
+	}
+	EXPECT_EQ(1233000, (int)parallel.back().start);
+	EXPECT_EQ(1235500, (int)parallel.back().end);
+}
+
+// AssParser is in src/, which these tests don't link, so this drives
+// parallel_batches the same way AssParser does: one heap allocated result
+// per line in batches of 2000, released into the file by the sink in
+// Finish(), with a malformed line's parse error rethrown from there
+TEST(lagi_parallel_batches, parser_finish_order_and_rethrow) {
+	auto script = synthetic_script(10000);
+	auto make_batches = [] {
+		return agi::make_unique<agi::parallel_batches<std::string, std::unique_ptr<event>>>(
+			[](std::string& line) { return agi::make_unique<event>(parse_event(line)); }, 2000);
+	};
+
+	std::vector<event> file;
+	auto add_to_file = [&](std::unique_ptr<event> line) { file.push_back(*line); };
+
+	auto batches = make_batches();
+	read_events(script, [&](std::string const& line) { batches->add(line); });
+	batches->finish(add_to_file);
+	ASSERT_EQ(10000u, file.size());
+	for (size_t i = 0; i < file.size(); ++i) {
+		ASSERT_EQ(i % 10 == 0, file[i].comment);
+		ASSERT_EQ((int)i * 1000, (int)file[i].start);
+	}
+
+	// Truncate line 7000, which is in the fourth batch
+	file.clear();
+	batches = make_batches();
+	size_t index = 0;
+	read_events(script, [&](std::string const& line) {
+		batches->add(index++ == 7000 ? "Dialogue: 0,0:01:56.40" : line);
+	});
+	try {
+		batches->finish(add_to_file);
+		FAIL() << "finish() did not rethrow the parse error";
+	}
+	catch (ParseError const& e) {
+		EXPECT_EQ("Failed parsing line: Dialogue: 0,0:01:56.40", e.GetMessage());
+	}
+
+	// The batches before the one with the bad line were all delivered in order
+	ASSERT_EQ(6000u, file.size());
+	for (size_t i = 0; i < file.size(); ++i)
+		ASSERT_EQ((int)i * 1000, (int)file[i].start);
+}
+
+TEST(lagi_parallel_batches, DISABLED_load_benchmark) {
+	for (size_t lines : {10000, 100000, 1000000}) {
+		auto script = synthetic_script(lines);
+
+		auto start = std::chrono::steady_clock::now();
+		auto serial = load_serial(script);
+		std::chrono::duration<double, std::milli> serial_time = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		auto parallel = load_parallel(script);
+		std::chrono::duration<double, std::milli> parallel_time = std::chrono::steady_clock::now() - start;
+
+		ASSERT_EQ(serial.size(), parallel.size());
+		std::cout << "[          ] " << lines << " lines: serial " << (size_t)serial_time.count()
+			<< " ms, parallel " << (size_t)parallel_time.count() << " ms" << std::endl;
+	}
+}
@@ -17,8 +17,16 @@
 #include <main.h>
 #include <util.h>
 
+#include <libaegisub/ass/time.h>
 #include <libaegisub/split.h>
 
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
 TEST(lagi_split, delim_not_present) {
 	std::string str("hello");
 	for (auto tok : agi::Split(str, ','))
@@ -45,3 +53,128 @@ TEST(lagi_split, does_not_copy_input) {
 	EXPECT_EQ(str.end(), end(*std::next(rng)));
 }
 
+TEST(lagi_split, char_pointer_range) {
+	const char *str = "a, b,c";
+	std::string expected[] = {"a", " b", "c"};
+	size_t i = 0;
+	for (auto tok : agi::Split(boost::make_iterator_range(str, str + 6), ','))
+		EXPECT_EQ(expected[i++], std::string(tok.begin(), tok.end()));
+	EXPECT_EQ(3u, i);
+}
+
+TEST(lagi_split, trim) {
+	std::string str(" \t a b \r\n");
+	auto trimmed = agi::Trim(agi::StringRange(str.begin(), str.end()));
+	EXPECT_EQ("a b", agi::str(trimmed));
+	EXPECT_EQ(str.begin() + 3, trimmed.begin());
+
+	str = "   ";
+	EXPECT_TRUE(agi::Trim(agi::StringRange(str.begin(), str.end())).empty());
+
+	str = "";
+	EXPECT_TRUE(agi::Trim(agi::StringRange(str.begin(), str.end())).empty());
+}
+
+TEST(lagi_split, dialogue_fields) {
+	// Split the fields of a line the way AssDialogue::Parse does
+	std::string line = "Dialogue: 2,0:01:02.03,0:01:05.00, Default ,Someone,0,10,20,,{\\pos(1,2)}Text, with commas";
+	auto str = boost::make_iterator_range(line.data() + 10, line.data() + line.size());
+	auto pos = agi::Split(str, ',');
+	auto next = [&] { auto tok = agi::Trim(*pos++); return std::string(tok.begin(), tok.end()); };
+
+	EXPECT_EQ("2", next());
+	auto start = agi::Trim(*pos++);
+	EXPECT_EQ(62030, (int)agi::Time(start.begin(), start.end()));
+	auto end = agi::Trim(*pos++);
+	EXPECT_EQ(65000, (int)agi::Time(end.begin(), end.end()));
+	EXPECT_EQ("Default", next());
+	EXPECT_EQ("Someone", next());
+	EXPECT_EQ("0", next());
+	EXPECT_EQ("10", next());
+	EXPECT_EQ("20", next());
+	EXPECT_EQ("", next());
+	EXPECT_EQ("{\\pos(1,2)}Text, with commas", std::string((*pos).begin(), str.end()));
+}
+
+namespace {
+struct dialogue_fields {
+	int layer;
+	agi::Time start, end;
+	std::string style, actor, effect, text;
+	int margin[3];
+};
+
+/// Parse the fields of a dialogue line the way AssDialogue used to, copying
+/// each field into a string
+void parse_with_copies(std::string const& line, dialogue_fields& out) {
+	auto str = agi::StringRange(line.begin() + 10, line.end());
+	auto pos = agi::Split(str, ',');
+	auto next_str = [&] { return agi::str(*pos++); };
+	auto next_str_trim = [&] { return agi::str(boost::trim_copy(*pos++)); };
+
+	out.layer = boost::lexical_cast<int>(next_str_trim());
+	out.start = next_str_trim();
+	out.end = next_str_trim();
+	out.style = next_str_trim();
+	out.actor = next_str_trim();
+	for (int& margin : out.margin)
+		margin = boost::lexical_cast<int>(next_str());
+	out.effect = next_str_trim();
+	out.text.assign((*pos).begin(), str.end());
+}
+
+/// Parse the fields of a dialogue line the way AssDialogue does now, only
+/// copying the string fields once they've all been found
+void parse_in_place(std::string const& line, dialogue_fields& out) {
+	auto str = boost::make_iterator_range(line.data() + 10, line.data() + line.size());
+	auto pos = agi::Split(str, ',');
+
+	auto layer = agi::Trim(*pos++);
+	out.layer = boost::lexical_cast<int>(layer.begin(), layer.size());
+	auto start = agi::Trim(*pos++);
+	out.start = agi::Time(start.begin(), start.end());
+	auto end = agi::Trim(*pos++);
+	out.end = agi::Time(end.begin(), end.end());
+	auto style = agi::Trim(*pos++);
+	auto actor = agi::Trim(*pos++);
+	for (int& margin : out.margin) {
+		auto tok = *pos++;
+		margin = boost::lexical_cast<int>(tok.begin(), tok.size());
+	}
+	auto effect = agi::Trim(*pos++);
+	auto text = (*pos).begin();
+
+	out.style.assign(style.begin(), style.end());
+	out.actor.assign(actor.begin(), actor.end());
+	out.effect.assign(effect.begin(), effect.end());
+	out.text.assign(text, str.end());
+}
+}
+
+TEST(lagi_split, DISABLED_dialogue_fields_benchmark) {
+	std::vector<std::string> lines;
+	for (int i = 0; i < 1000; ++i)
+		lines.push_back("Dialogue: 0," + agi::Time(i * 1000).GetAssFormatted() + "," + agi::Time(i * 1000 + 2500).GetAssFormatted()
+			+ ",Default Style,Character Name,0,0,0,,{\\k20}ka{\\k30}ra{\\k25}o{\\k40}ke line " + std::to_string(i));
+
+	dialogue_fields a, b;
+	parse_with_copies(lines.back(), a);
+	parse_in_place(lines.back(), b);
+	ASSERT_EQ(a.end, b.end);
+	ASSERT_EQ(a.actor, b.actor);
+	ASSERT_EQ(a.text, b.text);
+
+	auto time = [&](void (*parse)(std::string const&, dialogue_fields&)) {
+		dialogue_fields out;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 200; ++i) {
+			for (auto const& line : lines)
+				parse(line, out);
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return (size_t)(elapsed.count() / (200 * lines.size()));
+	};
+
+	std::cout << "[          ] copying fields: " << time(parse_with_copies) << " ns/line" << std::endl;
+	std::cout << "[          ] in place: " << time(parse_in_place) << " ns/line" << std::endl;
+}
@@ -78,3 +78,10 @@ TEST(lagi_time, smpte_parse_invalid) {
 TEST(lagi_time, to_smpte) {
 	EXPECT_STREQ("01:23:45:11", agi::SmpteFormatter(25).ToSMPTE(Time("1:23:45.44")).c_str());
 }
+
+TEST(lagi_time, parse_from_range) {
+	const char *line = "0,1:23:45.67,0:00:01.00,Default";
+	EXPECT_STREQ("1:23:45.67", Time(line + 2, line + 12).GetAssFormatted().c_str());
+	EXPECT_STREQ("0:00:01.00", Time(line + 13, line + 23).GetAssFormatted().c_str());
+	EXPECT_EQ(0, (int)Time(line, line));
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/timing_processor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace agi::ass;
+
+namespace {
+struct line {
+	int Start;
+	int End;
+
+	bool CollidesWith(const line *target) const {
+		return ((Start < target->Start) ? (target->Start < End) : (Start < target->End));
+	}
+};
+
+typedef std::vector<line> script;
+
+std::vector<line *> pointers(script& lines) {
+	std::vector<line *> ret;
+	ret.reserve(lines.size());
+	for (auto& l : lines)
+		ret.push_back(&l);
+	return ret;
+}
+
+/// Lines sorted by start, with lots of overlaps, touching lines, shared
+/// start times and small gaps
+script random_script(std::mt19937& rng, size_t count) {
+	std::uniform_int_distribution<int> step(0, 4);
+	std::uniform_int_distribution<int> duration(1, 12);
+	script lines;
+	lines.reserve(count);
+	int start = 0;
+	for (size_t i = 0; i < count; ++i) {
+		start += step(rng) * 100;
+		lines.push_back(line{start, start + duration(rng) * 100});
+	}
+	return lines;
+}
+
+/// The lead-in/out which was done before it was swept
+template<class Iter>
+int safe_time_old(Iter begin, Iter end, line *comp, int initial, int line::*field, int const& (*cmp)(int const&, int const&)) {
+	for (; begin != end; ++begin) {
+		if (!comp->CollidesWith(*begin))
+			initial = cmp(initial, (*begin)->*field);
+	}
+	return initial;
+}
+
+void lead_in_old(std::vector<line *>& sorted, int lead_in) {
+	for (size_t i = 0; i < sorted.size(); ++i)
+		sorted[i]->Start = safe_time_old(sorted.rend() - i, sorted.rend(),
+			sorted[i], sorted[i]->Start - lead_in, &line::End, &std::max<int>);
+}
+
+void lead_out_old(std::vector<line *>& sorted, int lead_out) {
+	for (size_t i = 0; i < sorted.size(); ++i)
+		sorted[i]->End = safe_time_old(sorted.begin() + i + 1, sorted.end(),
+			sorted[i], sorted[i]->End + lead_out, &line::Start, &std::min<int>);
+}
+
+void process_old(script& lines, int lead_in, int lead_out) {
+	auto sorted = pointers(lines);
+	if (lead_in) lead_in_old(sorted, lead_in);
+	if (lead_out) lead_out_old(sorted, lead_out);
+	MakeAdjacent(sorted, 500, 300, 0.5);
+}
+
+void process_new(script& lines, int lead_in, int lead_out) {
+	auto sorted = pointers(lines);
+	if (lead_in) AddLeadIn(sorted, lead_in);
+	if (lead_out) AddLeadOut(sorted, lead_out);
+	MakeAdjacent(sorted, 500, 300, 0.5);
+}
+}
+
+TEST(lagi_timing_processor, lead_in) {
+	script lines{{1000, 2000}, {2300, 3000}, {2500, 4000}, {5000, 6000}};
+	AddLeadIn(pointers(lines), 500);
+	EXPECT_EQ(500, lines[0].Start);
+	// Stops at the end of the previous line
+	EXPECT_EQ(2000, lines[1].Start);
+	// Already overlaps the previous line, so only stops at the one before it
+	EXPECT_EQ(2000, lines[2].Start);
+	EXPECT_EQ(4500, lines[3].Start);
+	EXPECT_EQ(4000, lines[2].End);
+}
+
+TEST(lagi_timing_processor, lead_out) {
+	script lines{{1000, 2000}, {1500, 2200}, {2300, 3000}, {5000, 6000}};
+	AddLeadOut(pointers(lines), 500);
+	// Overlaps the second line, so it stops at the third
+	EXPECT_EQ(2300, lines[0].End);
+	EXPECT_EQ(2300, lines[1].End);
+	EXPECT_EQ(3500, lines[2].End);
+	EXPECT_EQ(6500, lines[3].End);
+}
+
+TEST(lagi_timing_processor, lead_out_empty_line_at_same_start) {
+	// The old implementation cut the first line down to nothing here
+	script lines{{1000, 2000}, {1000, 1000}, {2100, 3000}};
+	AddLeadOut(pointers(lines), 500);
+	EXPECT_EQ(2100, lines[0].End);
+	EXPECT_EQ(1500, lines[1].End);
+}
+
+TEST(lagi_timing_processor, make_adjacent) {
+	script lines{{0, 1000}, {1200, 2000}, {1900, 3000}, {4000, 5000}};
+	MakeAdjacent(pointers(lines), 500, 300, 0.5);
+	EXPECT_EQ(1100, lines[0].End);
+	EXPECT_EQ(1100, lines[1].Start);
+	EXPECT_EQ(1950, lines[1].End);
+	EXPECT_EQ(1950, lines[2].Start);
+	// Gap is too large
+	EXPECT_EQ(3000, lines[2].End);
+	EXPECT_EQ(4000, lines[3].Start);
+}
+
+TEST(lagi_timing_processor, matches_old_implementation) {
+	std::mt19937 rng(25);
+	for (int i = 0; i < 300; ++i) {
+		auto original = random_script(rng, 1 + i % 60);
+		int lead_in = (i % 3) * 250;
+		int lead_out = (i / 3 % 3) * 250;
+
+		auto old_lines = original;
+		auto new_lines = original;
+		process_old(old_lines, lead_in, lead_out);
+		process_new(new_lines, lead_in, lead_out);
+		for (size_t j = 0; j < original.size(); ++j) {
+			ASSERT_EQ(old_lines[j].Start, new_lines[j].Start) << i << " " << j;
+			ASSERT_EQ(old_lines[j].End, new_lines[j].End) << i << " " << j;
+		}
+	}
+}
+
+TEST(lagi_timing_processor, DISABLED_benchmark) {
+	std::mt19937 rng(5);
+	for (size_t count : {1000, 10000, 20000}) {
+		auto original = random_script(rng, count);
+
+		auto old_lines = original;
+		auto start = std::chrono::steady_clock::now();
+		process_old(old_lines, 300, 300);
+		std::chrono::duration<double, std::milli> old_time = std::chrono::steady_clock::now() - start;
+
+		auto new_lines = original;
+		start = std::chrono::steady_clock::now();
+		process_new(new_lines, 300, 300);
+		std::chrono::duration<double, std::milli> new_time = std::chrono::steady_clock::now() - start;
+
+		for (size_t j = 0; j < count; ++j) {
+			ASSERT_EQ(old_lines[j].Start, new_lines[j].Start);
+			ASSERT_EQ(old_lines[j].End, new_lines[j].End);
+		}
+		std::cout << "[          ] " << count << " lines: old " << (size_t)old_time.count()
+			<< " ms, new " << (size_t)new_time.count() << " ms" << std::endl;
+	}
+
+	auto lines = random_script(rng, 1000000);
+	auto start = std::chrono::steady_clock::now();
+	process_new(lines, 300, 300);
+	std::chrono::duration<double, std::milli> new_time = std::chrono::steady_clock::now() - start;
+	std::cout << "[          ] 1000000 lines: new " << (size_t)new_time.count() << " ms" << std::endl;
+}
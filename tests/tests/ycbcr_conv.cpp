@@ -0,0 +1,158 @@
+// Copyright (c) 2026, agent <agent@local>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+#include <util.h>
+
+#include <libaegisub/ycbcr_conv.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace agi;
+
+using ::util::random_bytes;
+using ::util::supported_instruction_sets;
+
+namespace {
+/// Planar 4:2:0 frame
+struct Frame {
+	int width, height;
+	std::vector<uint8_t> y, cb, cr;
+
+	Frame(int width, int height)
+	: width(width)
+	, height(height)
+	, y(random_bytes(width * height, 1))
+	, cb(random_bytes(width * height / 4, 2))
+	, cr(random_bytes(width * height / 4, 3))
+	{
+	}
+};
+}
+
+TEST(lagi_ycbcr, row_converter_matches_converter) {
+	const int width = 77;
+	auto y = random_bytes(width, 4), cb = random_bytes(width, 5), cr = random_bytes(width, 6);
+	std::vector<uint8_t> bgra(width * 4);
+
+	for (auto mat : {ycbcr_matrix::bt601, ycbcr_matrix::bt709, ycbcr_matrix::fcc, ycbcr_matrix::smpte_240m}) {
+		for (auto range : {ycbcr_range::tv, ycbcr_range::pc}) {
+			ycbcr_converter conv(mat, range);
+			for (auto isa : supported_instruction_sets()) {
+				ycbcr_row_converter row_conv(conv, isa);
+				ASSERT_EQ(isa, row_conv.get_instruction_set());
+
+				for (int shift = 0; shift <= 2; ++shift) {
+					row_conv.convert(&y[0], &cb[0], &cr[0], shift, width, &bgra[0]);
+					for (int x = 0; x < width; ++x) {
+						auto rgb = conv.ycbcr_to_rgb({{y[x], cb[x >> shift], cr[x >> shift]}});
+						ASSERT_NEAR(rgb[2], bgra[x * 4], 1) << (int)isa << " " << shift << " " << x;
+						ASSERT_NEAR(rgb[1], bgra[x * 4 + 1], 1) << (int)isa << " " << shift << " " << x;
+						ASSERT_NEAR(rgb[0], bgra[x * 4 + 2], 1) << (int)isa << " " << shift << " " << x;
+						ASSERT_EQ(0, bgra[x * 4 + 3]);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(lagi_ycbcr, row_converter_instruction_sets_agree) {
+	const int width = 1000;
+	auto y = random_bytes(width, 7), cb = random_bytes(width, 8), cr = random_bytes(width, 9);
+	ycbcr_converter conv(ycbcr_matrix::bt709, ycbcr_range::tv);
+
+	for (int shift = 0; shift <= 2; ++shift) {
+		std::vector<uint8_t> expected(width * 4);
+		ycbcr_row_converter(conv, InstructionSet::Scalar).convert(&y[0], &cb[0], &cr[0], shift, width, &expected[0]);
+
+		for (auto isa : supported_instruction_sets()) {
+			// Every width up to a few vectors, to cover all the tail lengths
+			for (int w = 1; w <= 40; ++w) {
+				std::vector<uint8_t> actual(w * 4 + 1, 0xAB);
+				ycbcr_row_converter(conv, isa).convert(&y[0], &cb[0], &cr[0], shift, w, &actual[0]);
+				ASSERT_TRUE(std::equal(actual.begin(), actual.end() - 1, expected.begin())) << (int)isa << " " << shift << " " << w;
+				ASSERT_EQ(0xAB, actual.back());
+			}
+		}
+	}
+}
+
+TEST(lagi_ycbcr, row_converter_extremes) {
+	ycbcr_converter conv(ycbcr_matrix::bt601, ycbcr_range::tv);
+	const uint8_t values[] = {0, 16, 128, 235, 240, 255};
+
+	std::vector<uint8_t> y, cb, cr;
+	for (auto yv : values) for (auto cbv : values) for (auto crv : values) {
+		y.push_back(yv);
+		cb.push_back(cbv);
+		cr.push_back(crv);
+	}
+
+	for (auto isa : supported_instruction_sets()) {
+		std::vector<uint8_t> bgra(y.size() * 4);
+		ycbcr_row_converter(conv, isa).convert(&y[0], &cb[0], &cr[0], 0, y.size(), &bgra[0]);
+		for (size_t x = 0; x < y.size(); ++x) {
+			auto rgb = conv.ycbcr_to_rgb({{y[x], cb[x], cr[x]}});
+			ASSERT_NEAR(rgb[2], bgra[x * 4], 1);
+			ASSERT_NEAR(rgb[1], bgra[x * 4 + 1], 1);
+			ASSERT_NEAR(rgb[0], bgra[x * 4 + 2], 1);
+		}
+	}
+}
+
+// Frames per second for the floating point converter and each row converter
+TEST(lagi_ycbcr, DISABLED_yuv420_benchmark) {
+	Frame frame(1920, 1080);
+	std::vector<uint8_t> bgra(frame.width * frame.height * 4);
+	ycbcr_converter conv(ycbcr_matrix::bt601, ycbcr_range::tv);
+
+	auto report = [&](const char *name, int frames, std::chrono::steady_clock::time_point start) {
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "[          ] 1080p 4:2:0, " << name << ": " << frames / elapsed.count() << " frames/s" << std::endl;
+	};
+
+	// The previous per-pixel floating point conversion
+	auto start = std::chrono::steady_clock::now();
+	for (int py = 0; py < frame.height; ++py) {
+		uint8_t *dst = &bgra[py * frame.width * 4];
+		for (int px = 0; px < frame.width; ++px) {
+			size_t c = (py / 2) * (frame.width / 2) + px / 2;
+			auto rgb = conv.ycbcr_to_rgb({{frame.y[py * frame.width + px], frame.cb[c], frame.cr[c]}});
+			*dst++ = rgb[2];
+			*dst++ = rgb[1];
+			*dst++ = rgb[0];
+			*dst++ = 0;
+		}
+	}
+	report("floating point", 1, start);
+
+	for (auto isa : supported_instruction_sets()) {
+		ycbcr_row_converter row_conv(conv, isa);
+		const int frames = 10;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < frames; ++i) {
+			for (int py = 0; py < frame.height; ++py) {
+				size_t c = (py / 2) * (frame.width / 2);
+				row_conv.convert(&frame.y[py * frame.width], &frame.cb[c], &frame.cr[c], 1, frame.width, &bgra[py * frame.width * 4]);
+			}
+		}
+		report(::util::instruction_set_name(isa), frames, start);
+	}
+}